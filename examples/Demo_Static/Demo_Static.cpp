@@ -181,6 +181,9 @@ int main() {
     params.DetailSampleDist = 6.0f;
     params.DetailSampleMaxError = 1.0f;
 
+	// Tag the jumpable cliffs (material "cliff_jump", texture can_jump.png)
+    navMesh->setMaterialArea("can_jump", PolyAreas::JUMP);
+
 	// c. Build the navmesh from your mesh node and NavMeshParams parameters.
     bool success = navMesh->build(mapNode, params);
 
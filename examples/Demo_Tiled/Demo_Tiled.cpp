@@ -183,6 +183,9 @@ int main() {
     params.DetailSampleMaxError = 1.0f;
     params.KeepInterResults = true; // Required for debug visualization
 
+    // Tag the jumpable cliffs (material "cliff_jump", texture can_jump.png)
+    navMesh->setMaterialArea("can_jump", PolyAreas::JUMP);
+
     // c. Define tile size (in cells)
     const int tileSize = 32;
 
@@ -194,6 +197,15 @@ int main() {
         return 1;
     }
 
+    // Where did the build time go?
+    const NavMeshBuildReport& report = navMesh->getBuildReport();
+    printf("Build: %.1f ms total, %d tiles, %d polys, %.1f KB peak intermediate memory\n",
+        report.TotalMs, report.TileCount, report.PolyCount, report.PeakMemoryBytes / 1024.0f);
+    printf("  rasterize %.1f, filter %.1f, compact %.1f, erode %.1f, regions %.1f ms\n",
+        report.RasterizeMs, report.FilterMs, report.CompactMs, report.ErodeMs, report.RegionsMs);
+    printf("  contours %.1f, polymesh %.1f, detail %.1f ms (summed over tiles)\n",
+        report.ContoursMs, report.PolyMeshMs, report.DetailMeshMs);
+
     /*=========================================================
     2.a RENDER NAVMESH (OPTIONAL DEBUG VISUALIZATION)
     =========================================================*/
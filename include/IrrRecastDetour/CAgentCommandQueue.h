@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <irrlicht.h>
+#include <ISceneNode.h>
+#include "DetourCrowd.h"
+
+/**
+ * @struct AgentCommand
+ * @brief A deferred agent call (add, remove or new target).
+ */
+struct AgentCommand
+{
+    enum Type { ADD, REMOVE, MOVE_TARGET, FLOW_TARGET };
+
+    Type Kind = MOVE_TARGET;
+    // The agent; for ADD, the id reserved during a threaded crowd step (unused otherwise)
+    int AgentId = -1;
+    // Target, or for a reserved ADD the feet position
+    irr::core::vector3df Pos;
+    // --- ADD only ---
+    dtCrowdAgentParams Params = {};
+    irr::scene::ISceneNode* Node = nullptr;
+    // Called on the main thread with the new agent id, -1 on failure
+    std::function<void(int)> OnAdded;
+};
+
+/**
+ * @class CAgentCommandQueue
+ * @brief Bounded lock-free ring of agent commands: many producers, one consumer.
+ *
+ * Any thread may push(); only the thread that owns the INavMesh pops. A full
+ * ring rejects the push instead of waiting, so a producer never blocks.
+ * Commands are popped in the order their pushes claimed a slot, which keeps
+ * the calls of one thread (and so of one agent) in order.
+ *
+ * Each slot carries a sequence number (the bounded queue of D. Vyukov): a
+ * producer claims a slot with one compare-and-swap on the write position,
+ * fills it and publishes it by advancing the slot's sequence.
+ */
+class CAgentCommandQueue
+{
+public:
+    /**
+     * @param capacity Slots in the ring, rounded up to a power of two.
+     */
+    explicit CAgentCommandQueue(size_t capacity = 4096);
+
+    // Disable copy
+    CAgentCommandQueue(const CAgentCommandQueue&) = delete;
+    CAgentCommandQueue& operator=(const CAgentCommandQueue&) = delete;
+
+    /**
+     * @brief Adds a command. Thread-safe and lock-free.
+     * @return false if the ring is full (the command is dropped).
+     */
+    bool push(AgentCommand&& command);
+
+    /**
+     * @brief Takes the oldest command. Consumer thread only.
+     * @return false if the ring is empty, or the oldest slot is still being filled.
+     */
+    bool pop(AgentCommand& command);
+
+    size_t getCapacity() const { return _mask + 1; }
+
+    /**
+     * @brief Gets the number of commands rejected because the ring was full.
+     */
+    size_t getDropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> Sequence;
+        AgentCommand Command;
+    };
+
+    std::unique_ptr<Cell[]> _cells;
+    size_t _mask = 0;
+
+    // Producers and the consumer write different cache lines
+    alignas(64) std::atomic<size_t> _enqueuePos;
+    alignas(64) size_t _dequeuePos = 0;
+    std::atomic<size_t> _dropped;
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <vector>
+#include <irrlicht.h>
+#include <ISceneNode.h>
+#include "DetourCrowd.h"
+
+class CShardedCrowd;
+
+/**
+ * @struct AgentState
+ * @brief Copy of the crowd state of one agent, published after a crowd step.
+ * Lets the main thread read agents while the next step runs on a worker thread.
+ */
+struct AgentState
+{
+    bool Active = false;
+    bool HasPrevious = false;   // PrevPos holds the previous simulation step
+    bool HasTarget = false;
+    bool Reached = false;
+    float Pos[3];               // Feet position
+    float PrevPos[3];
+    float Vel[3];
+    float Target[3];
+    int CornerCount = 0;
+    float Corners[DT_CROWDAGENT_MAX_CORNERS * 3];
+};
+
+/**
+ * @class CAgentTable
+ * @brief Dense table binding crowd agents to the scene nodes they move.
+ *
+ * The bindings are stored as parallel arrays (agent id, node, height offset,
+ * last written position, flags), packed at the front so a per-frame sync
+ * walks them linearly. A lookup array indexed by agent id gives O(1) add,
+ * find and remove; removal moves the last row into the freed slot.
+ *
+ * syncPositions() only calls ISceneNode::setPosition() for agents that moved
+ * more than the move epsilon since their last write. A node moved by other
+ * code keeps its position until its agent moves again.
+ *
+ * With a fixed simulation step, savePreviousPositions() is called before each
+ * crowd update, and syncPositions() places the nodes between the previous and
+ * the current simulation state. With a threaded crowd, the nodes are synced
+ * from the AgentState copies published after each step instead.
+ */
+class CAgentTable
+{
+public:
+    CAgentTable() {}
+
+    // Disable copy
+    CAgentTable(const CAgentTable&) = delete;
+    CAgentTable& operator=(const CAgentTable&) = delete;
+
+    /**
+     * @brief Binds a node to an agent. The node's first sync always writes its position.
+     * @param heightOffset Added to the agent's feet position (Y) to get the node position.
+     * @return false if the agent id is negative or already bound.
+     */
+    bool add(int agentId, irr::scene::ISceneNode* node, float heightOffset);
+
+    /**
+     * @brief Unbinds an agent.
+     * @return false if the agent was not bound.
+     */
+    bool remove(int agentId);
+
+    /**
+     * @brief Unbinds every agent.
+     */
+    void clear();
+
+    bool contains(int agentId) const { return _getIndex(agentId) >= 0; }
+
+    /**
+     * @brief Gets the lowest unbound agent id, the one CShardedCrowd::addAgent() hands
+     * out next while the table mirrors the crowd.
+     */
+    int getFirstFreeId() const;
+
+    /**
+     * @brief Gets the node bound to an agent, or nullptr.
+     */
+    irr::scene::ISceneNode* getNode(int agentId) const;
+
+    // --- Dense Access (0 <= index < size(), order changes on remove()) ---
+    int size() const { return (int)_agentIds.size(); }
+    int getAgentId(int index) const { return _agentIds[index]; }
+    irr::scene::ISceneNode* getNodeAt(int index) const { return _nodes[index]; }
+
+    /**
+     * @brief Remembers the current position of every agent as its previous
+     * simulation state. Call before each crowd update.
+     */
+    void savePreviousPositions(CShardedCrowd* crowd);
+
+    /**
+     * @brief Copies the position of every moved agent to its node.
+     * @param alpha Interpolation from the previous simulation state (0) to the
+     * current one (1). Agents without a previous state use the current one.
+     * @return The number of nodes written.
+     */
+    int syncPositions(CShardedCrowd* crowd, float alpha = 1.0f);
+
+    /**
+     * @brief Copies the position of every moved agent to its node, from published states.
+     * @param states Agent states indexed by agent id.
+     * @param stateCount Number of states.
+     * @param alpha See syncPositions(CShardedCrowd*, float).
+     * @return The number of nodes written.
+     */
+    int syncPositions(const AgentState* states, int stateCount, float alpha = 1.0f);
+
+    /**
+     * @brief Sets how far an agent must move before its node is written again.
+     */
+    void setMoveEpsilon(float epsilon) { _moveEpsilonSqr = epsilon * epsilon; }
+
+private:
+    enum Flags : unsigned char
+    {
+        SYNCED = 0x01,      // _lastPositions holds the last written position
+        HAS_PREVIOUS = 0x02 // _prevPositions holds the previous simulation state
+    };
+
+    // Dense index per agent id, -1 if unbound
+    std::vector<int> _indices;
+
+    // --- Dense Rows ---
+    std::vector<int> _agentIds;
+    std::vector<irr::scene::ISceneNode*> _nodes;
+    std::vector<float> _heightOffsets;
+    std::vector<irr::core::vector3df> _lastPositions;
+    std::vector<irr::core::vector3df> _prevPositions;
+    std::vector<unsigned char> _flags;
+
+    float _moveEpsilonSqr = 0.001f * 0.001f;
+
+    /**
+     * @brief Gets the node position of an agent (its feet plus the height offset).
+     */
+    irr::core::vector3df _getNodePos(const dtCrowdAgent* agent, int index) const
+    {
+        return irr::core::vector3df(agent->npos[0], agent->npos[1] + _heightOffsets[index], agent->npos[2]);
+    }
+
+    /**
+     * @brief Writes a node position unless it is within the move epsilon of the last write.
+     * @return true if the node was written.
+     */
+    bool _writeNode(int index, const irr::core::vector3df& nodePos);
+
+    int _getIndex(int agentId) const
+    {
+        return agentId >= 0 && agentId < (int)_indices.size() ? _indices[agentId] : -1;
+    }
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <unordered_map>
+#include <irrlicht.h>
+#include "DetourNavMesh.h"
+
+class CNavQueryContext;
+
+/**
+ * @class CFlowField
+ * @brief Next polygon and cost-to-go towards one goal, for every polygon that can reach it.
+ *
+ * The field is built with a single backward Dijkstra search from the goal
+ * polygon. Any number of agents heading to that goal then just follow the
+ * next-polygon links, instead of each searching its own path.
+ *
+ * Costs use the query context's filter, measured between portal midpoints
+ * like dtNavMeshQuery::findPath(). The search walks links backwards and only
+ * uses those Detour also links the other way, so one-way off-mesh
+ * connections are left out of the field.
+ *
+ * INavMesh caches one field per goal polygon, see INavMesh::setAgentFlowTarget().
+ * A field holds polygon refs, so it must be rebuilt when tiles change.
+ */
+class CFlowField
+{
+public:
+    CFlowField() {}
+
+    // Disable copy
+    CFlowField(const CFlowField&) = delete;
+    CFlowField& operator=(const CFlowField&) = delete;
+
+    /**
+     * @brief Builds the field towards a goal.
+     * @param query The context whose navmesh and filter are used.
+     * @param goalPos The goal, snapped to the nearest polygon.
+     * @param maxCost Polygons further than this cost from the goal are left out, 0 = no limit.
+     * @return false if the goal is off the navmesh (the field is then empty).
+     */
+    bool build(CNavQueryContext& query, const irr::core::vector3df& goalPos, const float maxCost = 0.0f);
+
+    /**
+     * @brief Checks whether the field was built successfully.
+     */
+    bool isValid() const { return _goalRef != 0; }
+
+    dtPolyRef getGoalRef() const { return _goalRef; }
+    const irr::core::vector3df& getGoalPos() const { return _goalPos; }
+
+    /**
+     * @brief Gets the number of polygons that reach the goal.
+     */
+    int getPolyCount() const { return (int)_cells.size(); }
+
+    /**
+     * @brief Checks whether the goal can be reached from a polygon.
+     */
+    bool contains(dtPolyRef ref) const { return _cells.find(ref) != _cells.end(); }
+
+    /**
+     * @brief Gets the polygon to move to from ref.
+     * @return The next polygon, or 0 at the goal or if the goal is not reachable.
+     */
+    dtPolyRef getNextPoly(dtPolyRef ref) const;
+
+    /**
+     * @brief Gets the search cost from ref to the goal.
+     * @return The cost, or -1.0f if the goal is not reachable.
+     */
+    float getCostToGo(dtPolyRef ref) const;
+
+    /**
+     * @brief Follows the field from a polygon, e.g. to straighten the next few steps.
+     * @param startRef The polygon to start at (written first).
+     * @param polys Receives the corridor.
+     * @param maxPolys Capacity of polys.
+     * @return The number of polygons written, 0 if the goal is not reachable from startRef.
+     */
+    int getCorridor(dtPolyRef startRef, dtPolyRef* polys, const int maxPolys) const;
+
+private:
+    struct Cell
+    {
+        dtPolyRef Next = 0;
+        float Cost = 0.0f;
+    };
+
+    std::unordered_map<dtPolyRef, Cell> _cells;
+    dtPolyRef _goalRef = 0;
+    irr::core::vector3df _goalPos;
+};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @class CMappedFile
+ * @brief A read-only file mapped copy-on-write into memory (mmap / MapViewOfFile).
+ *
+ * Pages are shared with the OS page cache, and with every other process mapping
+ * the same file, until this process writes to them. Writes are private to this
+ * process and never reach the file.
+ *
+ * The mapping is released when the object is destroyed.
+ */
+class CMappedFile
+{
+public:
+    CMappedFile() {}
+    ~CMappedFile();
+
+    // Disable copy
+    CMappedFile(const CMappedFile&) = delete;
+    CMappedFile& operator=(const CMappedFile&) = delete;
+
+    /**
+     * @brief Maps a whole file. Any previous mapping is released first.
+     * @param path The file to map.
+     * @return true on success.
+     */
+    bool open(const char* path);
+
+    /**
+     * @brief Releases the mapping.
+     */
+    void close();
+
+    unsigned char* data() const { return _data; }
+    size_t size() const { return _size; }
+
+private:
+    unsigned char* _data = nullptr;
+    size_t _size = 0;
+
+#ifdef _WIN32
+    void* _fileHandle = nullptr;
+    void* _mappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include "Recast.h"
+
+/**
+ * @class CNavMeshBuildContext
+ * @brief rcContext implementation with working timers and console logging.
+ *
+ * The stock rcContext only provides empty timer/log hooks, so
+ * getAccumulatedTime() always returns -1. This context measures every
+ * Recast timer label with a steady clock (in microseconds) and prints
+ * warnings and errors to stdout. Progress messages (one per stage and per
+ * tile) are only printed after setProgressLog(true).
+ *
+ * It also keeps the peak memory held by Recast intermediates, as reported
+ * by the builder through notePeakMemory().
+ *
+ * A context is not thread-safe. Parallel builds create one context per
+ * worker thread and merge the timers back with mergeTimers().
+ */
+class CNavMeshBuildContext : public rcContext
+{
+public:
+    CNavMeshBuildContext(bool logEnabled = true);
+    virtual ~CNavMeshBuildContext() {}
+
+    /**
+     * @brief Prints RC_LOG_PROGRESS messages too, not only warnings and errors.
+     */
+    void setProgressLog(bool enabled) { _progressLog = enabled; }
+    bool getProgressLog() const { return _progressLog; }
+
+    /**
+     * @brief Gets the CPU time used by the calling thread so far, in milliseconds.
+     * Unlike a steady clock, it does not advance while the thread waits or is
+     * descheduled, so it measures the work of one tile on a busy worker.
+     */
+    static double getThreadCpuTimeMs();
+
+    /**
+     * @brief Adds the accumulated timers of another context to this one.
+     * The peak memory is added as well, since worker contexts hold their
+     * intermediates at the same time.
+     * @param other The context whose timers are added (e.g. a worker context).
+     */
+    void mergeTimers(const CNavMeshBuildContext& other);
+
+    /**
+     * @brief Records the memory currently held by intermediates; the highest
+     * value is kept until the timers are reset.
+     */
+    void notePeakMemory(size_t bytes) { if (bytes > _peakMemory) _peakMemory = bytes; }
+    size_t getPeakMemory() const { return _peakMemory; }
+
+    // --- Memory held by Recast intermediates (computed from their sizes) ---
+    static size_t getMemoryUsage(const rcHeightfield& hf);
+    static size_t getMemoryUsage(const rcCompactHeightfield& chf);
+    static size_t getMemoryUsage(const rcContourSet& cset);
+    static size_t getMemoryUsage(const rcPolyMesh& pmesh);
+    static size_t getMemoryUsage(const rcPolyMeshDetail& dmesh);
+    static size_t getMemoryUsage(const rcHeightfieldLayerSet& lset);
+
+protected:
+    virtual void doResetLog() override {}
+    virtual void doLog(const rcLogCategory category, const char* msg, const int len) override;
+    virtual void doResetTimers() override;
+    virtual void doStartTimer(const rcTimerLabel label) override;
+    virtual void doStopTimer(const rcTimerLabel label) override;
+    virtual int doGetAccumulatedTime(const rcTimerLabel label) const override;
+
+private:
+    std::chrono::steady_clock::time_point _startTime[RC_MAX_TIMERS];
+    long long _accTime[RC_MAX_TIMERS]; // Microseconds, -1 = never started
+    size_t _peakMemory = 0;
+    bool _progressLog = false;
+};
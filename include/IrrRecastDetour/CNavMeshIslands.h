@@ -0,0 +1,108 @@
+#pragma once
+
+#include <vector>
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+
+/**
+ * @class CNavMeshIslands
+ * @brief Connected-component (island) label of every navmesh polygon.
+ *
+ * Polygons that a filter lets through are grouped into islands along their
+ * links, with links treated as two-way. Two polygons on different islands
+ * can never be connected by a path. Comparing their labels rejects such a
+ * query in O(1), before a search would exhaust the whole reachable area.
+ * A one-way off-mesh connection still joins its islands, so a matching
+ * label does not guarantee a path.
+ *
+ * INavMesh relabels after every build, load and tile change. The labels are
+ * read-only in between, so any thread may read them.
+ */
+class CNavMeshIslands
+{
+public:
+    CNavMeshIslands() {}
+
+    /**
+     * @brief Labels every polygon of a navmesh.
+     * @param filter Polygons the filter rejects get no island (label 0).
+     * @return The number of islands.
+     */
+    int build(const dtNavMesh* navMesh, const dtQueryFilter& filter);
+
+    /**
+     * @brief Drops all labels, and forgets the disabled polygons. isReachable()
+     * then accepts every pair.
+     */
+    void clear();
+
+    bool isBuilt() const { return !_labels.empty(); }
+
+    /**
+     * @brief Gets the island of a polygon.
+     * @return The island label (1-based), or 0 for filtered or unknown polygons.
+     */
+    unsigned int getIsland(dtPolyRef ref) const;
+
+    /**
+     * @brief Checks whether two polygons can be connected by a path.
+     * @return false only if both polygons are labeled and lie on different islands.
+     */
+    bool isReachable(dtPolyRef a, dtPolyRef b) const;
+
+    /**
+     * @brief Gets the number of islands found by the last build() (including removed ones).
+     */
+    int getIslandCount() const { return (int)_islandSizes.size() - 1; }
+
+    /**
+     * @brief Gets the number of polygons on an island.
+     */
+    int getIslandSize(unsigned int island) const
+    {
+        return island < _islandSizes.size() ? _islandSizes[island] : 0;
+    }
+
+    /**
+     * @brief Disables every island with fewer polygons than minPolys.
+     * Their polygons get only the given flags, so queries and agents skip them,
+     * and lose their label. Their previous flags are kept for restoreDisabled().
+     * @param navMesh The navmesh that was labeled.
+     * @param minPolys Smallest island size kept.
+     * @param disabledFlags Polygon flags the removed polygons are set to.
+     * @return The number of polygons disabled.
+     */
+    int disableSmallIslands(dtNavMesh* navMesh, const int minPolys, const unsigned short disabledFlags);
+
+    /**
+     * @brief Gives the polygons disabled by disableSmallIslands() their previous
+     * flags back. Call before relabeling, so that islands a tile change joined
+     * to a larger one are kept. Polygons of replaced tiles, and polygons whose
+     * flags were changed since, are left alone.
+     * @return The number of polygons restored.
+     */
+    int restoreDisabled(dtNavMesh* navMesh);
+
+private:
+    struct DisabledPoly
+    {
+        dtPolyRef Ref;
+        unsigned short Flags;       // Flags before disableSmallIslands()
+        unsigned short Disabled;    // Flags it set
+    };
+
+    // Label per polygon, indexed by the navmesh tile index and the polygon index
+    std::vector<std::vector<unsigned int>> _labels;
+    // Salt per tile, so labels of replaced tiles are not used for new polygons
+    std::vector<unsigned int> _salts;
+    // Polygon count per island (index 0 unused)
+    std::vector<int> _islandSizes;
+    const dtNavMesh* _navMesh = nullptr;
+    // Polygons disabled by disableSmallIslands(); build() keeps them, clear() drops them
+    std::vector<DisabledPoly> _disabled;
+
+    /**
+     * @brief Drops the labels, keeping the disabled polygons.
+     */
+    void _clearLabels();
+};
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "INavMesh.h"
+
+class CPathCache;
+class CNavMeshIslands;
+class CPolySearch;
+
+/**
+ * @class CNavQueryContext
+ * @brief Navmesh queries with their own dtNavMeshQuery, for use from any one thread.
+ *
+ * A dtNavMeshQuery keeps mutable node pools, so it can only serve one thread
+ * at a time. The dtNavMesh itself is only read by queries. Giving each thread
+ * its own context (see INavMesh::createQueryContext()) lets gameplay jobs run
+ * queries in parallel with each other and with the crowd update.
+ *
+ * A context is not thread-safe by itself: create one per thread.
+ *
+ * Path buffers are owned by the context and reused by every query. They
+ * start at 256 entries and grow when Detour reports DT_BUFFER_TOO_SMALL, so
+ * long corridors on big tiled maps are never cut off. A corridor is bounded
+ * by the node pool (maxNodes), which therefore limits path length.
+ *
+ * @note The context points at the navmesh it was created for. It must be
+ * recreated after the INavMesh is built, loaded or swapped (applyPendingBuild()),
+ * and must not be used while tiles are being added or removed.
+ */
+class CNavQueryContext
+{
+public:
+    /**
+     * @param navMesh The navmesh to query.
+     * @param maxNodes The size of the search node pool.
+     */
+    CNavQueryContext(const dtNavMesh* navMesh, int maxNodes = 2048);
+    ~CNavQueryContext();
+
+    // Disable copy
+    CNavQueryContext(const CNavQueryContext&) = delete;
+    CNavQueryContext& operator=(const CNavQueryContext&) = delete;
+
+    /**
+     * @brief Checks whether the query was initialized successfully.
+     */
+    bool isValid() const { return _navQuery != nullptr; }
+
+    /**
+     * @brief Gets the underlying Detour query (e.g. for a dtCrowd or custom queries).
+     */
+    dtNavMeshQuery* getQuery() const { return _navQuery.get(); }
+
+    /**
+     * @brief Finds the nearest walkable polygon to a position.
+     * @param pos The world-space position to query.
+     * @param nearestPoint Receives the closest point on the polygon (may be nullptr).
+     * @return The polygon reference, or 0 if none is within the search extents.
+     */
+    dtPolyRef findNearestPoly(const irr::core::vector3df& pos, float* nearestPoint = nullptr);
+
+    /**
+     * @brief Finds the closest valid point on the navmesh to the given position.
+     * @param pos The world-space position to query.
+     * @return The closest valid position on the navmesh. Returns original pos if query fails.
+     */
+    irr::core::vector3df getClosestPointOnNavmesh(const irr::core::vector3df& pos);
+
+    /**
+     * @brief Gets a path between two positions on the navmesh.
+     * @return A vector of waypoints along the path. Empty if no path found.
+     */
+    std::vector<irr::core::vector3df> GetPath(
+        const irr::core::vector3df& startPos,
+        const irr::core::vector3df& endPos
+    );
+
+    /**
+     * @brief Writes the waypoints of a path into caller-provided storage (no allocation).
+     * @param waypoints Receives up to maxWaypoints waypoints.
+     * @param maxWaypoints Capacity of waypoints (and of flags/polys).
+     * @param distance Receives the length of the whole path (may be nullptr).
+     * @param flags Receives the DT_STRAIGHTPATH_* flags per waypoint (may be nullptr).
+     * @param polys Receives the polygon each waypoint starts on (may be nullptr).
+     * @return The number of waypoints written, which is cut at maxWaypoints,
+     * or -1 if no path was found (no error is printed).
+     */
+    int GetPath(
+        const irr::core::vector3df& startPos,
+        const irr::core::vector3df& endPos,
+        irr::core::vector3df* waypoints, const int maxWaypoints,
+        float* distance = nullptr,
+        unsigned char* flags = nullptr,
+        dtPolyRef* polys = nullptr
+    );
+
+    /**
+     * @brief Calculates the distance along the navmesh between two positions.
+     * Use findPath() instead when the waypoints are needed as well.
+     * @return The total distance along the path in world units. Returns -1.0f if no path found.
+     */
+    float GetPathDistance(
+        const irr::core::vector3df& startPos,
+        const irr::core::vector3df& endPos
+    );
+
+    /**
+     * @brief Calculates the distances from one start to many targets with a single search.
+     * A Dijkstra expansion from the start polygon settles polygons by cost until
+     * every target polygon is settled, instead of running one A* per target.
+     * Each reached target's corridor is then straightened for its exact length.
+     * @param startPos The starting world-space position.
+     * @param targets The target positions.
+     * @param count Number of targets.
+     * @param distances Receives count distances in target order; -1.0f for targets
+     * that are off the navmesh, unreachable or beyond maxCost.
+     * @param maxCost Stops the expansion at this search cost (the filter's area cost
+     * times distance), 0 = no limit.
+     * @return The number of targets reached, or -1 if the start is off the navmesh.
+     */
+    int GetPathDistances(
+        const irr::core::vector3df& startPos,
+        const irr::core::vector3df* targets, const int count,
+        float* distances,
+        const float maxCost = 0.0f
+    );
+
+    /**
+     * @brief Finds the path between two positions without printing errors.
+     * Reusing the same result does not allocate once its vectors have grown.
+     * @param result Receives the status, waypoints and distance (and flags and
+     * polygons if result.IncludeDetails is set).
+     * @return result.Status
+     */
+    PathStatus findPath(
+        const irr::core::vector3df& startPos,
+        const irr::core::vector3df& endPos,
+        PathResult& result
+    );
+
+    /**
+     * @brief Turns a polygon corridor into waypoints (e.g. after a sliced findPath).
+     * If the corridor does not end at endRef, the path is PARTIAL and ends at
+     * the point of the last polygon closest to endPos.
+     * @param startPos Start position on the first polygon.
+     * @param endPos Target position.
+     * @param polys The polygon corridor.
+     * @param polyCount Number of polygons in the corridor.
+     * @param endRef The polygon of the target.
+     * @param result Receives the status, waypoints and distance.
+     * @return result.Status
+     */
+    PathStatus straightenPath(
+        const float* startPos, const float* endPos,
+        const dtPolyRef* polys, const int polyCount,
+        const dtPolyRef endRef,
+        PathResult& result
+    );
+
+    /**
+     * @brief Finishes a sliced search started with getQuery()->initSlicedFindPath()
+     * and turns its corridor into waypoints (see straightenPath()).
+     * @return result.Status
+     */
+    PathStatus finishSlicedFindPath(
+        const float* startPos, const float* endPos,
+        const dtPolyRef endRef,
+        PathResult& result
+    );
+
+    /**
+     * @brief Turns a cached corridor into waypoints, skipping the search.
+     * @return true on a cache hit (result is then set).
+     */
+    bool findCachedPath(
+        const float* startPos, const float* endPos,
+        const dtPolyRef startRef, const dtPolyRef endRef,
+        PathResult& result
+    );
+
+    /**
+     * @brief Sets the corridor cache used by findPath()/GetPath()/GetPathDistance() and
+     * by sliced searches. nullptr (the default) disables caching.
+     */
+    void setPathCache(CPathCache* cache) { _pathCache = cache; }
+
+    /**
+     * @brief Sets the island labels used to reject unreachable queries before
+     * searching. nullptr (the default) searches every query.
+     */
+    void setIslands(const CNavMeshIslands* islands) { _islands = islands; }
+
+    /**
+     * @brief Checks whether two polygons can be connected by a path (see CNavMeshIslands).
+     * @return false only if island labels are set and put the polygons on different islands.
+     */
+    bool isReachable(dtPolyRef a, dtPolyRef b) const;
+
+    /**
+     * @brief Gets the midpoint of the portal between two linked polygons, the
+     * point dtNavMeshQuery::findPath() places its search nodes at.
+     * @param link The link from fromPoly to toPoly.
+     * @param mid Receives the point.
+     */
+    static void getPortalMidpoint(
+        const dtPolyRef fromRef, const dtMeshTile* fromTile, const dtPoly* fromPoly, const dtLink& link,
+        const dtMeshTile* toTile, const dtPoly* toPoly,
+        float* mid
+    );
+
+    /**
+     * @brief Gets the filter used by every query of this context (WALK | DOOR).
+     */
+    const dtQueryFilter& getFilter() const { return _filter; }
+
+private:
+    std::unique_ptr<dtNavMeshQuery, DetourNavMeshQueryDeleter> _navQuery;
+
+    // Walkable polygons (WALK | DOOR)
+    dtQueryFilter _filter;
+    unsigned int _filterId = 0;
+    int _maxNodes = 0;
+
+    // Shared corridor cache (not owned), see setPathCache()
+    CPathCache* _pathCache = nullptr;
+
+    // Shared island labels (not owned), see setIslands()
+    const CNavMeshIslands* _islands = nullptr;
+
+    // --- Path Buffers (reused across queries) ---
+    std::vector<dtPolyRef> _polys;
+    std::vector<float> _straightPath;
+    std::vector<unsigned char> _straightPathFlags;
+    std::vector<dtPolyRef> _straightPathPolys;
+
+    // Result of GetPath()/GetPathDistance()
+    PathResult _scratch;
+
+    // --- One-to-many search (see GetPathDistances()) ---
+    std::unique_ptr<CPolySearch> _distanceSearch;
+    std::vector<dtPolyRef> _targetRefs;
+    std::vector<float> _targetNearest;
+
+    /**
+     * @brief Prints the error of a failed GetPath()/GetPathDistance().
+     */
+    void _printPathError(const char* method, PathStatus status) const;
+
+    static bool _isFound(PathStatus status) { return status == PathStatus::SUCCESS || status == PathStatus::PARTIAL; }
+
+    /**
+     * @brief Snaps both positions to the navmesh and searches the corridor into _polys.
+     * @return SUCCESS if a corridor was found (it may still be partial, see _straighten()).
+     */
+    PathStatus _findCorridor(
+        const irr::core::vector3df& startPos,
+        const irr::core::vector3df& endPos,
+        float* startNearest, float* endNearest,
+        dtPolyRef& endRef, int& polyCount
+    );
+
+    /**
+     * @brief Adds a complete corridor to the path cache.
+     */
+    void _storeCorridor(const dtPolyRef* polys, const int polyCount, const dtPolyRef endRef);
+
+    /**
+     * @brief Runs findStraightPath into the straight-path buffers.
+     * @param count Receives the number of waypoints.
+     * @return SUCCESS, PARTIAL or a failure.
+     */
+    PathStatus _straighten(
+        const float* startPos, const float* endPos,
+        const dtPolyRef* polys, const int polyCount,
+        const dtPolyRef endRef,
+        int& count
+    );
+
+    /**
+     * @brief Gets the length of the first count points of the straight-path buffer.
+     */
+    float _getStraightPathLength(const int count) const;
+
+    /**
+     * @brief Copies the first count points of the straight-path buffer into result.
+     */
+    void _setResult(const PathStatus status, const int count, PathResult& result) const;
+};
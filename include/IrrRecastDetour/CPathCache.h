@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "DetourNavMesh.h"
+
+/**
+ * @class CPathCache
+ * @brief LRU cache of polygon corridors, keyed by start polygon, end polygon and filter.
+ *
+ * A hit skips the A* search of a path query; the straight path is still built
+ * from the actual start/end positions. Only complete corridors are stored.
+ *
+ * The cache is disabled (capacity 0) until setCapacity() is called. It is
+ * shared by the query contexts of an INavMesh and locks a mutex per lookup,
+ * so GetPaths() threads can use it at the same time.
+ *
+ * Any tile change can open or close routes elsewhere, so INavMesh clears the
+ * whole cache when tiles are added, removed or rebuilt.
+ */
+class CPathCache
+{
+public:
+    CPathCache() {}
+
+    // Disable copy
+    CPathCache(const CPathCache&) = delete;
+    CPathCache& operator=(const CPathCache&) = delete;
+
+    /**
+     * @brief Sets the maximum number of corridors kept. 0 disables the cache.
+     * Shrinking evicts the least recently used entries.
+     */
+    void setCapacity(size_t entries);
+    size_t getCapacity() const;
+    bool isEnabled() const;
+
+    /**
+     * @brief Looks up a corridor and marks it as most recently used.
+     * @param polys Receives the corridor in its first elements on a hit. It is
+     * grown if the corridor does not fit, but never shrunk.
+     * @return The corridor length on a hit, 0 on a miss.
+     */
+    int find(dtPolyRef startRef, dtPolyRef endRef, unsigned int filterId, std::vector<dtPolyRef>& polys);
+
+    /**
+     * @brief Stores a corridor, evicting the least recently used one when full.
+     */
+    void store(dtPolyRef startRef, dtPolyRef endRef, unsigned int filterId, const dtPolyRef* polys, const int polyCount);
+
+    /**
+     * @brief Drops every corridor (e.g. after a tile change). The counters are kept.
+     */
+    void clear();
+
+    // --- Statistics ---
+    size_t getHits() const;
+    size_t getMisses() const;
+    size_t getSize() const;
+    void resetStats();
+
+private:
+    struct Key
+    {
+        dtPolyRef StartRef;
+        dtPolyRef EndRef;
+        unsigned int FilterId;
+
+        bool operator==(const Key& other) const
+        {
+            return StartRef == other.StartRef && EndRef == other.EndRef && FilterId == other.FilterId;
+        }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry
+    {
+        Key EntryKey;
+        std::vector<dtPolyRef> Polys;
+    };
+
+    mutable std::mutex _mutex;
+
+    // Most recently used first
+    std::list<Entry> _entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> _index;
+    size_t _capacity = 0;
+
+    size_t _hits = 0;
+    size_t _misses = 0;
+
+    void _evictToCapacity();
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include "CNavQueryContext.h"
+
+/**
+ * @class CPathScheduler
+ * @brief Runs path requests with Detour's sliced findPath, a little per frame.
+ *
+ * Requests are queued and searched in order. Each update() advances the
+ * searches until the iteration or time budget is used up, so a long path is
+ * spread over several frames instead of stalling one.
+ *
+ * Finished paths are passed to the request's callback (from update()), or,
+ * without a callback, kept until they are picked up with poll().
+ *
+ * INavMesh owns one scheduler and updates it from OnAnimate(), see
+ * INavMesh::requestPath(). The scheduler is not thread-safe.
+ */
+class CPathScheduler
+{
+public:
+    typedef std::function<void(unsigned int requestId, const PathResult& result)> Callback;
+
+    CPathScheduler() {}
+
+    // Disable copy
+    CPathScheduler(const CPathScheduler&) = delete;
+    CPathScheduler& operator=(const CPathScheduler&) = delete;
+
+    /**
+     * @brief Sets the query context used for the searches.
+     * Passing nullptr (e.g. while the navmesh is replaced) pauses the scheduler;
+     * a search in progress starts over with the next context.
+     */
+    void setQuery(std::unique_ptr<CNavQueryContext> query);
+    bool hasQuery() const { return _query != nullptr; }
+
+    /**
+     * @brief Starts the search in progress over, e.g. after tiles changed under it.
+     */
+    void restart();
+
+    /**
+     * @brief Queues a path request.
+     * @param callback Called with the result from update(); if empty, the
+     * result is kept for poll().
+     * @return The request id (never 0).
+     */
+    unsigned int request(
+        const irr::core::vector3df& startPos,
+        const irr::core::vector3df& endPos,
+        Callback callback = Callback()
+    );
+
+    /**
+     * @brief Picks up the result of a request made without callback.
+     * @param requestId The id returned by request().
+     * @param result Receives the result if the request is done.
+     * @return true if the request was done; its result is then forgotten.
+     */
+    bool poll(unsigned int requestId, PathResult& result);
+
+    /**
+     * @brief Checks whether a request is still queued or being searched.
+     */
+    bool isPending(unsigned int requestId) const;
+
+    /**
+     * @brief Drops a queued request, a search in progress or an unpolled result.
+     * @return true if the request was known.
+     */
+    bool cancel(unsigned int requestId);
+
+    /**
+     * @brief Drops every request and result (callbacks are not called).
+     */
+    void clear();
+
+    /**
+     * @brief Advances the searches within the budget.
+     * At least one search iteration runs per call, so requests always make progress.
+     */
+    void update();
+
+    /**
+     * @brief Sets the budget of one update().
+     * @param maxIterations Search iterations (nodes expanded) per update, 0 = no limit.
+     * @param maxMicroseconds Time per update in microseconds, 0 = no limit.
+     */
+    void setBudget(int maxIterations, float maxMicroseconds);
+    int getMaxIterations() const { return _maxIterations; }
+    float getMaxMicroseconds() const { return _maxMicroseconds; }
+
+    /**
+     * @brief Gets the number of requests still queued or being searched.
+     */
+    int getPendingCount() const { return (int)_queue.size(); }
+
+private:
+    struct Request
+    {
+        unsigned int Id = 0;
+        irr::core::vector3df Start;
+        irr::core::vector3df End;
+        Callback OnDone;
+
+        // Set once the sliced search is initialized
+        bool Started = false;
+        dtPolyRef StartRef = 0;
+        dtPolyRef EndRef = 0;
+        float StartNearest[3];
+        float EndNearest[3];
+    };
+
+    std::unique_ptr<CNavQueryContext> _query;
+    std::deque<Request> _queue;
+    std::unordered_map<unsigned int, PathResult> _results;
+    unsigned int _nextId = 1;
+
+    int _maxIterations = 1000;
+    float _maxMicroseconds = 1000.0f;
+
+    // Reused for the result of the current request
+    PathResult _result;
+
+    /**
+     * @brief Snaps the request to the navmesh and initializes the sliced search.
+     * @return false if the request is already done, i.e. it failed or its
+     * corridor was cached (_result is set).
+     */
+    bool _startRequest(Request& request);
+
+    /**
+     * @brief Sets a failure status on _result and clears what an earlier request left in it.
+     */
+    void _setFailure(PathStatus status);
+
+    /**
+     * @brief Hands _result to the front request's callback or stores it, then pops the request.
+     */
+    void _finishRequest();
+};
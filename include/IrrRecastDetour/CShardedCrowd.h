@@ -0,0 +1,154 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "INavMesh.h"
+
+class CWorkerPool;
+
+/**
+ * @class CShardedCrowd
+ * @brief A crowd split into several dtCrowd instances by position, updated in parallel.
+ *
+ * The navmesh bounds are divided into a grid of shards, each with its own
+ * dtCrowd (and so its own query and proximity grid). Agents have global ids
+ * and live in the shard under them. An agent that moves into another shard
+ * migrates there: it is re-added with its velocity, target and corridor, so it
+ * walks on without replanning.
+ *
+ * Neighbour search and avoidance only see agents of the same dtCrowd. So each
+ * agent within GhostMargin of a neighbouring shard is mirrored there as a
+ * ghost: an agent whose position and velocity are copied from the real one
+ * before every update, and which other agents avoid as usual.
+ *
+ * The interface follows dtCrowd, including handing out the lowest free id, so
+ * a 1 x 1 grid behaves exactly like a single dtCrowd.
+ */
+class CShardedCrowd
+{
+public:
+    CShardedCrowd();
+    ~CShardedCrowd();
+
+    // Disable copy
+    CShardedCrowd(const CShardedCrowd&) = delete;
+    CShardedCrowd& operator=(const CShardedCrowd&) = delete;
+
+    /**
+     * @brief Creates the shards.
+     * @param maxAgentRadius Largest agent radius (see dtCrowd::init()).
+     * @return false if a dtCrowd could not be created.
+     */
+    bool init(const CrowdParams& params, float maxAgentRadius, dtNavMesh* navMesh);
+
+    // --- dtCrowd Interface (global agent ids) ---
+    int addAgent(const float* pos, const dtCrowdAgentParams* params);
+    void removeAgent(const int idx);
+    const dtCrowdAgent* getAgent(const int idx);
+    dtCrowdAgent* getEditableAgent(const int idx);
+    bool requestMoveTarget(const int idx, dtPolyRef ref, const float* pos);
+    bool requestMoveVelocity(const int idx, const float* vel);
+    bool resetMoveTarget(const int idx);
+
+    /**
+     * @brief Gets the maximum number of agents (like dtCrowd::getAgentCount()).
+     */
+    int getAgentCount() const { return (int)_slots.size(); }
+
+    /**
+     * @brief Sets the exclude flags of query filter 0 of every shard.
+     */
+    void setExcludeFlags(unsigned short flags);
+
+    /**
+     * @brief Migrates agents, refreshes the ghosts and updates every shard.
+     */
+    void update(const float dt);
+
+    // --- Statistics ---
+    int getShardCount() const { return (int)_shards.size(); }
+    int getShardOf(const int idx) const;
+    int getGhostCount() const { return (int)_ghosts.size(); }
+
+private:
+    struct Slot
+    {
+        int Shard = -1;     // -1 = free id
+        int Local = -1;     // Index in the shard's dtCrowd
+    };
+
+    struct Shard
+    {
+        std::unique_ptr<dtCrowd, DetourCrowdDeleter> Crowd;
+        int Used = 0;       // Agents and ghosts
+        int Capacity = 0;
+    };
+
+    struct Ghost
+    {
+        int AgentId;
+        int Shard;
+        int Local;
+        bool Seen;
+    };
+
+    std::vector<Slot> _slots;
+    int _firstFree = 0;     // No free id below this one
+
+    std::vector<Shard> _shards;
+    int _cols = 1;
+    int _rows = 1;
+    float _bmin[3] = { 0.0f, 0.0f, 0.0f };
+    float _cellW = 1.0f;
+    float _cellH = 1.0f;
+    float _ghostMargin = 0.0f;
+    // Threads updating the shards, the caller of update() included; the
+    // others are kept in _workers between updates
+    int _threadCount = 1;
+    std::unique_ptr<CWorkerPool> _workers;
+
+    std::vector<Ghost> _ghosts;
+    // Ghost index by agent id * shard count + shard
+    std::unordered_map<long long, int> _ghostIndex;
+
+    bool _isActive(int idx) const { return idx >= 0 && idx < (int)_slots.size() && _slots[idx].Shard >= 0; }
+
+    /**
+     * @brief Gets the shard under a position.
+     */
+    int _shardAt(const float* pos) const;
+
+    /**
+     * @brief Adds an agent to a shard's dtCrowd.
+     * @return The local index, or -1 if the shard is full.
+     */
+    int _addToShard(int shard, const float* pos, const dtCrowdAgentParams* params);
+
+    void _removeFromShard(int shard, int local);
+
+    /**
+     * @brief Moves agents whose position left their shard (with some hysteresis).
+     */
+    void _migrateAgents();
+
+    /**
+     * @brief Re-adds an agent in another shard with its velocity, target and corridor.
+     * @return false if the shard is full (the agent stays).
+     */
+    bool _migrate(int id, int toShard);
+
+    /**
+     * @brief Adds, moves and removes ghosts for the agents near shard borders.
+     */
+    void _updateGhosts();
+
+    void _removeGhost(int index);
+
+    /**
+     * @brief Removes every ghost of an agent.
+     */
+    void _removeGhostsOf(int id);
+
+    long long _ghostKey(int id, int shard) const { return (long long)id * (long long)_shards.size() + shard; }
+};
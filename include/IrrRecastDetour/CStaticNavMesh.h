@@ -1,6 +1,7 @@
 #pragma once
 
 #include "INavMesh.h"
+#include "CNavMeshBuildContext.h"
 #include "Recast.h"
 #include "DetourNavMeshBuilder.h"
 
@@ -24,6 +25,10 @@ public:
 
     /**
      * @brief Builds the navigation mesh from the given scene node.
+     * If the geometry is unchanged since the last successful build, only the
+     * stages affected by the changed parameters are rerun (e.g. a new
+     * DetailSampleDist only rebuilds the detail mesh). Stages before the
+     * polymesh can only be skipped when KeepInterResults is set.
      * @param levelNode The Irrlicht mesh node to use as geometry.
      * @param params The configuration parameters for the navmesh build.
      * @return true if the build was successful, false otherwise.
@@ -33,6 +38,21 @@ public:
         const NavMeshParams& params
     );
 
+    /**
+     * @brief Builds the navigation mesh on a worker thread.
+     * The level geometry is copied on the calling thread; the Recast build then
+     * runs in the background while this node keeps serving the current navmesh.
+     * The result is swapped in by OnAnimate() (or applyPendingBuild()) once ready.
+     * @param levelNode The Irrlicht mesh node to use as geometry.
+     * @param params The configuration parameters for the navmesh build.
+     * @return A future that becomes ready with the build result, or an invalid
+     * future if the geometry could not be read or a build is already running.
+     */
+    std::shared_future<bool> buildAsync(
+        irr::scene::IMeshSceneNode* levelNode,
+        const NavMeshParams& params
+    );
+
     /**
      * @brief Gets the total time in milliseconds for the last successful build.
      */
@@ -45,8 +65,20 @@ public:
     irr::scene::ISceneNode* renderNavMesh();
 
 private:
+    // Recast pipeline stages, in build order
+    enum class BuildStage
+    {
+        Rasterize,
+        Compact,
+        Regions,
+        Contours,
+        PolyMesh,
+        DetailMesh,
+        Detour
+    };
+
     // --- Recast Build Objects (RAII-managed) ---
-    std::unique_ptr<rcContext, RecastContextDeleter> _ctx;
+    std::unique_ptr<CNavMeshBuildContext, RecastContextDeleter> _ctx;
     rcConfig _cfg;
     std::unique_ptr<rcHeightfield, RecastHeightfieldDeleter> _solid;
     std::unique_ptr<rcCompactHeightfield, RecastCompactHeightfieldDeleter> _chf;
@@ -58,21 +90,39 @@ private:
     std::vector<float> _verts;
     std::vector<int> _tris;
     std::vector<unsigned char> _triareas;
+    std::vector<unsigned char> _triAreaOverrides;
 
-    // --- Build Options and Metrics ---
-    NavMeshParams _params;
+    // True when the intermediates match _verts/_tris/_params (last build succeeded)
+    bool _hasCachedBuild = false;
+
+    // --- Build Metrics ---
     float _totalBuildTimeMs = 0.0f;
 
     // --- Debug Rendering ---
     irr::scene::ISceneNode* _naviDebugData = nullptr;
 
+    // --- INavMesh Overrides ---
+    virtual void _clearBuildData() override;
+    virtual void _adoptBuild(INavMesh& builder) override;
+
     // --- Build Helper Functions ---
-    bool _getMeshBufferData
-    (
-        irr::scene::IMeshSceneNode* node,
-        std::vector<float>& verts,
-        std::vector<int>& tris
-    );
+
+    /**
+     * @brief Runs the Recast/Detour build on the geometry in _verts/_tris.
+     * @param fromStage The first stage to run; earlier stages reuse the kept intermediates.
+     */
+    bool _buildFromInput(BuildStage fromStage = BuildStage::Rasterize);
+
+    /**
+     * @brief Gets the earliest stage that must be rerun to go from _params to params,
+     * stepping back to a stage whose inputs are still available.
+     */
+    BuildStage _getRestartStage(const NavMeshParams& params) const;
+
+    /**
+     * @brief Reports the memory of the live intermediates to _ctx (for the build report).
+     */
+    void _noteIntermediateMemory();
     bool _setupIrrSMeshFromRecastDetailMesh(irr::scene::SMesh* smesh);
     void _showHeightFieldInfo(const rcHeightfield& hf);
     bool _getMeshDataFromPolyMeshDetail
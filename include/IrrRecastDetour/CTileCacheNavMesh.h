@@ -0,0 +1,183 @@
+#pragma once
+
+#include "INavMesh.h"
+#include "CNavMeshBuildContext.h"
+#include "CTriangleGrid.h"
+#include "Recast.h"
+#include "DetourNavMeshBuilder.h"
+#include "DetourTileCache.h"
+#include "DetourTileCacheBuilder.h"
+
+// --- Custom Deleters for DetourTileCache objects ---
+struct DetourTileCacheDeleter {
+    void operator()(dtTileCache* tileCache) const {
+	if (tileCache) dtFreeTileCache(tileCache);
+    }
+};
+struct RecastHeightfieldLayerSetDeleter {
+    void operator()(rcHeightfieldLayerSet* lset) const {
+	if (lset) rcFreeHeightfieldLayerSet(lset);
+    }
+};
+
+/**
+ * @class TileCacheNavMesh
+ * @brief Implements AbstractNavMesh on top of DetourTileCache, for levels with dynamic obstacles.
+ *
+ * build() runs Recast only up to the heightfield layers of each tile and stores
+ * them compressed in a dtTileCache. The Detour tiles are then generated from
+ * those layers. Adding or removing an obstacle only marks the tiles it touches;
+ * update() regenerates them from the cached layers (no rasterization), one tile
+ * at a time, until it is up to date or its per-call time budget is spent.
+ *
+ * update() is called from OnAnimate(), so obstacles take effect over the next
+ * frame(s) without any extra code.
+ *
+ * @note save()/load() only store the Detour tiles. A loaded navmesh has no
+ * tile cache, so obstacles require a build().
+ */
+
+namespace irr
+{
+    namespace scene
+    {
+        class CTileCacheNavMesh : public irr::scene::INavMesh
+        {
+        public:
+            CTileCacheNavMesh(
+                irr::scene::ISceneNode* parent,
+                irr::scene::ISceneManager* mgr,
+                irr::s32 id = -1
+            );
+            ~CTileCacheNavMesh();
+
+            // --- ISceneNode Overrides ---
+            virtual void OnAnimate(irr::u32 timeMs) override;
+
+            /**
+             * @brief Builds the tile cache and navigation mesh from the given scene node.
+             * @param levelNode The Irrlicht mesh node to use as geometry.
+             * @param params The configuration parameters for the navmesh build.
+             * @param tileSize The width/height of a single tile in grid units (not world units).
+             * Must be below 256. A good default is 32 or 48.
+             * @param maxObstacles The maximum number of obstacles alive at once.
+             * @return true if the build was successful, false otherwise. Fails if the
+             * level needs more than 4096 tiles (room for 4 layers each), or if a tile
+             * cannot be built.
+             */
+            bool build(
+                irr::scene::IMeshSceneNode* levelNode,
+                const NavMeshParams& params,
+                const int tileSize,
+                const int maxObstacles = 128
+            );
+
+            // --- Obstacles ---
+
+            /**
+             * @brief Adds an upright cylinder obstacle.
+             * @param pos The center of the cylinder's base.
+             * @param radius The cylinder radius.
+             * @param height The cylinder height.
+             * @return The obstacle reference, or 0 on failure.
+             */
+            dtObstacleRef addObstacle(const irr::core::vector3df& pos, float radius, float height);
+
+            /**
+             * @brief Adds an axis-aligned box obstacle.
+             * @param box The box in world space.
+             * @return The obstacle reference, or 0 on failure.
+             */
+            dtObstacleRef addBoxObstacle(const irr::core::aabbox3df& box);
+
+            /**
+             * @brief Adds a box obstacle rotated around the Y axis.
+             * @param center The center of the box.
+             * @param halfExtents Half the size of the box on each axis.
+             * @param yRotationDeg Rotation around the Y axis, in degrees.
+             * @return The obstacle reference, or 0 on failure.
+             */
+            dtObstacleRef addBoxObstacle(
+                const irr::core::vector3df& center,
+                const irr::core::vector3df& halfExtents,
+                float yRotationDeg
+            );
+
+            /**
+             * @brief Removes an obstacle added by addObstacle()/addBoxObstacle().
+             * @return true if the removal was queued.
+             */
+            bool removeObstacle(dtObstacleRef ref);
+
+            /**
+             * @brief Rebuilds the tiles touched by obstacle changes.
+             * At least one tile is rebuilt per call; further tiles are rebuilt
+             * while the time spent stays below the update budget.
+             * @param dt Time since the last update, in seconds.
+             * @return true if the navmesh is up to date with all obstacles.
+             */
+            bool update(float dt);
+
+            /**
+             * @brief Sets the time update() may spend per call, in milliseconds (default 0.5).
+             */
+            void setUpdateBudgetMs(float ms) { _updateBudgetMs = ms; }
+            float getUpdateBudgetMs() const { return _updateBudgetMs; }
+
+            /**
+             * @brief Gets the total (wall-clock) time in milliseconds for the last successful build.
+             */
+            float getTotalBuildTimeMs() const { return _totalBuildTimeMs; }
+
+            /**
+             * @brief Gets the total size of the compressed layers held by the tile cache, in bytes.
+             */
+            size_t getCompressedLayerBytes() const;
+
+        private:
+            struct MeshProcess;
+
+            // --- Recast Build Context ---
+            std::unique_ptr<CNavMeshBuildContext, RecastContextDeleter> _ctx;
+
+            // --- Input Mesh Data (stored for the build loop) ---
+            std::vector<float> _verts;
+            std::vector<int> _tris;
+
+            // Recast area id per input triangle, classified once per build
+            std::vector<unsigned char> _triareas;
+
+            // Spatial index over _tris so each tile only rasterizes nearby triangles
+            CTriangleGrid _triGrid;
+
+            // --- Build Parameters ---
+            int _tileSize = 0;
+            float _totalBuildTimeMs = 0.0f;
+            float _updateBudgetMs = 0.5f;
+
+            // Set by obstacle changes until update() has rebuilt every affected tile
+            bool _obstaclesChanged = false;
+
+            // --- Tile Cache ---
+            // The helpers must outlive _tileCache, so they are declared first.
+            std::unique_ptr<dtTileCacheAlloc> _talloc;
+            std::unique_ptr<dtTileCacheCompressor> _tcomp;
+            std::unique_ptr<dtTileCacheMeshProcess> _tmproc;
+            std::unique_ptr<dtTileCache, DetourTileCacheDeleter> _tileCache;
+
+            // --- INavMesh Overrides ---
+            virtual void _clearBuildData() override;
+
+            // --- Build Helper Functions ---
+
+            /**
+             * @brief Rasterizes one tile and adds its compressed layers to the tile cache.
+             * @return The number of layers added, or -1 on error.
+             */
+            int _rasterizeTileLayers(
+                const int tx, const int ty,
+                const float* bmin, const float* bmax
+            );
+        };
+    }
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "INavMesh.h"
+
+class CNavQueryContext;
+class CPolySearch;
+
+/**
+ * @class CTileClusterGraph
+ * @brief Abstract graph over the tiles of a tiled navmesh, for very long path queries.
+ *
+ * The nodes are portals: pairs of linked polygons on either side of a shared
+ * tile edge. For every tile, the cost between each two of its portals is
+ * precomputed with a search that stays inside the tile.
+ *
+ * A long query first runs A* over the portals (a handful of nodes per tile
+ * instead of every polygon). It then refines the route one tile at a time with
+ * short polygon searches, and straightens the joined corridor. Neither search
+ * comes near the node pool limit, however long the path is. The route is close
+ * to, but not always exactly, the shortest one.
+ *
+ * Rebuilding tiles only recomputes the portals and costs of those tiles and
+ * of their direct neighbours, see updateTiles().
+ *
+ * Only layer 0 of each tile position is used, as built by CTiledNavMesh.
+ */
+class CTileClusterGraph
+{
+public:
+    CTileClusterGraph();
+    ~CTileClusterGraph();
+
+    // Disable copy; moving hands a background build's graph over
+    CTileClusterGraph(const CTileClusterGraph&) = delete;
+    CTileClusterGraph& operator=(const CTileClusterGraph&) = delete;
+    CTileClusterGraph(CTileClusterGraph&&);
+    CTileClusterGraph& operator=(CTileClusterGraph&&);
+
+    /**
+     * @brief Builds the graph over every tile of a navmesh.
+     * @param filter The filter the portals and costs are computed with (use
+     * the one of the query contexts that will search the graph).
+     * @param tilesW Tile columns of the grid, 0 = derive from the tiles present.
+     * @param tilesH Tile rows of the grid, 0 = derive from the tiles present.
+     * @return false if the navmesh has no tiles.
+     */
+    bool build(const dtNavMesh* navMesh, const dtQueryFilter& filter, int tilesW = 0, int tilesH = 0);
+
+    /**
+     * @brief Recomputes the graph after the tiles in a range were rebuilt.
+     * @param tx0 First tile column.
+     * @param ty0 First tile row.
+     * @param tx1 Last tile column (inclusive).
+     * @param ty1 Last tile row (inclusive).
+     */
+    void updateTiles(const dtNavMesh* navMesh, const dtQueryFilter& filter, int tx0, int ty0, int tx1, int ty1);
+
+    /**
+     * @brief Drops the graph.
+     */
+    void clear();
+
+    bool isBuilt() const { return _tilesW > 0; }
+
+    /**
+     * @brief Gets the number of portals between tiles.
+     */
+    int getPortalCount() const { return _portalCount; }
+
+    /**
+     * @brief Sets how many tiles apart start and end must be for findPath() to use
+     * the graph. Closer queries run a plain polygon search.
+     * @param tiles Minimum tile distance (the larger of the column and row distance).
+     */
+    void setMinTileDistance(int tiles) { _minTileDistance = tiles < 1 ? 1 : tiles; }
+    int getMinTileDistance() const { return _minTileDistance; }
+
+    /**
+     * @brief Finds a path, over the portals if start and end are far enough apart.
+     * @param query The context that snaps the positions and runs the polygon searches.
+     * Its navmesh must be the one the graph was built for.
+     * @param result Receives the status, waypoints and distance.
+     * @return result.Status
+     * @note Searches reuse buffers owned by the graph, so only one thread may
+     * call this at a time.
+     */
+    PathStatus findPath(
+        CNavQueryContext& query,
+        const irr::core::vector3df& startPos,
+        const irr::core::vector3df& endPos,
+        PathResult& result
+    );
+
+private:
+    struct Portal
+    {
+        dtPolyRef Polys[2] = { 0, 0 };  // The linked polygon in each tile
+        int Tiles[2] = { -1, -1 };      // Tile index (x + y * tilesW) of each side
+        int Slots[2] = { 0, 0 };        // Index in Tile::Portals of each side
+        float Pos[3];                   // Portal midpoint
+        bool Used = false;
+    };
+
+    struct Tile
+    {
+        std::vector<int> Portals;
+        // Portal-to-portal costs inside the tile, Portals.size() squared,
+        // row-major; FLT_MAX if the portals are not connected within the tile
+        std::vector<float> Costs;
+    };
+
+    std::vector<Portal> _portals;
+    std::vector<int> _freePortals;
+    int _portalCount = 0;
+
+    std::vector<Tile> _tiles;
+    int _tilesW = 0;
+    int _tilesH = 0;
+    int _minTileDistance = 3;
+
+    // --- Search Scratch (reused by every query) ---
+    // A* node per portal plus one for the goal. A node holds data only if its
+    // Stamp is the current _generation, so a new search just bumps the generation.
+    struct SearchNode
+    {
+        float G = 0.0f;
+        int Parent = -1;
+        int ViaTile = -1;
+        unsigned int Stamp = 0;
+        bool Closed = false;
+    };
+    std::vector<SearchNode> _searchNodes;
+    unsigned int _generation = 0;
+    std::vector<std::pair<float, int>> _open;
+    std::vector<float> _startCosts;
+    std::vector<float> _endCosts;
+    std::vector<int> _chain;
+    std::vector<dtPolyRef> _corridor;
+    std::vector<dtPolyRef> _segment;
+    // Polygon search inside one tile
+    std::unique_ptr<CPolySearch> _tileSearch;
+
+    /**
+     * @brief Starts a new A* search over nodes 0..nodeCount-1.
+     */
+    void _beginSearch(int nodeCount);
+
+    /**
+     * @brief Gets an A* node, resetting it if it is left over from an earlier search.
+     */
+    SearchNode& _getSearchNode(int index);
+
+    /**
+     * @brief Adds the portals between two neighbouring tiles.
+     */
+    void _addEdgePortals(const dtNavMesh* navMesh, const dtQueryFilter& filter, int ax, int ay, int bx, int by);
+
+    /**
+     * @brief Removes every portal of a tile, on both of its sides.
+     */
+    void _removeTilePortals(int tileIndex);
+
+    /**
+     * @brief Recomputes the slots and portal-to-portal costs of a tile.
+     */
+    void _computeTileCosts(const dtNavMesh* navMesh, const dtQueryFilter& filter, int tileIndex);
+
+    /**
+     * @brief Gets the cost from a position on a polygon of a tile to each of the tile's portals.
+     * @param costs Receives one cost per portal of the tile, FLT_MAX if unreachable.
+     */
+    void _getPortalCosts(
+        const dtNavMesh* navMesh, const dtQueryFilter& filter,
+        int tileIndex, dtPolyRef startRef, const float* startPos,
+        std::vector<float>& costs
+    );
+
+    /**
+     * @brief Gets the polygon of a portal on the side of a tile.
+     */
+    dtPolyRef _getPortalPoly(const Portal& portal, int tileIndex) const
+    {
+        return portal.Tiles[0] == tileIndex ? portal.Polys[0] : portal.Polys[1];
+    }
+};
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "INavMesh.h"
+#include "CNavMeshBuildContext.h"
+#include "CTriangleGrid.h"
+#include "CTileClusterGraph.h"
 #include "Recast.h"
 #include "DetourNavMeshBuilder.h"
 
@@ -15,6 +18,11 @@
  * It does not store most of the intermediate Recast data (heightfields, etc.)
  * as class members, because they are created and destroyed per-tile
  * inside the build() loop.
+ *
+ * Tiles are independent of each other, so build() can run them on several
+ * worker threads (see setBuildThreadCount()). Finished tiles are always added
+ * to the dtNavMesh from the calling thread in row order, so a parallel build
+ * produces exactly the same navmesh as a serial one.
  */
 
 namespace irr
@@ -45,6 +53,77 @@ namespace irr
                 const int tileSize
             );
 
+            /**
+             * @brief Builds the tiled navigation mesh on a worker thread.
+             * The level geometry is copied on the calling thread; the tiles are then
+             * built in the background (using the build thread count of this node,
+             * or one thread less than the hardware has if it is 0, so the main
+             * thread keeps a core) while this node keeps serving the current navmesh. The result is
+             * swapped in by OnAnimate() (or applyPendingBuild()) once ready.
+             * @param levelNode The Irrlicht mesh node to use as geometry.
+             * @param params The configuration parameters for the navmesh build.
+             * @param tileSize The width/height of a single tile in grid units.
+             * @return A future that becomes ready with the build result, or an invalid
+             * future if the geometry could not be read or a build is already running.
+             */
+            std::shared_future<bool> buildAsync(
+                irr::scene::IMeshSceneNode* levelNode,
+                const NavMeshParams& params,
+                const int tileSize
+            );
+
+            /**
+             * @brief Rebuilds only the tiles overlapping a world-space box.
+             * The geometry of the last build is kept; only the triangles of the
+             * node passed to build() that lie near the affected tiles are read
+             * again, so the cost follows the size of the box, not of the level.
+             * Mesh buffers whose bounding box misses the box are skipped, so keep
+             * them up to date (recalculateBoundingBox()) when editing vertices.
+             * If the node itself moved, its whole mesh is read again. If the new
+             * geometry reaches above or below the height range of the build, that
+             * range grows and every tile is rebuilt, so all tiles stay voxelized
+             * from the same origin.
+             * The new tiles replace the old ones in place, so the rest of the
+             * navmesh and all crowd agents stay untouched; agents on replaced
+             * tiles re-plan on the next crowd update.
+             * @note The tile grid is fixed by build(); geometry outside its bounds is ignored.
+             * Geometry outside the box must not have changed since it was last read.
+             * @param box The changed region in world space.
+             * @return true on success, false if nothing was built or a tile failed.
+             */
+            bool rebuildTiles(const irr::core::aabbox3df& box);
+
+            /**
+             * @brief Enables planning long paths over the tile cluster graph (off by default).
+             * findClusterPath() then searches queries whose ends lie at least
+             * minTileDistance tiles apart over portals between tiles first, and
+             * refines only the tiles on the route (see CTileClusterGraph).
+             * The graph is built right away (or by the next build) and updated
+             * incrementally by rebuildTiles().
+             * @param enabled Whether to keep the graph.
+             * @param minTileDistance Tile distance from which queries use the graph.
+             */
+            void setClusterPathfinding(bool enabled, int minTileDistance = 3);
+            bool getClusterPathfinding() const { return _clusterPathfinding; }
+
+            /**
+             * @brief Finds a path, over the tile cluster graph when its ends are far apart.
+             * Long paths on big tiled worlds then no longer exhaust the search node
+             * pool. Without setClusterPathfinding() this is the same as GetPath().
+             * @param result Receives the status, waypoints and distance.
+             * @return result.Status
+             */
+            PathStatus findClusterPath(
+                const irr::core::vector3df& startPos,
+                const irr::core::vector3df& endPos,
+                PathResult& result
+            );
+
+            /**
+             * @brief Gets the tile cluster graph, e.g. for its portal count.
+             */
+            const CTileClusterGraph& getClusterGraph() const { return _clusterGraph; }
+
             /**
              * @brief Creates (or re-creates) scene nodes visualizing the navmesh polygons.
              * @note This will create ONE debug node PER TILE.
@@ -53,54 +132,156 @@ namespace irr
             irr::scene::ISceneNode* renderNavMesh();
 
             /**
-             * @brief Gets the total time in milliseconds for the last successful build.
+             * @brief Gets the total (wall-clock) time in milliseconds for the last successful build.
              */
             float getTotalBuildTimeMs() const { return _totalBuildTimeMs; }
 
+            /**
+             * @brief Gets the CPU time of the tile builds of the last build, summed
+             * over tiles, in milliseconds.
+             * @note With several build threads this is larger than getTotalBuildTimeMs().
+             */
+            float getTotalTileCpuTimeMs() const { return _totalTileCpuTimeMs; }
+
+            /**
+             * @brief Sets how many worker threads build() and buildAsync() use to build tiles.
+             * @param count Number of threads. 0 (the default) uses one thread per
+             * hardware thread (one less for buildAsync()), 1 builds all tiles serially.
+             */
+            void setBuildThreadCount(int count) { _buildThreadCount = count < 0 ? 0 : count; }
+            int getBuildThreadCount() const { return _buildThreadCount; }
+
         private:
             // --- Recast Build Context ---
             // (Other Recast objects are local to the build loop)
-            std::unique_ptr<rcContext, RecastContextDeleter> _ctx;
+            std::unique_ptr<CNavMeshBuildContext, RecastContextDeleter> _ctx;
 
             // --- Input Mesh Data (stored for the build loop) ---
+            // The level node of the last build (grabbed), re-read by rebuildTiles()
+            irr::scene::IMeshSceneNode* _levelNode = nullptr;
             std::vector<float> _verts;
             std::vector<int> _tris;
             int _nverts;
             int _ntris;
 
+            // Recast area id per input triangle, classified once per build
+            std::vector<unsigned char> _triareas;
+
+            // Spatial index over _tris so each tile only rasterizes nearby triangles
+            CTriangleGrid _triGrid;
+
+            // --- Local Rebuilds (see rebuildTiles()) ---
+            // Transform of _levelNode when _verts was read; a moved node is read again whole
+            irr::core::matrix4 _levelTransform;
+            // Set for triangles replaced by rebuildTiles(), empty if none are
+            std::vector<char> _removedTris;
+            int _removedTriCount = 0;
+            // Triangles added by rebuildTiles() that _triGrid does not hold yet
+            std::vector<int> _patchTris;
+
             // --- Build Parameters ---
-            NavMeshParams _params;
             int _tileSize;
+            int _tilesW = 0;
+            int _tilesH = 0;
+            // Bounds the tile grid was laid out on (kept for rebuildTiles())
+            float _buildBMin[3] = { 0.0f, 0.0f, 0.0f };
+            float _buildBMax[3] = { 0.0f, 0.0f, 0.0f };
+            int _buildThreadCount = 0;
             float _totalBuildTimeMs = 0.0f;
+            float _totalTileCpuTimeMs = 0.0f;
+
+            // --- Hierarchical Pathfinding (see setClusterPathfinding()) ---
+            CTileClusterGraph _clusterGraph;
+            bool _clusterPathfinding = false;
 
             // --- Debug Rendering ---
             // A parent node to hold all the tile debug meshes
             irr::scene::ISceneNode* _naviDebugParent = nullptr;
             // We store the dmesh data for each tile if keepInterResults is true
+            // (indexed by tx + ty * tilesW, nullptr for empty tiles)
             std::vector<std::unique_ptr<rcPolyMeshDetail, RecastPolyMeshDetailDeleter>> _tileDMeshes;
 
+            // --- INavMesh Overrides ---
+            virtual void _clearBuildData() override;
+            virtual void _adoptBuild(INavMesh& builder) override;
+            virtual TileGrid _getTileGrid() const override;
+            virtual void _setTileGrid(const TileGrid& grid) override;
+
             // --- Build Helper Functions ---
 
             /**
-             * @brief Extracts vertex and index data from an Irrlicht mesh node.
-             * (Identical to the helper in StaticNavMesh)
+             * @brief Runs the tiled build on the geometry in _verts/_tris.
+             * @param triAreaOverrides Area override per triangle (RC_NULL_AREA = none).
+             */
+            bool _buildFromInput(const std::vector<unsigned char>& triAreaOverrides);
+
+            /**
+             * @brief Replaces the cached triangles overlapping a region (x and z used)
+             * with those _levelNode holds there now.
+             * @param heightChanged Set if the height range of the build grew, see _extendBuildHeight().
+             * @return false if the node has no mesh.
+             */
+            bool _updateRegionGeometry(const float* regionMin, const float* regionMax, bool& heightChanged);
+
+            /**
+             * @brief Re-reads the whole mesh of _levelNode and rebuilds the triangle grid.
+             * @param heightChanged Set if the height range of the build grew.
+             */
+            bool _reloadLevelGeometry(bool& heightChanged);
+
+            /**
+             * @brief Grows the height range of the build to include minY..maxY.
+             * @return true if it grew; every tile must then be rebuilt.
+             */
+            bool _extendBuildHeight(float minY, float maxY);
+
+            /**
+             * @brief Drops the triangles replaced by rebuildTiles() and the vertices
+             * only they used, then rebuilds the triangle grid.
+             */
+            void _compactGeometry();
+
+            /**
+             * @brief Checks whether a cached triangle's XZ bounds overlap a box (x and z used).
              */
-            bool _getMeshBufferData(irr::scene::IMeshSceneNode* node);
+            bool _triOverlaps(int tri, const float* qmin, const float* qmax) const;
 
             /**
-             * @brief Builds a single tile and adds it to the dtNavMesh.
+             * @brief Builds the Detour data for a single tile.
+             * @note Only reads shared build state, so it may run on several threads
+             * at once as long as each call gets its own context.
+             * @param ctx The Recast context used for logging, timers and memory peaks.
              * @param tx Tile X index.
              * @param ty Tile Y index.
              * @param bmin World bounding box min.
              * @param bmax World bounding box max.
+             * @param dataSize Receives the size of the returned data.
+             * @param dmeshOut Receives the tile's detail mesh if KeepInterResults is set.
              * @return The navmesh data for this tile, or nullptr on failure.
              */
             unsigned char* _buildTile(
+                CNavMeshBuildContext* ctx,
                 const int tx, const int ty,
                 const float* bmin, const float* bmax,
-                int& dataSize
+                int& dataSize,
+                std::unique_ptr<rcPolyMeshDetail, RecastPolyMeshDetailDeleter>& dmeshOut
             );
 
+            /**
+             * @brief Builds all tiles of the grid and adds them to _navMesh.
+             * Uses _buildThreadCount worker threads (see setBuildThreadCount()).
+             */
+            void _buildAllTiles(
+                const int tilesW, const int tilesH,
+                const float* bmin, const float* bmax
+            );
+
+            /**
+             * @brief Records a tile's build times and size in _buildReport.Tiles.
+             * @param tileData The tile's Detour data, or nullptr for an empty tile.
+             */
+            void _setTileReport(const int tx, const int ty, const float buildTimeMs, const float cpuTimeMs, const unsigned char* tileData);
+
             // (Helper functions for creating Irrlicht debug geometry)
             bool _setupIrrSMeshFromRecastDetailMesh(irr::scene::SMesh* smesh, rcPolyMeshDetail* dmesh, irr::video::SColor color);
             bool _getMeshDataFromPolyMeshDetail
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+
+/**
+ * @class CTriangleGrid
+ * @brief A uniform 2D (XZ) grid over an indexed triangle soup.
+ *
+ * Each triangle is registered in every cell its XZ bounding box overlaps.
+ * query() then returns only the triangles overlapping a rectangle, which
+ * lets a tiled build rasterize just the geometry near each tile instead of
+ * the whole level.
+ *
+ * The cell lists are stored in one flat array (cell offsets + triangle
+ * indices), so the grid costs two allocations regardless of cell count.
+ * Once built, the grid is read-only and safe to query from several threads.
+ */
+class CTriangleGrid
+{
+public:
+    CTriangleGrid() {}
+
+    /**
+     * @brief Builds the grid.
+     * @param verts Vertex positions (x, y, z per vertex).
+     * @param tris Triangle vertex indices (3 per triangle).
+     * @param ntris Number of triangles.
+     * @param bmin Minimum corner of the geometry bounds.
+     * @param bmax Maximum corner of the geometry bounds.
+     * @param cellSize Width of a grid cell in world units (e.g. the tile size).
+     */
+    void build(
+        const float* verts, const int* tris, const int ntris,
+        const float* bmin, const float* bmax,
+        const float cellSize
+    );
+
+    /**
+     * @brief Releases the grid data.
+     */
+    void clear();
+
+    /**
+     * @brief Collects the triangles whose XZ bounds overlap a rectangle.
+     * @param qmin Minimum corner of the query box (only x and z are used).
+     * @param qmax Maximum corner of the query box (only x and z are used).
+     * @param trisOut Receives the triangle indices, sorted ascending.
+     * @return The number of triangles found.
+     */
+    int query(const float* qmin, const float* qmax, std::vector<int>& trisOut) const;
+
+    bool empty() const { return _cellTris.empty(); }
+
+private:
+    void _cellRange(
+        const float minX, const float minZ,
+        const float maxX, const float maxZ,
+        int& x0, int& z0, int& x1, int& z1
+    ) const;
+
+    float _orig[2] = { 0.0f, 0.0f };
+    float _cellSize = 1.0f;
+    int _width = 0;
+    int _height = 0;
+
+    // Triangle XZ bounds (minX, minZ, maxX, maxZ per triangle)
+    std::vector<float> _triBounds;
+    // _cellTris[_cellStart[c] .. _cellStart[c + 1]) are the triangles in cell c
+    std::vector<int> _cellStart;
+    std::vector<int> _cellTris;
+};
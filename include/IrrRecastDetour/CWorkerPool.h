@@ -0,0 +1,77 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class CWorkerPool
+ * @brief A fixed set of threads that sleep until they are handed a job.
+ *
+ * Starting an OS thread costs about as much as a small batch of work, so
+ * per-frame and per-call parallel work (GetPaths(), the threaded crowd step,
+ * crowd shards) runs on threads that are created once and kept.
+ *
+ * One job runs at a time: job(i) is called once for each worker index i.
+ * Only one thread (the owner) may call dispatch(), wait() and run().
+ */
+class CWorkerPool
+{
+public:
+    /**
+     * @param threadCount Number of threads, at least one.
+     */
+    explicit CWorkerPool(int threadCount);
+
+    /**
+     * @brief Waits for the running job, then stops and joins the threads.
+     */
+    ~CWorkerPool();
+
+    // Disable copy
+    CWorkerPool(const CWorkerPool&) = delete;
+    CWorkerPool& operator=(const CWorkerPool&) = delete;
+
+    int getThreadCount() const { return (int)_threads.size(); }
+
+    /**
+     * @brief Starts job(0) .. job(count - 1), one per pool thread, and returns at once.
+     * Waits for the previous job first.
+     * @param count Threads taking part, at most getThreadCount().
+     */
+    void dispatch(int count, std::function<void(int)> job);
+
+    /**
+     * @brief Waits until every thread has finished the dispatched job.
+     */
+    void wait();
+
+    /**
+     * @brief Runs job(0) .. job(count - 1) and waits for all of them. job(0)
+     * runs on the calling thread, the others on pool threads.
+     * @param count At most getThreadCount() + 1.
+     */
+    void run(int count, const std::function<void(int)>& job);
+
+    /**
+     * @brief Gets the thread count for a parallel job: the requested count, or
+     * one per hardware thread if it is 0 or less.
+     */
+    static int resolveThreadCount(int requested);
+
+private:
+    std::vector<std::thread> _threads;
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    std::function<void(int)> _job;
+    unsigned int _jobId = 0;    // Bumped by every dispatch()
+    int _jobCount = 0;          // Threads taking part in the current job
+    int _pending = 0;           // Threads still running it
+    bool _stop = false;
+
+    void _threadMain(int index);
+};
@@ -14,6 +14,8 @@ Version: 0.7.23
 #include <math.h>
 #include <memory>
 #include <map>
+#include <functional>
+#include <future>
 
 // Irrlicht includes
 #include <irrlicht.h>
@@ -28,6 +30,13 @@ Version: 0.7.23
 #include "Recast.h"
 #include "DetourNavMeshBuilder.h"
 
+#include "CAgentCommandQueue.h"
+#include "CAgentTable.h"
+#include "CMappedFile.h"
+#include "CNavMeshBuildContext.h"
+#include "CNavMeshIslands.h"
+#include "CPathCache.h"
+
 // --- Custom Deleters for Detour objects ---
 struct DetourNavMeshDeleter {
     void operator()(dtNavMesh* navMesh) const { 
@@ -75,6 +84,13 @@ struct RecastPolyMeshDetailDeleter {
     }
 };
 
+// --- Custom Deleter for Irrlicht scene nodes not attached to the scene graph ---
+struct SceneNodeDropDeleter {
+    void operator()(irr::scene::ISceneNode* node) const {
+	if (node) node->drop();
+    }
+};
+
 // --- Polygon Areas and Flags ---
 enum class PolyAreas
 {
@@ -131,6 +147,96 @@ struct NavMeshParams
     bool KeepInterResults = false;
 };
 
+// One tile of a NavMeshBuildReport
+struct NavMeshTileReport
+{
+    int TileX = 0;
+    int TileY = 0;
+    float BuildTimeMs = 0.0f;   // Wall-clock time, includes waiting for a core
+    float CpuTimeMs = 0.0f;     // CPU time of the building thread
+    int PolyCount = 0;
+    int VertCount = 0;
+};
+
+// Timings and sizes of the last build, see INavMesh::getBuildReport()
+struct NavMeshBuildReport
+{
+    // Wall-clock time of the whole build
+    float TotalMs = 0.0f;
+
+    // Recast stage times. Tiled builds sum them over all tiles and threads,
+    // so together they can exceed TotalMs.
+    float RasterizeMs = 0.0f;
+    float FilterMs = 0.0f;
+    float CompactMs = 0.0f;
+    float ErodeMs = 0.0f;
+    float RegionsMs = 0.0f;     // Distance field and region partitioning
+    float LayersMs = 0.0f;      // Heightfield layers (tile cache builds only)
+    float ContoursMs = 0.0f;
+    float PolyMeshMs = 0.0f;
+    float DetailMeshMs = 0.0f;
+
+    // Resulting Detour navmesh
+    int TileCount = 0;
+    int PolyCount = 0;
+    int VertCount = 0;
+
+    // Most memory held by Recast intermediates at once (summed over build threads)
+    size_t PeakMemoryBytes = 0;
+
+    // Per-tile timings of tiled builds, including empty tiles
+    std::vector<NavMeshTileReport> Tiles;
+};
+
+// Outcome of one path query, see INavMesh::GetPaths()
+enum class PathStatus
+{
+    SUCCESS,        // Path reaches the end polygon
+    PARTIAL,        // End not reachable; path leads to the closest reachable polygon
+    NO_NAVMESH,     // Nothing built or loaded
+    NO_START_POLY,  // No navmesh polygon near the start position
+    NO_END_POLY,    // No navmesh polygon near the end position
+    NO_PATH         // Search failed
+};
+
+// One start/end pair of a GetPaths() batch
+struct PathRequest
+{
+    irr::core::vector3df Start;
+    irr::core::vector3df End;
+};
+
+// Result of a path query. The vectors keep their capacity, so reused results do not allocate.
+struct PathResult
+{
+    PathStatus Status = PathStatus::NO_PATH;
+    std::vector<irr::core::vector3df> Waypoints;
+    // Length of the straight path in world units, -1 if there is none
+    float Distance = -1.0f;
+
+    // Set to also receive the DT_STRAIGHTPATH_* flags and the polygon of each waypoint
+    bool IncludeDetails = false;
+    std::vector<unsigned char> Flags;
+    std::vector<dtPolyRef> Polys;
+};
+
+// Size and partitioning of the agent crowd (see CShardedCrowd)
+struct CrowdParams
+{
+    int MaxAgents = 1024;       // Agent ids are 0..MaxAgents-1
+    int ShardCols = 1;          // Shard grid over the navmesh bounds (XZ); 1 x 1 = one dtCrowd
+    int ShardRows = 1;
+    int AgentsPerShard = 0;     // dtCrowd capacity of a shard (agents and ghosts), 0 = automatic
+    float GhostMargin = 0.0f;   // How far into a neighbour shard agents are mirrored, 0 = 12 agent radii
+    int ThreadCount = 0;        // Threads updating the shards, 0 = one per hardware thread
+};
+
+class CNavQueryContext;
+class CPathScheduler;
+class CFlowField;
+class CShardedCrowd;
+class CWorkerPool;
+
 
 /**
  * @class AbstractNavMesh
@@ -142,7 +248,7 @@ struct NavMeshParams
  * It is an abstract class because it does not implement the actual navmesh
  * *build* process. Subclasses (like StaticNavMesh or TiledNavMesh) must
  * implement their own build() method and are responsible for properly
- * initializing the protected _navMesh, _navQuery, and _crowd members.
+ * initializing the protected _navMesh, _query, and _crowd members.
  */
 namespace irr {
     namespace scene {
@@ -169,6 +275,48 @@ namespace irr {
 
             // --- Agent (Crowd) Management ---
 
+            /**
+             * @brief Runs the crowd at a fixed simulation rate instead of once per frame.
+             * OnAnimate() accumulates the frame time and runs as many fixed steps as
+             * it covers, so the crowd cost no longer depends on the frame rate. Scene
+             * nodes are placed between the last two simulation states.
+             * @param hz Steps per second (e.g. 20, 30 or 60), 0 (the default) runs
+             * one step of the frame time per frame.
+             * @param maxSubSteps Most steps run in one frame; time beyond that is
+             * dropped, so a stall slows the simulation down instead of piling up.
+             */
+            void setSimulationRate(float hz, int maxSubSteps = 4);
+            float getSimulationRate() const { return _fixedStep > 0.0f ? 1.0f / _fixedStep : 0.0f; }
+
+            /**
+             * @brief Runs the crowd update on a worker thread, overlapped with rendering.
+             * OnAnimate() publishes the step that ran during the last frame (node
+             * positions and the state read by GetAgentVelocity(), renderAgentPaths()
+             * etc.), starts the next step and returns. addAgent(), RemoveAgent(),
+             * setAgentTarget() and setAgentFlowTarget() calls made while a step runs
+             * are queued and applied at the next OnAnimate(). Agent state read back
+             * therefore lags one frame behind. Calls that change the navmesh (builds,
+             * tile rebuilds, obstacle updates) wait for the running step first.
+             * @param enabled false (the default) updates the crowd inside OnAnimate().
+             */
+            void setThreadedCrowd(bool enabled);
+            bool getThreadedCrowd() const { return _threadedCrowd; }
+
+            /**
+             * @brief Sets the agent limit and how the crowd is split into shards.
+             * With more than one shard, agents are grouped by position into separate
+             * dtCrowds updated in parallel (see CShardedCrowd). Takes effect when the
+             * crowd is next created, at the next build() or load().
+             */
+            void setCrowdParams(const CrowdParams& params) { _crowdParams = params; }
+            const CrowdParams& getCrowdParams() const { return _crowdParams; }
+
+            /**
+             * @brief Gets the crowd, e.g. for shard statistics (include CShardedCrowd.h).
+             * @return nullptr if nothing is built.
+             */
+            const CShardedCrowd* getCrowd() const { return _crowd.get(); }
+
             /**
              * @brief Adds a new agent to the crowd simulation.
              * @param node The Irrlicht scene node this agent will control.
@@ -188,19 +336,105 @@ namespace irr {
              */
             int addAgent(irr::scene::ISceneNode* node, const dtCrowdAgentParams& params);
 
+            // --- Agent Calls From Other Threads ---
+            // The calls above must be made on the thread that runs OnAnimate().
+            // Other threads (e.g. gameplay jobs) queue theirs below instead. The
+            // queue is lock-free and never blocks; it is drained at the start of
+            // OnAnimate(), before the crowd update, in the order the calls were
+            // made. Each returns false if the queue is full and the call was dropped.
+
+            /**
+             * @brief Queues addAgent(node, params) from any thread.
+             * @param onAdded Called from OnAnimate() with the new agent id (-1 on failure).
+             */
+            bool queueAddAgent(irr::scene::ISceneNode* node, const dtCrowdAgentParams& params, std::function<void(int)> onAdded = nullptr);
+
+            /**
+             * @brief Queues RemoveAgent() from any thread.
+             */
+            bool queueRemoveAgent(int agentId);
+
+            /**
+             * @brief Queues setAgentTarget() from any thread.
+             */
+            bool queueAgentTarget(int agentId, const irr::core::vector3df& targetPos);
+
+            /**
+             * @brief Queues setAgentFlowTarget() from any thread.
+             */
+            bool queueAgentFlowTarget(int agentId, const irr::core::vector3df& goalPos);
+
+            /**
+             * @brief Gets the command queue, e.g. for its dropped counter.
+             */
+            const CAgentCommandQueue& getAgentCommandQueue() const { return _commandQueue; }
+
             /**
              * @brief Sets a new movement target for an agent.
+             * A target on another island than the agent (see IsReachable()) stops
+             * the agent, with a warning, instead of planning a partial path. A
+             * target off the navmesh is ignored and the agent keeps its old one.
              * @param agentId The ID returned by addAgent.
              * @param targetPos The world-space destination.
              */
             void setAgentTarget(int agentId, irr::core::vector3df targetPos);
 
+            /**
+             * @brief Sends an agent to a goal shared with other agents, using a flow field.
+             * Every agent sent to the same goal polygon follows one cached CFlowField
+             * (a single search for all of them) instead of planning its own corridor.
+             * The agent is steered with dtCrowd velocity requests, so local avoidance
+             * still applies. setAgentTarget() gives the agent its own path again.
+             * @param agentId The ID returned by addAgent.
+             * @param goalPos The world-space destination.
+             * @return false if the agent is unknown or the goal is off the navmesh.
+             */
+            bool setAgentFlowTarget(int agentId, irr::core::vector3df goalPos);
+
+            /**
+             * @brief Gets the cached flow field towards a goal, building it if needed
+             * (include CFlowField.h), e.g. to read the cost-to-go of positions.
+             * @return The field, or nullptr if the goal is off the navmesh.
+             */
+            const CFlowField* getFlowField(const irr::core::vector3df& goalPos);
+
+            /**
+             * @brief Drops every cached flow field. Fields still followed by agents
+             * are rebuilt on the next OnAnimate().
+             */
+            void clearFlowFields();
+
             /**
             * @brief Renders debug lines for all agent paths in the crowd.
             * @param driver The Irrlicht video driver.
             */
             void renderAgentPaths(irr::video::IVideoDriver* driver);
 
+            // --- Area Tagging ---
+
+            /**
+             * @brief Tags every triangle of a mesh buffer with a polygon area.
+             * Applied by the next build(). Steep (non-walkable) triangles stay unwalkable.
+             * @param bufferIndex Index of the mesh buffer in the level mesh.
+             * @param area The area to assign.
+             */
+            void setMeshBufferArea(irr::u32 bufferIndex, PolyAreas area);
+
+            /**
+             * @brief Tags every mesh buffer whose material uses a matching texture.
+             * Irrlicht does not keep material names, so materials are matched by
+             * their first texture, e.g. "can_jump" matches "textures/can_jump.png".
+             * Per-buffer overrides from setMeshBufferArea() take precedence.
+             * @param textureName Substring of the texture path to match (case-insensitive).
+             * @param area The area to assign.
+             */
+            void setMaterialArea(const irr::core::stringc& textureName, PolyAreas area);
+
+            /**
+             * @brief Removes all area overrides. Triangles are classified by slope only.
+             */
+            void clearAreaOverrides();
+
             // --- Pathfinding Queries ---
 
             /**
@@ -221,6 +455,38 @@ namespace irr {
                 const irr::core::vector3df& endPos
             );
 
+            /**
+             * @brief Finds a path into a reusable result, with its length, in one search.
+             * Does not allocate once the result's vectors have grown. No error is printed.
+             * @param result Receives the status, waypoints and distance (and flags and
+             * polygons if result.IncludeDetails is set).
+             * @return result.Status
+             */
+            PathStatus GetPath(
+                const irr::core::vector3df& startPos,
+                const irr::core::vector3df& endPos,
+                PathResult& result
+            );
+
+            /**
+             * @brief Writes the waypoints of a path into caller-provided storage (no allocation).
+             * @param waypoints Receives up to maxWaypoints waypoints.
+             * @param maxWaypoints Capacity of waypoints (and of flags/polys).
+             * @param distance Receives the length of the whole path (may be nullptr).
+             * @param flags Receives the DT_STRAIGHTPATH_* flags per waypoint (may be nullptr).
+             * @param polys Receives the polygon each waypoint starts on (may be nullptr).
+             * @return The number of waypoints written, which is cut at maxWaypoints,
+             * or -1 if no path was found (no error is printed).
+             */
+            int GetPath(
+                const irr::core::vector3df& startPos,
+                const irr::core::vector3df& endPos,
+                irr::core::vector3df* waypoints, int maxWaypoints,
+                float* distance = nullptr,
+                unsigned char* flags = nullptr,
+                dtPolyRef* polys = nullptr
+            );
+
             /**
              * @brief Calculates the distance along the navmesh between two positions.
              * @param startPos The starting world-space position.
@@ -232,6 +498,134 @@ namespace irr {
                 const irr::core::vector3df& endPos
             );
 
+            /**
+             * @brief Calculates the distances from one start to many targets with one search,
+             * e.g. to pick the nearest of several cover points or pickups.
+             * Much cheaper than calling GetPathDistance() per target, see
+             * CNavQueryContext::GetPathDistances().
+             * @param startPos The starting world-space position.
+             * @param targets The target positions.
+             * @param count Number of targets.
+             * @param distances Receives count distances in target order, -1.0f for unreachable targets.
+             * @param maxCost Stops the search at this cost, 0 = no limit.
+             * @return The number of targets reached, or -1 if the start is off the navmesh.
+             */
+            int GetPathDistances(
+                const irr::core::vector3df& startPos,
+                const irr::core::vector3df* targets, int count,
+                float* distances,
+                float maxCost = 0.0f
+            );
+
+            /**
+             * @brief Checks in O(1) whether a path between two positions can exist.
+             * The polygons are looked up in the island labels computed after every
+             * build, load and tile change (see CNavMeshIslands). GetPath(),
+             * GetPathDistance() and setAgentTarget() use the same check to fail fast.
+             * @return false if either position is off the navmesh or the two lie on
+             * disconnected islands.
+             */
+            bool IsReachable(
+                const irr::core::vector3df& startPos,
+                const irr::core::vector3df& endPos
+            );
+
+            /**
+             * @brief Disables islands with fewer polygons than the given count, e.g.
+             * unreachable ledges and rooftops. Their polygons get PolyFlags::DISABLED,
+             * so agents and queries ignore them. Applied now and after every build,
+             * load and tile change. Islands that grow past the size, or a lower
+             * size, re-enable their polygons with the flags they had.
+             * @param polys Smallest island kept, 0 (the default) keeps every island.
+             */
+            void setMinIslandSize(int polys);
+            int getMinIslandSize() const { return _minIslandSize; }
+
+            /**
+             * @brief Gets the island labels of the current navmesh.
+             */
+            const CNavMeshIslands& getIslands() const { return _islands; }
+
+            /**
+             * @brief Creates a query context with its own dtNavMeshQuery on this navmesh.
+             * Use one per thread to run queries in parallel (include CNavQueryContext.h).
+             * The context must be recreated when the navmesh is rebuilt or reloaded.
+             * @param maxNodes The size of the search node pool.
+             * @return The context, or nullptr if nothing is built.
+             */
+            std::unique_ptr<CNavQueryContext> createQueryContext(int maxNodes = 2048) const;
+
+            /**
+             * @brief Finds the paths of a batch of start/end pairs, spread over worker threads.
+             * Each thread uses its own CNavQueryContext from a pool, so throughput scales
+             * with cores. Failures are reported per request and not printed.
+             * @note The navmesh must not change while the batch runs; call it from the
+             * thread that builds and animates this node.
+             * @param requests The start/end pairs.
+             * @param results Caller-provided storage for count results, in request order.
+             * @param count Number of requests.
+             * @return The number of requests with a SUCCESS or PARTIAL path.
+             */
+            int GetPaths(const PathRequest* requests, PathResult* results, int count);
+
+            /**
+             * @brief Enables the corridor cache of path queries (off by default).
+             * Repeated queries between the same start and end polygons then skip
+             * the A* search. The cache is cleared whenever tiles change.
+             * @param entries Maximum number of corridors kept (LRU), 0 disables it.
+             */
+            void setPathCacheSize(size_t entries) { _pathCache.setCapacity(entries); }
+
+            /**
+             * @brief Gets the corridor cache, e.g. for its hit/miss counters.
+             */
+            CPathCache& getPathCache() { return _pathCache; }
+
+            /**
+             * @brief Sets how many threads GetPaths() uses. The threads are started
+             * by the first batch and sleep between batches.
+             * @param count Number of threads. 0 (the default) uses one thread per
+             * hardware thread, 1 runs every query on the calling thread.
+             */
+            void setQueryThreadCount(int count) { _queryThreadCount = count; }
+            int getQueryThreadCount() const { return _queryThreadCount; }
+
+            // --- Time-Sliced Path Requests ---
+
+            /**
+             * @brief Queues a path request that is searched over the next frames.
+             * OnAnimate() advances the queued searches within the path budget
+             * (see setPathBudget()), so long paths do not spike a frame.
+             * @param startPos The starting world-space position.
+             * @param endPos The ending world-space position.
+             * @param callback Called from OnAnimate() with the result. If empty, the
+             * result is kept until pollPath() picks it up.
+             * @return The request id, or 0 if nothing is built.
+             */
+            unsigned int requestPath(
+                const irr::core::vector3df& startPos,
+                const irr::core::vector3df& endPos,
+                std::function<void(unsigned int requestId, const PathResult& result)> callback = nullptr
+            );
+
+            /**
+             * @brief Picks up the result of a requestPath() made without callback.
+             * @return true if the request is done; result is then filled and the request forgotten.
+             */
+            bool pollPath(unsigned int requestId, PathResult& result);
+
+            /**
+             * @brief Drops a path request or its unpolled result.
+             */
+            void cancelPath(unsigned int requestId);
+
+            /**
+             * @brief Sets how much path searching OnAnimate() may do per frame.
+             * @param maxIterations Search iterations (nodes expanded) per frame, 0 = no limit (default 1000).
+             * @param maxMicroseconds Time per frame in microseconds, 0 = no limit (default 1000).
+             */
+            void setPathBudget(int maxIterations, float maxMicroseconds);
+
             /**
              * @brief Removes an agent from the crowd simulation.
              * @param agentId The ID of the agent to remove (returned by addAgent).
@@ -260,16 +654,146 @@ namespace irr {
              */
             bool HasAgentReachedDestination(int agentId);
 
+            // --- Serialization ---
+
+            /**
+             * @brief Saves the built navmesh to a binary file.
+             * The file holds the dtNavMeshParams, the Detour data of every tile,
+             * the NavMeshParams used for the build and the tile grid of a tiled build.
+             * The data goes to path + ".tmp" first, which then replaces the file, so
+             * processes that mapped the old file (loadMapped()) keep reading it.
+             * @param path The output file path.
+             * @return true on success, false if nothing is built or the file cannot be written.
+             */
+            bool save(const char* path) const;
+
+            /**
+             * @brief Replaces the navmesh with one written by save(), skipping the Recast build.
+             * The query and crowd are re-created; existing agents are removed.
+             * Debug geometry of the previous build is discarded.
+             * The file is read completely before anything is replaced, so if it
+             * fails the current navmesh, agents and debug geometry are kept.
+             * @param path The input file path.
+             * @return true on success, false if the file is missing, invalid or
+             * has a tile Detour does not accept.
+             */
+            bool load(const char* path);
+
+            /**
+             * @brief Like load(), but maps the file into memory instead of reading it.
+             * Tiles point straight into the mapping (no copy, no DT_TILE_FREE_DATA),
+             * so pages are shared through the OS page cache by every process that
+             * maps the same file. Detour writes its link tables into the tile data,
+             * so those pages become private copies; vertices, detail meshes and BV
+             * trees stay shared. The mapping lives until the next build/load or
+             * until this node is destroyed.
+             * @param path The input file path (written by save()).
+             * @return true on success, false if the file is missing or invalid.
+             */
+            bool loadMapped(const char* path);
+
+            /**
+             * @brief Gets the parameters the current navmesh was built with.
+             */
+            const NavMeshParams& getParams() const { return _params; }
+
+            /**
+             * @brief Prints the build progress (every stage and tile) to stdout.
+             * Warnings and errors are always printed.
+             * @param enabled false (the default) keeps builds quiet.
+             */
+            void setBuildProgressLog(bool enabled) { _buildProgressLog = enabled; }
+            bool getBuildProgressLog() const { return _buildProgressLog; }
+
+            /**
+             * @brief Gets the stage timings and sizes of the last build.
+             * After load() only the navmesh counts are set.
+             */
+            const NavMeshBuildReport& getBuildReport() const { return _buildReport; }
+
+            // --- Background Builds ---
+
+            /**
+             * @brief Checks whether a buildAsync() result is waiting to be applied.
+             */
+            bool isBuildPending() const { return _pendingBuild.valid(); }
+
+            /**
+             * @brief Swaps in the navmesh of a finished buildAsync().
+             * Called by OnAnimate(), so it is only needed when the node is not animated.
+             * The navmesh, query and crowd are replaced together. Existing agents
+             * are re-added at their current positions with the same ids, and their
+             * move targets are requested again on the new navmesh.
+             * @return true if a new navmesh was applied; false if none is ready
+             * or the background build failed (the current navmesh is kept).
+             */
+            bool applyPendingBuild();
+
         protected:
+            // --- Mapped navmesh file (see loadMapped()) ---
+            // Declared before _navMesh so it is unmapped after the navmesh is freed.
+            std::unique_ptr<CMappedFile> _mappedFile;
+
             // --- Core Detour Objects (RAII-managed) ---
             // Subclasses are responsible for creating and initializing these.
             std::unique_ptr<dtNavMesh, DetourNavMeshDeleter> _navMesh;
-            std::unique_ptr<dtNavMeshQuery, DetourNavMeshQueryDeleter> _navQuery;
-            std::unique_ptr<dtCrowd, DetourCrowdDeleter> _crowd;
+            // Query context of the thread that owns this node
+            std::unique_ptr<CNavQueryContext> _query;
+            std::unique_ptr<CShardedCrowd> _crowd;
+
+            // --- Batch Queries (see GetPaths()) ---
+            // One context per GetPaths() worker, created on first use for the current _navMesh
+            std::vector<std::unique_ptr<CNavQueryContext>> _queryPool;
+            // GetPaths() threads besides the calling one, kept between batches
+            std::unique_ptr<CWorkerPool> _queryWorkers;
+            int _queryThreadCount = 0;
+
+            // Shared by _query, _queryPool, _pathScheduler and createQueryContext() contexts
+            mutable CPathCache _pathCache;
+
+            // --- Connectivity (see IsReachable()) ---
+            // Shared by the same contexts as _pathCache; relabeled by _updateIslands()
+            CNavMeshIslands _islands;
+            int _minIslandSize = 0;
+            bool _buildProgressLog = false;
+
+            // --- Time-Sliced Path Requests (see requestPath()) ---
+            // Gets its query context in OnAnimate(), so requests survive navmesh rebuilds
+            std::unique_ptr<CPathScheduler> _pathScheduler;
+
+            // --- Flow Fields (see setAgentFlowTarget()) ---
+            struct FlowAgent
+            {
+                dtPolyRef GoalRef = 0;      // 0 after tile changes until re-snapped
+                irr::core::vector3df GoalPos;
+                bool Arrived = false;
+            };
+            // One field per goal polygon; cleared when tiles change
+            std::map<dtPolyRef, std::unique_ptr<CFlowField>> _flowFields;
+            std::map<int, FlowAgent> _flowAgents;
+            std::vector<dtPolyRef> _flowCorridor;
+
+            /**
+             * @brief Gets the cached field of a goal polygon, building it if needed.
+             * @return The field, or nullptr if it could not be built.
+             */
+            CFlowField* _getFlowField(CNavQueryContext& query, dtPolyRef goalRef, const irr::core::vector3df& goalPos);
+
+            /**
+             * @brief Sets the crowd velocity of every flow field agent from its field.
+             * Called before every crowd update.
+             * @param query The context of the thread running the update.
+             */
+            void _steerFlowAgents(CNavQueryContext& query);
+
+            // --- Build Parameters (set by build() or load()) ---
+            NavMeshParams _params;
+            NavMeshBuildReport _buildReport;
 
             // --- Agent Management ---
-            std::map<int, irr::scene::ISceneNode*> _agentNodeMap;
-            const int MAX_AGENTS = 1024; // (From original NavMesh.h)
+            // Scene node of every agent, synced after each crowd update
+            CAgentTable _agents;
+            CrowdParams _crowdParams;
 
             // Default agent params, to be set by subclass during build()
             float _defaultAgentRadius;
@@ -279,6 +803,236 @@ namespace irr {
             irr::core::aabbox3d<irr::f32> _box;
 
             irr::u32 _lastUpdateTimeMs = 0;
+
+            // --- Fixed Timestep (see setSimulationRate()) ---
+            float _fixedStep = 0.0f;    // Seconds per step, 0 = one step per frame
+            int _maxSubSteps = 4;
+            float _stepAccumulator = 0.0f;
+
+            /**
+             * @brief Advances the crowd by a frame time, in fixed steps if a simulation rate is set.
+             * @param query Steers the flow field agents.
+             * @param states If set, receives the previous positions of a fixed step
+             * for the agents in _stepAgentIds, instead of the agent table (worker thread).
+             * @return The interpolation between the last two simulation states.
+             */
+            float _advanceCrowd(float deltaTime, CNavQueryContext* query, std::vector<AgentState>* states);
+
+            /**
+             * @brief Steers the flow field agents and advances the crowd by one step.
+             */
+            void _stepCrowd(float deltaTime, CNavQueryContext* query);
+
+            // --- Threaded Crowd (see setThreadedCrowd()) ---
+            bool _threadedCrowd = false;
+            // One thread kept for the whole session, created by the first threaded step
+            std::unique_ptr<CWorkerPool> _crowdWorker;
+            bool _crowdStepRunning = false;
+            // Steers the flow field agents on the worker, so _query stays free
+            std::unique_ptr<CNavQueryContext> _crowdQuery;
+            // Agent calls made while a step runs (main thread only)
+            std::vector<AgentCommand> _crowdCommands;
+            // Published (front) and worker-written (back) agent states, indexed by agent id
+            std::vector<AgentState> _agentStates[2];
+            // Agents in _agents when the step started; the worker only touches their states
+            std::vector<int> _stepAgentIds;
+            // Agents removed since the last step started, whose states are cleared then
+            std::vector<int> _removedStateIds;
+            int _frontStates = 0;
+            float _stepAlpha = 1.0f;        // Interpolation of the last worker step
+            bool _hasStepResult = false;    // A step finished since the last publish
+
+            /**
+             * @brief Starts a crowd step on the worker thread.
+             */
+            void _startCrowdStep(float deltaTime);
+
+            /**
+             * @brief Body of the worker: advances the crowd and fills the back states.
+             */
+            void _runCrowdStep(float deltaTime);
+
+            /**
+             * @brief Waits for the running crowd step, if any, and applies the queued
+             * agent calls. Subclasses call it before changing the navmesh.
+             */
+            void _finishCrowdStep();
+
+            /**
+             * @brief Runs a deferred agent call. The crowd must not be stepping.
+             * @param tableUpdated true for calls made during a threaded step, which
+             * already added or removed the agent in _agents.
+             */
+            void _applyAgentCommand(AgentCommand& command, bool tableUpdated);
+
+            // --- Agent Commands From Other Threads (see queueAgentTarget()) ---
+            CAgentCommandQueue _commandQueue;
+
+            /**
+             * @brief Applies the commands queued by other threads, oldest first.
+             */
+            void _drainAgentCommands();
+
+            /**
+             * @brief Copies the crowd state of an agent (not PrevPos).
+             */
+            void _captureAgentState(int agentId, AgentState& state);
+
+            /**
+             * @brief Gets the state of an agent: live from the crowd, or the last
+             * published one with a threaded crowd.
+             * @return false if the agent is not active.
+             */
+            bool _getAgentState(int agentId, AgentState& state);
+
+            /**
+             * @brief Frees the crowd, query and navmesh (in that order), releases
+             * any mapped navmesh file and forgets all agents.
+             */
+            void _resetDetour();
+
+            /**
+             * @brief Creates _query and _crowd for the current _navMesh.
+             * @return true on success.
+             */
+            bool _initQueryAndCrowd();
+
+            /**
+             * @brief Tile layout of a tiled build, kept in saved files so a loaded
+             * navmesh can be rebuilt and clustered like a built one.
+             */
+            struct TileGrid
+            {
+                int TileSize = 0;
+                int TilesW = 0;
+                int TilesH = 0;
+                float BMin[3] = { 0.0f, 0.0f, 0.0f };
+                float BMax[3] = { 0.0f, 0.0f, 0.0f };
+            };
+
+            /**
+             * @brief Gets the tile layout save() writes. Untiled builds keep the default.
+             */
+            virtual TileGrid _getTileGrid() const { return TileGrid(); }
+
+            /**
+             * @brief Called by load() after _clearBuildData() with the saved tile layout.
+             */
+            virtual void _setTileGrid(const TileGrid& grid) {}
+
+            /**
+             * @brief Shared end of load()/loadMapped(): replaces the current navmesh
+             * with a fully loaded one. Nothing is changed before this is called, so a
+             * file that fails to load leaves the current navmesh in place.
+             * @param mappedFile The mapping the tiles point into, or nullptr.
+             */
+            bool _commitLoad(
+                std::unique_ptr<dtNavMesh, DetourNavMeshDeleter> navMesh,
+                std::unique_ptr<CMappedFile> mappedFile,
+                const NavMeshParams& buildParams,
+                const TileGrid& grid,
+                const irr::core::aabbox3df& box
+            );
+
+            /**
+             * @brief Fills _buildReport from a build context (stage times, total
+             * time, peak memory) and from _navMesh (tile, poly and vertex counts).
+             * Tiles is left to the caller.
+             * @param ctx The context of the build, or nullptr to only update the counts.
+             */
+            void _fillBuildReport(const CNavMeshBuildContext* ctx);
+
+            /**
+             * @brief Must be called by subclasses after adding, removing or rebuilding
+             * tiles of the live navmesh. Drops cached corridors and flow fields,
+             * relabels the islands and restarts the time-sliced search in progress.
+             */
+            void _onTilesChanged();
+
+            /**
+             * @brief Relabels the islands of _navMesh and disables those smaller
+             * than _minIslandSize.
+             */
+            void _updateIslands();
+
+            /**
+             * @brief Grows a box to include a tile's bounds.
+             */
+            static void _addTileToBox(const unsigned char* tileData, bool firstTile, irr::core::aabbox3df& box);
+
+            /**
+             * @brief Called by load() so subclasses can drop intermediate build data
+             * and debug nodes that no longer match the navmesh.
+             */
+            virtual void _clearBuildData() {}
+
+            // --- Background Build (see buildAsync() in the subclasses) ---
+            // A detached node of the same class that the worker thread builds into
+            std::unique_ptr<irr::scene::ISceneNode, SceneNodeDropDeleter> _pendingBuilder;
+            std::shared_future<bool> _pendingBuild;
+
+            /**
+             * @brief Runs a build job on a worker thread.
+             * @param builder A new, detached node of the subclass type. Ownership is
+             * taken; the job must only touch this node.
+             * @param job The build, returning true on success.
+             * @return The future of the job, or an invalid future if a build is already pending.
+             */
+            std::shared_future<bool> _startPendingBuild(INavMesh* builder, std::function<bool()> job);
+
+            /**
+             * @brief Called by applyPendingBuild() after _clearBuildData() so subclasses
+             * can take over the builder's intermediate data and debug state.
+             * @param builder The node passed to _startPendingBuild().
+             */
+            virtual void _adoptBuild(INavMesh& builder) {}
+
+            // --- Area Overrides ---
+            std::map<irr::u32, PolyAreas> _bufferAreas;
+            std::vector<std::pair<irr::core::stringc, PolyAreas>> _materialAreas;
+
+            /**
+             * @brief Gets the Recast area id a mesh buffer's triangles are forced to.
+             * @return The area id, or RC_NULL_AREA if the buffer has no override.
+             */
+            unsigned char _getMeshBufferAreaOverride(irr::u32 bufferIndex, irr::scene::IMeshBuffer* buffer) const;
+
+            /**
+             * @brief Extracts the world-space triangles of an Irrlicht mesh node, for every builder.
+             * @param verts Receives the vertices (x, y, z).
+             * @param tris Receives three vertex indices per triangle.
+             * @param triAreaOverrides Receives the area override per triangle (RC_NULL_AREA = none).
+             * @return false if the node has no mesh or no triangles.
+             */
+            bool _getMeshBufferData(
+                irr::scene::IMeshSceneNode* node,
+                std::vector<float>& verts,
+                std::vector<int>& tris,
+                std::vector<unsigned char>& triAreaOverrides
+            ) const;
+
+            /**
+             * @brief Classifies input triangles by slope, then applies the per-triangle overrides.
+             * @param triAreaOverrides Override per triangle (RC_NULL_AREA = none), may be empty.
+             * @param triAreasOut Receives one Recast area id per triangle.
+             */
+            static void _markTriangleAreas(
+                rcContext* ctx, const float walkableSlopeAngle,
+                const std::vector<float>& verts,
+                const std::vector<int>& tris,
+                const std::vector<unsigned char>& triAreaOverrides,
+                std::vector<unsigned char>& triAreasOut
+            );
+
+            /**
+             * @brief Converts Recast area ids of a poly mesh to PolyAreas and sets the matching PolyFlags.
+             */
+            static void _applyPolyAreaFlags(rcPolyMesh& pmesh);
+
+            /**
+             * @brief Same as above for raw per-polygon arrays (e.g. from a DetourTileCache mesh process).
+             */
+            static void _applyPolyAreaFlags(unsigned char* areas, unsigned short* flags, const int npolys);
         };
     }
 }
@@ -0,0 +1,64 @@
+#include "IrrRecastDetour/CAgentCommandQueue.h"
+
+CAgentCommandQueue::CAgentCommandQueue(size_t capacity)
+    : _enqueuePos(0), _dropped(0)
+{
+    size_t size = 2;
+    while (size < capacity)
+        size <<= 1;
+
+    _cells.reset(new Cell[size]);
+    _mask = size - 1;
+    for (size_t i = 0; i < size; ++i)
+        _cells[i].Sequence.store(i, std::memory_order_relaxed);
+}
+
+bool CAgentCommandQueue::push(AgentCommand&& command)
+{
+    size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+    for (;;)
+    {
+        cell = &_cells[pos & _mask];
+        const size_t sequence = cell->Sequence.load(std::memory_order_acquire);
+        const ptrdiff_t diff = (ptrdiff_t)sequence - (ptrdiff_t)pos;
+
+        if (diff == 0)
+        {
+            // The slot is free for this position; claim it
+            if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // The consumer has not freed this slot yet: the ring is full
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            // Another producer claimed it first
+            pos = _enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->Command = std::move(command);
+    cell->Sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool CAgentCommandQueue::pop(AgentCommand& command)
+{
+    Cell& cell = _cells[_dequeuePos & _mask];
+    const size_t sequence = cell.Sequence.load(std::memory_order_acquire);
+    if ((ptrdiff_t)sequence - (ptrdiff_t)(_dequeuePos + 1) < 0)
+        return false;
+
+    command = std::move(cell.Command);
+    cell.Command.OnAdded = nullptr;
+
+    // Hand the slot back to the producers for its next lap
+    cell.Sequence.store(_dequeuePos + _mask + 1, std::memory_order_release);
+    ++_dequeuePos;
+    return true;
+}
@@ -0,0 +1,148 @@
+#include "IrrRecastDetour/CAgentTable.h"
+#include "IrrRecastDetour/CShardedCrowd.h"
+
+bool CAgentTable::add(int agentId, irr::scene::ISceneNode* node, float heightOffset)
+{
+    if (agentId < 0 || contains(agentId))
+        return false;
+
+    if (agentId >= (int)_indices.size())
+        _indices.resize(agentId + 1, -1);
+
+    _indices[agentId] = (int)_agentIds.size();
+    _agentIds.push_back(agentId);
+    _nodes.push_back(node);
+    _heightOffsets.push_back(heightOffset);
+    _lastPositions.push_back(irr::core::vector3df(0, 0, 0));
+    _prevPositions.push_back(irr::core::vector3df(0, 0, 0));
+    _flags.push_back(0);
+    return true;
+}
+
+bool CAgentTable::remove(int agentId)
+{
+    const int index = _getIndex(agentId);
+    if (index < 0)
+        return false;
+
+    // Move the last row into the freed slot
+    const int last = (int)_agentIds.size() - 1;
+    if (index != last)
+    {
+        _agentIds[index] = _agentIds[last];
+        _nodes[index] = _nodes[last];
+        _heightOffsets[index] = _heightOffsets[last];
+        _lastPositions[index] = _lastPositions[last];
+        _prevPositions[index] = _prevPositions[last];
+        _flags[index] = _flags[last];
+        _indices[_agentIds[index]] = index;
+    }
+
+    _agentIds.pop_back();
+    _nodes.pop_back();
+    _heightOffsets.pop_back();
+    _lastPositions.pop_back();
+    _prevPositions.pop_back();
+    _flags.pop_back();
+    _indices[agentId] = -1;
+    return true;
+}
+
+void CAgentTable::clear()
+{
+    _indices.clear();
+    _agentIds.clear();
+    _nodes.clear();
+    _heightOffsets.clear();
+    _lastPositions.clear();
+    _prevPositions.clear();
+    _flags.clear();
+}
+
+int CAgentTable::getFirstFreeId() const
+{
+    for (int id = 0; id < (int)_indices.size(); ++id)
+    {
+        if (_indices[id] < 0)
+            return id;
+    }
+    return (int)_indices.size();
+}
+
+irr::scene::ISceneNode* CAgentTable::getNode(int agentId) const
+{
+    const int index = _getIndex(agentId);
+    return index >= 0 ? _nodes[index] : nullptr;
+}
+
+void CAgentTable::savePreviousPositions(CShardedCrowd* crowd)
+{
+    const int count = size();
+    for (int i = 0; i < count; ++i)
+    {
+        const dtCrowdAgent* agent = crowd->getAgent(_agentIds[i]);
+        if (!agent || !agent->active)
+        {
+            _flags[i] &= ~HAS_PREVIOUS;
+            continue;
+        }
+
+        _prevPositions[i] = _getNodePos(agent, i);
+        _flags[i] |= HAS_PREVIOUS;
+    }
+}
+
+int CAgentTable::syncPositions(CShardedCrowd* crowd, float alpha)
+{
+    int written = 0;
+    const int count = size();
+    for (int i = 0; i < count; ++i)
+    {
+        const dtCrowdAgent* agent = crowd->getAgent(_agentIds[i]);
+        if (!agent || !agent->active)
+            continue;
+
+        irr::core::vector3df nodePos = _getNodePos(agent, i);
+        if (alpha < 1.0f && (_flags[i] & HAS_PREVIOUS))
+            nodePos = _prevPositions[i].getInterpolated(nodePos, 1.0f - alpha);
+
+        if (_writeNode(i, nodePos))
+            ++written;
+    }
+    return written;
+}
+
+int CAgentTable::syncPositions(const AgentState* states, int stateCount, float alpha)
+{
+    int written = 0;
+    const int count = size();
+    for (int i = 0; i < count; ++i)
+    {
+        const int agentId = _agentIds[i];
+        if (agentId >= stateCount || !states[agentId].Active)
+            continue;
+
+        const AgentState& state = states[agentId];
+        irr::core::vector3df nodePos(state.Pos[0], state.Pos[1] + _heightOffsets[i], state.Pos[2]);
+        if (alpha < 1.0f && state.HasPrevious)
+        {
+            const irr::core::vector3df prevPos(state.PrevPos[0], state.PrevPos[1] + _heightOffsets[i], state.PrevPos[2]);
+            nodePos = prevPos.getInterpolated(nodePos, 1.0f - alpha);
+        }
+
+        if (_writeNode(i, nodePos))
+            ++written;
+    }
+    return written;
+}
+
+bool CAgentTable::_writeNode(int index, const irr::core::vector3df& nodePos)
+{
+    if ((_flags[index] & SYNCED) && nodePos.getDistanceFromSQ(_lastPositions[index]) <= _moveEpsilonSqr)
+        return false;
+
+    _nodes[index]->setPosition(nodePos);
+    _lastPositions[index] = nodePos;
+    _flags[index] |= SYNCED;
+    return true;
+}
@@ -0,0 +1,64 @@
+#include "IrrRecastDetour/CFlowField.h"
+#include "IrrRecastDetour/CNavQueryContext.h"
+#include "DetourCommon.h"
+#include "DetourGraphUtils.h"
+
+bool CFlowField::build(CNavQueryContext& query, const irr::core::vector3df& goalPos, const float maxCost)
+{
+    _cells.clear();
+    _goalRef = 0;
+    _goalPos = goalPos;
+
+    float goalNearest[3];
+    const dtPolyRef goalRef = query.findNearestPoly(goalPos, goalNearest);
+    if (!goalRef)
+        return false;
+
+    const dtNavMesh* navMesh = query.getQuery()->getAttachedNavMesh();
+    const dtQueryFilter& filter = query.getFilter();
+
+    // A reverse search: each settled polygon's parent is the next one towards the goal
+    CPolySearch search;
+    search.addStart(goalRef, goalNearest);
+    search.run(navMesh, filter, true, maxCost,
+        [](dtPolyRef, const dtMeshTile*, const dtPoly*) { return true; },
+        [&](int index)
+        {
+            const CPolySearch::Node& node = search[index];
+            Cell& cell = _cells[node.Ref];
+            cell.Next = node.Parent >= 0 ? search[node.Parent].Ref : 0;
+            cell.Cost = node.Cost;
+            return true;
+        });
+
+    _goalRef = goalRef;
+    return true;
+}
+
+dtPolyRef CFlowField::getNextPoly(dtPolyRef ref) const
+{
+    auto it = _cells.find(ref);
+    return it != _cells.end() ? it->second.Next : 0;
+}
+
+float CFlowField::getCostToGo(dtPolyRef ref) const
+{
+    auto it = _cells.find(ref);
+    return it != _cells.end() ? it->second.Cost : -1.0f;
+}
+
+int CFlowField::getCorridor(dtPolyRef startRef, dtPolyRef* polys, const int maxPolys) const
+{
+    int count = 0;
+    dtPolyRef ref = startRef;
+    while (ref && count < maxPolys)
+    {
+        auto it = _cells.find(ref);
+        if (it == _cells.end())
+            break;
+
+        polys[count++] = ref;
+        ref = it->second.Next;
+    }
+    return count;
+}
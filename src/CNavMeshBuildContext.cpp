@@ -0,0 +1,150 @@
+#include "IrrRecastDetour/CNavMeshBuildContext.h"
+#include <stdio.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+CNavMeshBuildContext::CNavMeshBuildContext(bool logEnabled)
+    : rcContext(true)
+{
+    enableLog(logEnabled);
+    doResetTimers();
+}
+
+void CNavMeshBuildContext::mergeTimers(const CNavMeshBuildContext& other)
+{
+    for (int i = 0; i < RC_MAX_TIMERS; ++i)
+    {
+        if (other._accTime[i] < 0)
+            continue;
+
+        if (_accTime[i] < 0)
+            _accTime[i] = 0;
+        _accTime[i] += other._accTime[i];
+    }
+
+    _peakMemory += other._peakMemory;
+}
+
+size_t CNavMeshBuildContext::getMemoryUsage(const rcHeightfield& hf)
+{
+    size_t bytes = (size_t)hf.width * hf.height * sizeof(rcSpan*);
+    for (const rcSpanPool* pool = hf.pools; pool; pool = pool->next)
+        bytes += sizeof(rcSpanPool);
+    return bytes;
+}
+
+size_t CNavMeshBuildContext::getMemoryUsage(const rcCompactHeightfield& chf)
+{
+    size_t bytes = (size_t)chf.width * chf.height * sizeof(rcCompactCell);
+    bytes += (size_t)chf.spanCount * (sizeof(rcCompactSpan) + sizeof(unsigned char));
+    if (chf.dist)
+        bytes += (size_t)chf.spanCount * sizeof(unsigned short);
+    return bytes;
+}
+
+size_t CNavMeshBuildContext::getMemoryUsage(const rcContourSet& cset)
+{
+    size_t bytes = (size_t)cset.nconts * sizeof(rcContour);
+    for (int i = 0; i < cset.nconts; ++i)
+        bytes += (size_t)(cset.conts[i].nverts + cset.conts[i].nrverts) * 4 * sizeof(int);
+    return bytes;
+}
+
+size_t CNavMeshBuildContext::getMemoryUsage(const rcPolyMesh& pmesh)
+{
+    // verts + (polys, regs, flags, areas) for every allocated polygon
+    size_t bytes = (size_t)pmesh.nverts * 3 * sizeof(unsigned short);
+    bytes += (size_t)pmesh.maxpolys * (pmesh.nvp * 2 * sizeof(unsigned short) + 2 * sizeof(unsigned short) + sizeof(unsigned char));
+    return bytes;
+}
+
+size_t CNavMeshBuildContext::getMemoryUsage(const rcPolyMeshDetail& dmesh)
+{
+    return (size_t)dmesh.nmeshes * 4 * sizeof(unsigned int) +
+        (size_t)dmesh.nverts * 3 * sizeof(float) +
+        (size_t)dmesh.ntris * 4 * sizeof(unsigned char);
+}
+
+size_t CNavMeshBuildContext::getMemoryUsage(const rcHeightfieldLayerSet& lset)
+{
+    // heights, areas and cons per layer cell
+    size_t bytes = (size_t)lset.nlayers * sizeof(rcHeightfieldLayer);
+    for (int i = 0; i < lset.nlayers; ++i)
+        bytes += (size_t)lset.layers[i].width * lset.layers[i].height * 3;
+    return bytes;
+}
+
+double CNavMeshBuildContext::getThreadCpuTimeMs()
+{
+#ifdef _WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+        return 0.0;
+
+    // FILETIME counts 100 ns units
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+    return (kernel.QuadPart + user.QuadPart) / 10000.0;
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return 0.0;
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+#endif
+}
+
+void CNavMeshBuildContext::doLog(const rcLogCategory category, const char* msg, const int len)
+{
+    // Builds log a line per stage and tile, from several threads at once
+    if (category == RC_LOG_PROGRESS && !_progressLog)
+        return;
+
+    const char* prefix = "";
+    if (category == RC_LOG_WARNING)
+        prefix = "WARNING: ";
+    else if (category == RC_LOG_ERROR)
+        prefix = "ERROR: ";
+
+    printf("%s%.*s\n", prefix, len, msg);
+}
+
+void CNavMeshBuildContext::doResetTimers()
+{
+    for (int i = 0; i < RC_MAX_TIMERS; ++i)
+        _accTime[i] = -1;
+    _peakMemory = 0;
+}
+
+void CNavMeshBuildContext::doStartTimer(const rcTimerLabel label)
+{
+    _startTime[label] = std::chrono::steady_clock::now();
+}
+
+void CNavMeshBuildContext::doStopTimer(const rcTimerLabel label)
+{
+    const auto endTime = std::chrono::steady_clock::now();
+    const long long deltaTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - _startTime[label]).count();
+
+    if (_accTime[label] < 0)
+        _accTime[label] = deltaTime;
+    else
+        _accTime[label] += deltaTime;
+}
+
+int CNavMeshBuildContext::doGetAccumulatedTime(const rcTimerLabel label) const
+{
+    return (int)_accTime[label];
+}
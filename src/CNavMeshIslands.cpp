@@ -0,0 +1,204 @@
+#include "IrrRecastDetour/CNavMeshIslands.h"
+#include <numeric>
+
+namespace
+{
+    int findRoot(std::vector<int>& parents, int i)
+    {
+        while (parents[i] != i)
+        {
+            // Path halving
+            parents[i] = parents[parents[i]];
+            i = parents[i];
+        }
+        return i;
+    }
+}
+
+int CNavMeshIslands::build(const dtNavMesh* navMesh, const dtQueryFilter& filter)
+{
+    _clearLabels();
+    if (!navMesh)
+        return 0;
+
+    _navMesh = navMesh;
+    const int maxTiles = navMesh->getMaxTiles();
+    _labels.resize(maxTiles);
+    _salts.assign(maxTiles, 0);
+
+    // Every polygon gets a global index: the offset of its tile plus its own index
+    std::vector<int> offsets(maxTiles, 0);
+    int polyCount = 0;
+    for (int i = 0; i < maxTiles; ++i)
+    {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        offsets[i] = polyCount;
+        if (!tile || !tile->header)
+            continue;
+
+        _salts[i] = tile->salt;
+        _labels[i].assign(tile->header->polyCount, 0);
+        polyCount += tile->header->polyCount;
+    }
+
+    // Union every link between two polygons the filter lets through
+    std::vector<int> parents(polyCount);
+    std::iota(parents.begin(), parents.end(), 0);
+    std::vector<char> passes(polyCount, 0);
+
+    for (int i = 0; i < maxTiles; ++i)
+    {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (!tile || !tile->header)
+            continue;
+
+        const dtPolyRef base = navMesh->getPolyRefBase(tile);
+        for (int p = 0; p < tile->header->polyCount; ++p)
+        {
+            const dtPoly* poly = &tile->polys[p];
+            if (!filter.passFilter(base | (dtPolyRef)p, tile, poly))
+                continue;
+
+            const int index = offsets[i] + p;
+            passes[index] = 1;
+
+            for (unsigned int l = poly->firstLink; l != DT_NULL_LINK; l = tile->links[l].next)
+            {
+                const dtPolyRef neighbourRef = tile->links[l].ref;
+                if (!neighbourRef)
+                    continue;
+
+                const dtMeshTile* neighbourTile = nullptr;
+                const dtPoly* neighbourPoly = nullptr;
+                navMesh->getTileAndPolyByRefUnsafe(neighbourRef, &neighbourTile, &neighbourPoly);
+                if (!filter.passFilter(neighbourRef, neighbourTile, neighbourPoly))
+                    continue;
+
+                const int neighbourIndex = offsets[navMesh->decodePolyIdTile(neighbourRef)] + (int)navMesh->decodePolyIdPoly(neighbourRef);
+                const int a = findRoot(parents, index);
+                const int b = findRoot(parents, neighbourIndex);
+                if (a != b)
+                    parents[b] = a;
+            }
+        }
+    }
+
+    // Number the islands in polygon order
+    std::vector<unsigned int> rootLabels(polyCount, 0);
+    _islandSizes.assign(1, 0);
+    for (int i = 0; i < maxTiles; ++i)
+    {
+        for (size_t p = 0; p < _labels[i].size(); ++p)
+        {
+            const int index = offsets[i] + (int)p;
+            if (!passes[index])
+                continue;
+
+            const int root = findRoot(parents, index);
+            if (!rootLabels[root])
+            {
+                rootLabels[root] = (unsigned int)_islandSizes.size();
+                _islandSizes.push_back(0);
+            }
+            _labels[i][p] = rootLabels[root];
+            _islandSizes[rootLabels[root]]++;
+        }
+    }
+
+    return getIslandCount();
+}
+
+void CNavMeshIslands::clear()
+{
+    _clearLabels();
+    _disabled.clear();
+}
+
+void CNavMeshIslands::_clearLabels()
+{
+    _labels.clear();
+    _salts.clear();
+    _islandSizes.clear();
+    _navMesh = nullptr;
+}
+
+unsigned int CNavMeshIslands::getIsland(dtPolyRef ref) const
+{
+    if (!_navMesh || !ref)
+        return 0;
+
+    const unsigned int tileIndex = _navMesh->decodePolyIdTile(ref);
+    const unsigned int polyIndex = _navMesh->decodePolyIdPoly(ref);
+    if (tileIndex >= _labels.size() || polyIndex >= _labels[tileIndex].size() ||
+        _salts[tileIndex] != _navMesh->decodePolyIdSalt(ref))
+    {
+        return 0;
+    }
+    return _labels[tileIndex][polyIndex];
+}
+
+bool CNavMeshIslands::isReachable(dtPolyRef a, dtPolyRef b) const
+{
+    const unsigned int islandA = getIsland(a);
+    const unsigned int islandB = getIsland(b);
+
+    // Unknown polygons are never rejected
+    return islandA == 0 || islandB == 0 || islandA == islandB;
+}
+
+int CNavMeshIslands::disableSmallIslands(dtNavMesh* navMesh, const int minPolys, const unsigned short disabledFlags)
+{
+    if (!navMesh || navMesh != _navMesh || minPolys <= 1)
+        return 0;
+
+    int disabled = 0;
+    for (size_t i = 0; i < _labels.size(); ++i)
+    {
+        const dtMeshTile* tile = navMesh->getTile((int)i);
+        if (!tile || !tile->header)
+            continue;
+
+        const dtPolyRef base = navMesh->getPolyRefBase(tile);
+        for (size_t p = 0; p < _labels[i].size(); ++p)
+        {
+            const unsigned int island = _labels[i][p];
+            if (island == 0 || _islandSizes[island] >= minPolys)
+                continue;
+
+            DisabledPoly entry;
+            entry.Ref = base | (dtPolyRef)p;
+            entry.Flags = tile->polys[p].flags;
+            entry.Disabled = disabledFlags;
+            _disabled.push_back(entry);
+
+            navMesh->setPolyFlags(entry.Ref, disabledFlags);
+            _labels[i][p] = 0;
+            ++disabled;
+        }
+    }
+
+    for (size_t island = 1; island < _islandSizes.size(); ++island)
+    {
+        if (_islandSizes[island] < minPolys)
+            _islandSizes[island] = 0;
+    }
+    return disabled;
+}
+
+int CNavMeshIslands::restoreDisabled(dtNavMesh* navMesh)
+{
+    int restored = 0;
+    for (const DisabledPoly& entry : _disabled)
+    {
+        // A rebuilt tile has a new salt, so its old refs are no longer valid
+        unsigned short flags = 0;
+        if (!navMesh || dtStatusFailed(navMesh->getPolyFlags(entry.Ref, &flags)) || flags != entry.Disabled)
+            continue;
+
+        navMesh->setPolyFlags(entry.Ref, entry.Flags);
+        ++restored;
+    }
+
+    _disabled.clear();
+    return restored;
+}
@@ -0,0 +1,511 @@
+#include "IrrRecastDetour/CNavQueryContext.h"
+#include "IrrRecastDetour/CNavMeshIslands.h"
+#include "IrrRecastDetour/CPathCache.h"
+#include <algorithm>
+#include <cfloat>
+#include <functional>
+#include "DetourCommon.h"
+#include "DetourGraphUtils.h"
+
+namespace
+{
+    // Search extents for finding nearest polygons (X, Y, Z half sizes)
+    const float SEARCH_EXTENTS[3] = { 2.0f, 4.0f, 2.0f };
+}
+
+CNavQueryContext::CNavQueryContext(const dtNavMesh* navMesh, int maxNodes)
+    : _distanceSearch(new CPolySearch())
+{
+    // Query filter - which polygon types we can walk on
+    _filter.setIncludeFlags((unsigned short)PolyFlags::WALK | (unsigned short)PolyFlags::DOOR);
+    _filter.setExcludeFlags(0);
+    _filterId = ((unsigned int)_filter.getIncludeFlags() << 16) | _filter.getExcludeFlags();
+
+    if (!navMesh)
+    {
+        printf("ERROR: CNavQueryContext: NavMesh is null.\n");
+        return;
+    }
+
+    _navQuery.reset(dtAllocNavMeshQuery());
+    if (!_navQuery || dtStatusFailed(_navQuery->init(navMesh, maxNodes)))
+    {
+        printf("ERROR: CNavQueryContext: Could not init Detour navmesh query.\n");
+        _navQuery.reset();
+        return;
+    }
+    _maxNodes = maxNodes;
+
+    // Enough for typical paths; grown on demand (see findPath() and straightenPath())
+    const int INITIAL_PATH_SIZE = 256;
+    _polys.resize(std::min(INITIAL_PATH_SIZE, maxNodes));
+    _straightPath.resize(INITIAL_PATH_SIZE * 3);
+    _straightPathFlags.resize(INITIAL_PATH_SIZE);
+    _straightPathPolys.resize(INITIAL_PATH_SIZE);
+}
+
+CNavQueryContext::~CNavQueryContext()
+{
+}
+
+dtPolyRef CNavQueryContext::findNearestPoly(const irr::core::vector3df& pos, float* nearestPoint)
+{
+    if (!_navQuery)
+        return 0;
+
+    float queryPos[3] = { pos.X, pos.Y, pos.Z };
+    float nearest[3] = { 0, 0, 0 };
+    dtPolyRef ref = 0;
+
+    if (dtStatusFailed(_navQuery->findNearestPoly(queryPos, SEARCH_EXTENTS, &_filter, &ref, nearest)))
+        return 0;
+
+    if (ref && nearestPoint)
+        dtVcopy(nearestPoint, nearest);
+    return ref;
+}
+
+void CNavQueryContext::getPortalMidpoint(
+    const dtPolyRef fromRef, const dtMeshTile* fromTile, const dtPoly* fromPoly, const dtLink& link,
+    const dtMeshTile* toTile, const dtPoly* toPoly,
+    float* mid)
+{
+    // Links of an off-mesh connection name the end vertex they attach to
+    if (fromPoly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+    {
+        dtVcopy(mid, &fromTile->verts[fromPoly->verts[link.edge] * 3]);
+        return;
+    }
+    if (toPoly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+    {
+        const dtLink* back = findPolyLink(toTile, toPoly, fromRef);
+        dtVcopy(mid, &toTile->verts[toPoly->verts[back ? back->edge : 0] * 3]);
+        return;
+    }
+
+    const float* v0 = &fromTile->verts[fromPoly->verts[link.edge] * 3];
+    const float* v1 = &fromTile->verts[fromPoly->verts[(link.edge + 1) % fromPoly->vertCount] * 3];
+
+    // A link across a tile border may cover only part of the edge
+    float tmin = 0.0f;
+    float tmax = 1.0f;
+    if (link.side != 0xff && (link.bmin != 0 || link.bmax != 255))
+    {
+        tmin = link.bmin / 255.0f;
+        tmax = link.bmax / 255.0f;
+    }
+    dtVlerp(mid, v0, v1, (tmin + tmax) * 0.5f);
+}
+
+irr::core::vector3df CNavQueryContext::getClosestPointOnNavmesh(const irr::core::vector3df& pos)
+{
+    float nearestPoint[3];
+    if (findNearestPoly(pos, nearestPoint))
+    {
+        return irr::core::vector3df(nearestPoint[0], nearestPoint[1], nearestPoint[2]);
+    }
+
+    // If query failed, return original position
+    return pos;
+}
+
+std::vector<irr::core::vector3df> CNavQueryContext::GetPath(const irr::core::vector3df& startPos, const irr::core::vector3df& endPos)
+{
+    if (_isFound(findPath(startPos, endPos, _scratch)))
+    {
+        return _scratch.Waypoints;
+    }
+
+    _printPathError("GetPath", _scratch.Status);
+    return std::vector<irr::core::vector3df>();
+}
+
+int CNavQueryContext::GetPath(
+    const irr::core::vector3df& startPos,
+    const irr::core::vector3df& endPos,
+    irr::core::vector3df* waypoints, const int maxWaypoints,
+    float* distance,
+    unsigned char* flags,
+    dtPolyRef* polys)
+{
+    if (distance)
+        *distance = -1.0f;
+
+    float startNearest[3];
+    float endNearest[3];
+    dtPolyRef endRef = 0;
+    int polyCount = 0;
+    int count = 0;
+
+    if (!_isFound(_findCorridor(startPos, endPos, startNearest, endNearest, endRef, polyCount)) ||
+        !_isFound(_straighten(startNearest, endNearest, _polys.data(), polyCount, endRef, count)))
+    {
+        return -1;
+    }
+
+    if (distance)
+        *distance = _getStraightPathLength(count);
+
+    const int written = std::min(count, maxWaypoints);
+    for (int i = 0; i < written; ++i)
+    {
+        const float* point = &_straightPath[i * 3];
+        waypoints[i].set(point[0], point[1], point[2]);
+        if (flags)
+            flags[i] = _straightPathFlags[i];
+        if (polys)
+            polys[i] = _straightPathPolys[i];
+    }
+    return written;
+}
+
+float CNavQueryContext::GetPathDistance(const irr::core::vector3df& startPos, const irr::core::vector3df& endPos)
+{
+    float startNearest[3];
+    float endNearest[3];
+    dtPolyRef endRef = 0;
+    int polyCount = 0;
+    int count = 0;
+
+    // Only the length is needed, so no waypoints are copied out
+    PathStatus status = _findCorridor(startPos, endPos, startNearest, endNearest, endRef, polyCount);
+    if (_isFound(status))
+        status = _straighten(startNearest, endNearest, _polys.data(), polyCount, endRef, count);
+
+    if (!_isFound(status))
+    {
+        _printPathError("GetPathDistance", status);
+        return -1.0f;
+    }
+
+    return _getStraightPathLength(count);
+}
+
+int CNavQueryContext::GetPathDistances(
+    const irr::core::vector3df& startPos,
+    const irr::core::vector3df* targets, const int count,
+    float* distances,
+    const float maxCost)
+{
+    for (int i = 0; i < count; ++i)
+        distances[i] = -1.0f;
+
+    float startNearest[3];
+    const dtPolyRef startRef = findNearestPoly(startPos, startNearest);
+    if (!startRef)
+        return -1;
+
+    const dtNavMesh* navMesh = _navQuery->getAttachedNavMesh();
+
+    CPolySearch& search = *_distanceSearch;
+    search.clear();
+
+    // Snap the targets and mark their polygons, so the search knows when to stop
+    _targetRefs.resize(count);
+    _targetNearest.resize(count * 3);
+    int targetsLeft = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        _targetRefs[i] = findNearestPoly(targets[i], &_targetNearest[i * 3]);
+        if (!_targetRefs[i])
+            continue;
+
+        // Targets on another island are never settled, so they must not hold the search open
+        if (!isReachable(startRef, _targetRefs[i]))
+        {
+            _targetRefs[i] = 0;
+            continue;
+        }
+
+        CPolySearch::Node& node = search[search.getNode(_targetRefs[i])];
+        if (!node.Target)
+        {
+            node.Target = true;
+            ++targetsLeft;
+        }
+    }
+    if (targetsLeft == 0)
+        return 0;
+
+    search.addStart(startRef, startNearest);
+    search.run(navMesh, _filter, false, maxCost,
+        [](dtPolyRef, const dtMeshTile*, const dtPoly*) { return true; },
+        [&](int node)
+        {
+            if (search[node].Target)
+                --targetsLeft;
+            return targetsLeft > 0;
+        });
+
+    // Straighten the corridor of every reached target for its real length
+    int reached = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (!_targetRefs[i])
+            continue;
+
+        const int targetIndex = search.findNode(_targetRefs[i]);
+        if (!search[targetIndex].Closed)
+            continue;
+
+        int polyCount = 0;
+        for (int n = targetIndex; n >= 0; n = search[n].Parent)
+            ++polyCount;
+        if ((int)_polys.size() < polyCount)
+            _polys.resize(polyCount);
+
+        int p = polyCount;
+        for (int n = targetIndex; n >= 0; n = search[n].Parent)
+            _polys[--p] = search[n].Ref;
+
+        int straightCount = 0;
+        if (_isFound(_straighten(startNearest, &_targetNearest[i * 3], _polys.data(), polyCount, _targetRefs[i], straightCount)))
+        {
+            distances[i] = _getStraightPathLength(straightCount);
+            ++reached;
+        }
+    }
+    return reached;
+}
+
+PathStatus CNavQueryContext::findPath(
+    const irr::core::vector3df& startPos,
+    const irr::core::vector3df& endPos,
+    PathResult& result)
+{
+    float startNearest[3];
+    float endNearest[3];
+    dtPolyRef endRef = 0;
+    int polyCount = 0;
+
+    const PathStatus status = _findCorridor(startPos, endPos, startNearest, endNearest, endRef, polyCount);
+    if (!_isFound(status))
+    {
+        _setResult(status, 0, result);
+        return result.Status;
+    }
+
+    return straightenPath(startNearest, endNearest, _polys.data(), polyCount, endRef, result);
+}
+
+PathStatus CNavQueryContext::finishSlicedFindPath(
+    const float* startPos, const float* endPos,
+    const dtPolyRef endRef,
+    PathResult& result)
+{
+    // A sliced search is bounded by the node pool as well, so the corridor always fits
+    if ((int)_polys.size() < _maxNodes)
+        _polys.resize(_maxNodes);
+
+    int polyCount = 0;
+    dtStatus status = _navQuery ? _navQuery->finalizeSlicedFindPath(_polys.data(), &polyCount, (int)_polys.size()) : DT_FAILURE;
+    if (dtStatusFailed(status) || polyCount == 0)
+    {
+        _setResult(_navQuery ? PathStatus::NO_PATH : PathStatus::NO_NAVMESH, 0, result);
+        return result.Status;
+    }
+
+    _storeCorridor(_polys.data(), polyCount, endRef);
+    return straightenPath(startPos, endPos, _polys.data(), polyCount, endRef, result);
+}
+
+PathStatus CNavQueryContext::straightenPath(
+    const float* startPos, const float* endPos,
+    const dtPolyRef* polys, const int polyCount,
+    const dtPolyRef endRef,
+    PathResult& result)
+{
+    int count = 0;
+    const PathStatus status = _straighten(startPos, endPos, polys, polyCount, endRef, count);
+    _setResult(status, _isFound(status) ? count : 0, result);
+    return result.Status;
+}
+
+PathStatus CNavQueryContext::_findCorridor(
+    const irr::core::vector3df& startPos,
+    const irr::core::vector3df& endPos,
+    float* startNearest, float* endNearest,
+    dtPolyRef& endRef, int& polyCount)
+{
+    polyCount = 0;
+
+    if (!_navQuery)
+        return PathStatus::NO_NAVMESH;
+
+    const dtPolyRef startRef = findNearestPoly(startPos, startNearest);
+    if (!startRef)
+        return PathStatus::NO_START_POLY;
+
+    endRef = findNearestPoly(endPos, endNearest);
+    if (!endRef)
+        return PathStatus::NO_END_POLY;
+
+    // Different islands: the search would only exhaust the start's island
+    if (!isReachable(startRef, endRef))
+        return PathStatus::NO_PATH;
+
+    // A cached corridor skips the search
+    if (_pathCache)
+    {
+        polyCount = _pathCache->find(startRef, endRef, _filterId, _polys);
+        if (polyCount > 0)
+            return PathStatus::SUCCESS;
+    }
+
+    // Find the path (as a series of polygon references)
+    dtStatus status = _navQuery->findPath(startRef, endRef, startNearest, endNearest, &_filter, _polys.data(), &polyCount, (int)_polys.size());
+
+    // The corridor never has more polygons than the search has nodes, so one
+    // retry with a buffer of that size always fits
+    if (dtStatusDetail(status, DT_BUFFER_TOO_SMALL) && (int)_polys.size() < _maxNodes)
+    {
+        _polys.resize(_maxNodes);
+        status = _navQuery->findPath(startRef, endRef, startNearest, endNearest, &_filter, _polys.data(), &polyCount, (int)_polys.size());
+    }
+
+    if (dtStatusFailed(status) || polyCount == 0)
+        return PathStatus::NO_PATH;
+
+    _storeCorridor(_polys.data(), polyCount, endRef);
+    return PathStatus::SUCCESS;
+}
+
+bool CNavQueryContext::isReachable(dtPolyRef a, dtPolyRef b) const
+{
+    return !_islands || _islands->isReachable(a, b);
+}
+
+void CNavQueryContext::_storeCorridor(const dtPolyRef* polys, const int polyCount, const dtPolyRef endRef)
+{
+    // Partial corridors depend on the exact target position, so only complete ones are kept
+    if (_pathCache && polyCount > 0 && polys[polyCount - 1] == endRef)
+    {
+        _pathCache->store(polys[0], endRef, _filterId, polys, polyCount);
+    }
+}
+
+bool CNavQueryContext::findCachedPath(
+    const float* startPos, const float* endPos,
+    const dtPolyRef startRef, const dtPolyRef endRef,
+    PathResult& result)
+{
+    if (!_pathCache)
+        return false;
+
+    const int polyCount = _pathCache->find(startRef, endRef, _filterId, _polys);
+    if (polyCount == 0)
+        return false;
+
+    straightenPath(startPos, endPos, _polys.data(), polyCount, endRef, result);
+    return true;
+}
+
+PathStatus CNavQueryContext::_straighten(
+    const float* startPos, const float* endPos,
+    const dtPolyRef* polys, const int polyCount,
+    const dtPolyRef endRef,
+    int& count)
+{
+    count = 0;
+
+    if (!_navQuery)
+        return PathStatus::NO_NAVMESH;
+    if (polyCount == 0)
+        return PathStatus::NO_PATH;
+
+    float endNearest[3];
+    dtVcopy(endNearest, endPos);
+
+    // A partial path ends at the polygon closest to the target
+    const bool partial = polys[polyCount - 1] != endRef;
+    if (partial)
+    {
+        _navQuery->closestPointOnPoly(polys[polyCount - 1], endNearest, endNearest, nullptr);
+    }
+
+    // Convert polygon path to actual waypoints. A truncated straight path is
+    // redone with a bigger buffer; the buffer keeps its size for later calls.
+    dtStatus status;
+    for (;;)
+    {
+        status = _navQuery->findStraightPath(
+            startPos, endNearest,
+            polys, polyCount,
+            _straightPath.data(), _straightPathFlags.data(), _straightPathPolys.data(),
+            &count, (int)_straightPathFlags.size(),
+            DT_STRAIGHTPATH_AREA_CROSSINGS
+        );
+
+        if (dtStatusFailed(status) || !dtStatusDetail(status, DT_BUFFER_TOO_SMALL))
+            break;
+
+        const size_t newSize = _straightPathFlags.size() * 2;
+        _straightPath.resize(newSize * 3);
+        _straightPathFlags.resize(newSize);
+        _straightPathPolys.resize(newSize);
+    }
+
+    if (dtStatusFailed(status) || count == 0)
+    {
+        count = 0;
+        return PathStatus::NO_PATH;
+    }
+
+    return partial ? PathStatus::PARTIAL : PathStatus::SUCCESS;
+}
+
+float CNavQueryContext::_getStraightPathLength(const int count) const
+{
+    float length = 0.0f;
+    for (int i = 1; i < count; ++i)
+    {
+        length += dtVdist(&_straightPath[(i - 1) * 3], &_straightPath[i * 3]);
+    }
+    return length;
+}
+
+void CNavQueryContext::_setResult(const PathStatus status, const int count, PathResult& result) const
+{
+    // clear() keeps the capacity, so a reused result does not allocate
+    result.Status = status;
+    result.Waypoints.clear();
+    result.Flags.clear();
+    result.Polys.clear();
+    result.Distance = -1.0f;
+
+    if (count == 0)
+        return;
+
+    result.Waypoints.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        const float* point = &_straightPath[i * 3];
+        result.Waypoints.push_back(irr::core::vector3df(point[0], point[1], point[2]));
+    }
+    result.Distance = _getStraightPathLength(count);
+
+    if (result.IncludeDetails)
+    {
+        result.Flags.assign(_straightPathFlags.begin(), _straightPathFlags.begin() + count);
+        result.Polys.assign(_straightPathPolys.begin(), _straightPathPolys.begin() + count);
+    }
+}
+
+void CNavQueryContext::_printPathError(const char* method, PathStatus status) const
+{
+    switch (status)
+    {
+    case PathStatus::NO_NAVMESH:
+        printf("ERROR: CNavQueryContext::%s: NavQuery or NavMesh is null.\n", method);
+        break;
+    case PathStatus::NO_START_POLY:
+        printf("ERROR: CNavQueryContext::%s: Could not find start polygon.\n", method);
+        break;
+    case PathStatus::NO_END_POLY:
+        printf("ERROR: CNavQueryContext::%s: Could not find end polygon.\n", method);
+        break;
+    default:
+        printf("ERROR: CNavQueryContext::%s: Could not find path.\n", method);
+        break;
+    }
+}
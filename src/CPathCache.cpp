@@ -0,0 +1,130 @@
+#include "IrrRecastDetour/CPathCache.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+size_t CPathCache::KeyHash::operator()(const Key& key) const
+{
+    size_t h = std::hash<unsigned long long>()((unsigned long long)key.StartRef);
+    h ^= std::hash<unsigned long long>()((unsigned long long)key.EndRef) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= std::hash<unsigned int>()(key.FilterId) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h;
+}
+
+void CPathCache::setCapacity(size_t entries)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _capacity = entries;
+    _evictToCapacity();
+}
+
+size_t CPathCache::getCapacity() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _capacity;
+}
+
+bool CPathCache::isEnabled() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _capacity > 0;
+}
+
+int CPathCache::find(dtPolyRef startRef, dtPolyRef endRef, unsigned int filterId, std::vector<dtPolyRef>& polys)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_capacity == 0)
+        return 0;
+
+    auto it = _index.find(Key{ startRef, endRef, filterId });
+    if (it == _index.end())
+    {
+        ++_misses;
+        return 0;
+    }
+
+    // Move to the front (most recently used)
+    _entries.splice(_entries.begin(), _entries, it->second);
+
+    const std::vector<dtPolyRef>& cached = it->second->Polys;
+    if (polys.size() < cached.size())
+        polys.resize(cached.size());
+    std::copy(cached.begin(), cached.end(), polys.begin());
+
+    ++_hits;
+    return (int)cached.size();
+}
+
+void CPathCache::store(dtPolyRef startRef, dtPolyRef endRef, unsigned int filterId, const dtPolyRef* polys, const int polyCount)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_capacity == 0 || polyCount <= 0)
+        return;
+
+    const Key key{ startRef, endRef, filterId };
+    auto it = _index.find(key);
+    if (it != _index.end())
+    {
+        it->second->Polys.assign(polys, polys + polyCount);
+        _entries.splice(_entries.begin(), _entries, it->second);
+        return;
+    }
+
+    // Reuse the storage of the evicted entry when full
+    if (_index.size() >= _capacity)
+    {
+        auto last = std::prev(_entries.end());
+        _index.erase(last->EntryKey);
+        _entries.splice(_entries.begin(), _entries, last);
+    }
+    else
+    {
+        _entries.emplace_front();
+    }
+
+    Entry& entry = _entries.front();
+    entry.EntryKey = key;
+    entry.Polys.assign(polys, polys + polyCount);
+    _index[key] = _entries.begin();
+}
+
+void CPathCache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.clear();
+    _index.clear();
+}
+
+size_t CPathCache::getHits() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _hits;
+}
+
+size_t CPathCache::getMisses() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _misses;
+}
+
+size_t CPathCache::getSize() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _index.size();
+}
+
+void CPathCache::resetStats()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _hits = 0;
+    _misses = 0;
+}
+
+void CPathCache::_evictToCapacity()
+{
+    while (_index.size() > _capacity)
+    {
+        _index.erase(_entries.back().EntryKey);
+        _entries.pop_back();
+    }
+}
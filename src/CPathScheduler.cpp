@@ -0,0 +1,216 @@
+#include "IrrRecastDetour/CPathScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include "DetourCommon.h"
+
+namespace
+{
+    // Iterations run between two clock reads when a time budget is set
+    const int ITERATIONS_PER_SLICE = 32;
+}
+
+void CPathScheduler::setQuery(std::unique_ptr<CNavQueryContext> query)
+{
+    _query = std::move(query);
+
+    // Polygon refs of a search in progress belong to the old navmesh
+    restart();
+}
+
+void CPathScheduler::restart()
+{
+    if (!_queue.empty())
+        _queue.front().Started = false;
+}
+
+unsigned int CPathScheduler::request(
+    const irr::core::vector3df& startPos,
+    const irr::core::vector3df& endPos,
+    Callback callback)
+{
+    Request request;
+    request.Id = _nextId++;
+    if (_nextId == 0)
+        _nextId = 1;
+    request.Start = startPos;
+    request.End = endPos;
+    request.OnDone = std::move(callback);
+
+    _queue.push_back(std::move(request));
+    return _queue.back().Id;
+}
+
+bool CPathScheduler::poll(unsigned int requestId, PathResult& result)
+{
+    auto it = _results.find(requestId);
+    if (it == _results.end())
+        return false;
+
+    result = std::move(it->second);
+    _results.erase(it);
+    return true;
+}
+
+bool CPathScheduler::isPending(unsigned int requestId) const
+{
+    for (const Request& request : _queue)
+    {
+        if (request.Id == requestId)
+            return true;
+    }
+    return false;
+}
+
+bool CPathScheduler::cancel(unsigned int requestId)
+{
+    if (_results.erase(requestId) > 0)
+        return true;
+
+    for (auto it = _queue.begin(); it != _queue.end(); ++it)
+    {
+        if (it->Id == requestId)
+        {
+            // Dropping the front request abandons its sliced search; the next one re-inits the query
+            _queue.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void CPathScheduler::clear()
+{
+    _queue.clear();
+    _results.clear();
+}
+
+void CPathScheduler::setBudget(int maxIterations, float maxMicroseconds)
+{
+    _maxIterations = std::max(0, maxIterations);
+    _maxMicroseconds = std::max(0.0f, maxMicroseconds);
+}
+
+void CPathScheduler::update()
+{
+    if (!_query || _queue.empty())
+        return;
+
+    const auto startTime = std::chrono::steady_clock::now();
+    int iterationsLeft = _maxIterations > 0 ? _maxIterations : INT_MAX;
+    bool firstSlice = true;
+
+    // Callbacks run inside the loop and may rebuild or load the navmesh, which
+    // replaces or drops the query, so it is looked up afresh every iteration
+    while (_query && !_queue.empty())
+    {
+        // Stop when the budget is spent, but always run at least one slice
+        if (!firstSlice)
+        {
+            if (iterationsLeft <= 0)
+                break;
+            if (_maxMicroseconds > 0.0f)
+            {
+                const float elapsedUs = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+                if (elapsedUs >= _maxMicroseconds)
+                    break;
+            }
+        }
+        firstSlice = false;
+
+        Request& request = _queue.front();
+        if (!request.Started && !_startRequest(request))
+        {
+            _finishRequest();
+            continue;
+        }
+
+        int sliceIterations = std::max(1, iterationsLeft);
+        if (_maxMicroseconds > 0.0f)
+            sliceIterations = std::min(sliceIterations, ITERATIONS_PER_SLICE);
+
+        int doneIterations = 0;
+        dtStatus status = _query->getQuery()->updateSlicedFindPath(sliceIterations, &doneIterations);
+        iterationsLeft -= std::max(1, doneIterations);
+
+        if (dtStatusInProgress(status))
+            continue;
+
+        if (dtStatusFailed(status))
+        {
+            _setFailure(PathStatus::NO_PATH);
+        }
+        else
+        {
+            _query->finishSlicedFindPath(request.StartNearest, request.EndNearest, request.EndRef, _result);
+        }
+        _finishRequest();
+    }
+}
+
+bool CPathScheduler::_startRequest(Request& request)
+{
+    request.StartRef = _query->findNearestPoly(request.Start, request.StartNearest);
+    if (!request.StartRef)
+    {
+        _setFailure(PathStatus::NO_START_POLY);
+        return false;
+    }
+
+    request.EndRef = _query->findNearestPoly(request.End, request.EndNearest);
+    if (!request.EndRef)
+    {
+        _setFailure(PathStatus::NO_END_POLY);
+        return false;
+    }
+
+    if (!_query->isReachable(request.StartRef, request.EndRef))
+    {
+        _setFailure(PathStatus::NO_PATH);
+        return false;
+    }
+
+    // A cached corridor finishes the request right away
+    if (_query->findCachedPath(request.StartNearest, request.EndNearest, request.StartRef, request.EndRef, _result))
+        return false;
+
+    dtStatus status = _query->getQuery()->initSlicedFindPath(
+        request.StartRef, request.EndRef,
+        request.StartNearest, request.EndNearest,
+        &_query->getFilter()
+    );
+    if (dtStatusFailed(status))
+    {
+        _setFailure(PathStatus::NO_PATH);
+        return false;
+    }
+
+    request.Started = true;
+    return true;
+}
+
+void CPathScheduler::_setFailure(PathStatus status)
+{
+    // clear() keeps the capacity, so the reused result does not allocate
+    _result.Status = status;
+    _result.Waypoints.clear();
+    _result.Flags.clear();
+    _result.Polys.clear();
+    _result.Distance = -1.0f;
+}
+
+void CPathScheduler::_finishRequest()
+{
+    // Pop first, so the callback may queue new requests
+    Request request = std::move(_queue.front());
+    _queue.pop_front();
+
+    if (request.OnDone)
+    {
+        request.OnDone(request.Id, _result);
+    }
+    else
+    {
+        _results[request.Id] = _result;
+    }
+}
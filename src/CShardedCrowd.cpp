@@ -0,0 +1,391 @@
+#include "IrrRecastDetour/CShardedCrowd.h"
+#include "IrrRecastDetour/CWorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include "DetourCommon.h"
+
+CShardedCrowd::CShardedCrowd() {}
+
+CShardedCrowd::~CShardedCrowd() {}
+
+bool CShardedCrowd::init(const CrowdParams& params, float maxAgentRadius, dtNavMesh* navMesh)
+{
+    const int maxAgents = std::max(params.MaxAgents, 1);
+    _slots.assign(maxAgents, Slot());
+    _firstFree = 0;
+    _shards.clear();
+    _ghosts.clear();
+    _ghostIndex.clear();
+
+    _cols = std::max(params.ShardCols, 1);
+    _rows = std::max(params.ShardRows, 1);
+    _ghostMargin = params.GhostMargin > 0.0f ? params.GhostMargin : maxAgentRadius * 12.0f;
+
+    // The shard grid covers the bounds of every tile
+    float bmax[3] = { 0.0f, 0.0f, 0.0f };
+    dtVset(_bmin, 0.0f, 0.0f, 0.0f);
+    bool first = true;
+    const dtNavMesh* mesh = navMesh;
+    for (int i = 0; mesh && i < mesh->getMaxTiles(); ++i)
+    {
+        const dtMeshTile* tile = mesh->getTile(i);
+        if (!tile || !tile->header)
+            continue;
+
+        if (first)
+        {
+            dtVcopy(_bmin, tile->header->bmin);
+            dtVcopy(bmax, tile->header->bmax);
+            first = false;
+        }
+        else
+        {
+            dtVmin(_bmin, tile->header->bmin);
+            dtVmax(bmax, tile->header->bmax);
+        }
+    }
+    _cellW = std::max((bmax[0] - _bmin[0]) / _cols, 0.001f);
+    _cellH = std::max((bmax[2] - _bmin[2]) / _rows, 0.001f);
+
+    // Agents gather in some shards more than others, so each gets room for
+    // twice its share, plus its ghosts
+    const int shardCount = _cols * _rows;
+    int capacity = params.AgentsPerShard;
+    if (capacity <= 0)
+        capacity = shardCount == 1 ? maxAgents : std::min(maxAgents, 2 * maxAgents / shardCount + 64);
+
+    // More threads than shards would have nothing to do
+    _threadCount = std::min(CWorkerPool::resolveThreadCount(params.ThreadCount), shardCount);
+    _workers.reset(_threadCount > 1 ? new CWorkerPool(_threadCount - 1) : nullptr);
+
+    _shards.resize(shardCount);
+    for (Shard& shard : _shards)
+    {
+        shard.Crowd.reset(dtAllocCrowd());
+        if (!shard.Crowd || !shard.Crowd->init(capacity, maxAgentRadius, navMesh))
+            return false;
+        shard.Capacity = capacity;
+    }
+    return true;
+}
+
+int CShardedCrowd::addAgent(const float* pos, const dtCrowdAgentParams* params)
+{
+    // Like dtCrowd, hand out the lowest free id
+    int id = _firstFree;
+    while (id < (int)_slots.size() && _slots[id].Shard >= 0)
+        ++id;
+    if (id >= (int)_slots.size())
+        return -1;
+
+    // A full shard overflows into any other; the agent migrates home later
+    int shard = _shardAt(pos);
+    int local = _addToShard(shard, pos, params);
+    for (int i = 0; local < 0 && i < (int)_shards.size(); ++i)
+    {
+        shard = i;
+        local = _addToShard(shard, pos, params);
+    }
+    if (local < 0)
+        return -1;
+
+    _slots[id].Shard = shard;
+    _slots[id].Local = local;
+    _firstFree = id + 1;
+    return id;
+}
+
+void CShardedCrowd::removeAgent(const int idx)
+{
+    if (!_isActive(idx))
+        return;
+
+    _removeGhostsOf(idx);
+    _removeFromShard(_slots[idx].Shard, _slots[idx].Local);
+    _slots[idx] = Slot();
+    _firstFree = std::min(_firstFree, idx);
+}
+
+const dtCrowdAgent* CShardedCrowd::getAgent(const int idx)
+{
+    return _isActive(idx) ? _shards[_slots[idx].Shard].Crowd->getAgent(_slots[idx].Local) : nullptr;
+}
+
+dtCrowdAgent* CShardedCrowd::getEditableAgent(const int idx)
+{
+    return _isActive(idx) ? _shards[_slots[idx].Shard].Crowd->getEditableAgent(_slots[idx].Local) : nullptr;
+}
+
+bool CShardedCrowd::requestMoveTarget(const int idx, dtPolyRef ref, const float* pos)
+{
+    return _isActive(idx) && _shards[_slots[idx].Shard].Crowd->requestMoveTarget(_slots[idx].Local, ref, pos);
+}
+
+bool CShardedCrowd::requestMoveVelocity(const int idx, const float* vel)
+{
+    return _isActive(idx) && _shards[_slots[idx].Shard].Crowd->requestMoveVelocity(_slots[idx].Local, vel);
+}
+
+bool CShardedCrowd::resetMoveTarget(const int idx)
+{
+    return _isActive(idx) && _shards[_slots[idx].Shard].Crowd->resetMoveTarget(_slots[idx].Local);
+}
+
+void CShardedCrowd::setExcludeFlags(unsigned short flags)
+{
+    for (Shard& shard : _shards)
+        shard.Crowd->getEditableFilter(0)->setExcludeFlags(flags);
+}
+
+int CShardedCrowd::getShardOf(const int idx) const
+{
+    return _isActive(idx) ? _slots[idx].Shard : -1;
+}
+
+void CShardedCrowd::update(const float dt)
+{
+    if (_shards.size() == 1)
+    {
+        _shards[0].Crowd->update(dt, nullptr);
+        return;
+    }
+
+    _migrateAgents();
+    _updateGhosts();
+
+    // The shards only share the navmesh, which updates just read
+    std::atomic<int> next(0);
+    auto work = [this, &next, dt](int)
+    {
+        for (int i = next++; i < (int)_shards.size(); i = next++)
+            _shards[i].Crowd->update(dt, nullptr);
+    };
+
+    if (_workers)
+        _workers->run(_threadCount, work);
+    else
+        work(0);
+}
+
+int CShardedCrowd::_shardAt(const float* pos) const
+{
+    const int col = std::max(0, std::min(_cols - 1, (int)std::floor((pos[0] - _bmin[0]) / _cellW)));
+    const int row = std::max(0, std::min(_rows - 1, (int)std::floor((pos[2] - _bmin[2]) / _cellH)));
+    return col + row * _cols;
+}
+
+int CShardedCrowd::_addToShard(int shard, const float* pos, const dtCrowdAgentParams* params)
+{
+    Shard& target = _shards[shard];
+    if (target.Used >= target.Capacity)
+        return -1;
+
+    const int local = target.Crowd->addAgent(pos, params);
+    if (local >= 0)
+        ++target.Used;
+    return local;
+}
+
+void CShardedCrowd::_removeFromShard(int shard, int local)
+{
+    _shards[shard].Crowd->removeAgent(local);
+    --_shards[shard].Used;
+}
+
+void CShardedCrowd::_migrateAgents()
+{
+    // Agents walking along a border would otherwise hop back and forth
+    const float hysteresis = _ghostMargin * 0.5f;
+
+    for (int id = 0; id < (int)_slots.size(); ++id)
+    {
+        if (_slots[id].Shard < 0)
+            continue;
+
+        // The off-mesh link animation lives in the dtCrowd; migrate after it
+        const dtCrowdAgent* agent = getAgent(id);
+        if (agent->state == DT_CROWDAGENT_STATE_OFFMESH)
+            continue;
+
+        const int home = _shardAt(agent->npos);
+        if (home == _slots[id].Shard)
+            continue;
+
+        const int col = _slots[id].Shard % _cols;
+        const int row = _slots[id].Shard / _cols;
+        const float minX = _bmin[0] + col * _cellW - hysteresis;
+        const float minZ = _bmin[2] + row * _cellH - hysteresis;
+        if (agent->npos[0] >= minX && agent->npos[0] <= minX + _cellW + 2.0f * hysteresis &&
+            agent->npos[2] >= minZ && agent->npos[2] <= minZ + _cellH + 2.0f * hysteresis)
+        {
+            continue;
+        }
+
+        _migrate(id, home);
+    }
+}
+
+bool CShardedCrowd::_migrate(int id, int toShard)
+{
+    // The agent's ghost in the new shard makes room for the agent itself
+    auto ghost = _ghostIndex.find(_ghostKey(id, toShard));
+    if (ghost != _ghostIndex.end())
+        _removeGhost(ghost->second);
+
+    Slot& slot = _slots[id];
+    const dtCrowdAgent* agent = _shards[slot.Shard].Crowd->getAgent(slot.Local);
+    const int local = _addToShard(toShard, agent->npos, &agent->params);
+    if (local < 0)
+        return false;
+
+    dtCrowd* crowd = _shards[toShard].Crowd.get();
+    dtCrowdAgent* moved = crowd->getEditableAgent(local);
+    dtVcopy(moved->vel, agent->vel);
+    dtVcopy(moved->nvel, agent->nvel);
+    dtVcopy(moved->dvel, agent->dvel);
+    moved->desiredSpeed = agent->desiredSpeed;
+
+    // All shards share the navmesh, so the corridor and the corners stay valid
+    // and the agent walks on without replanning. dtLocalBoundary cannot be
+    // copied; the new shard's crowd collects it again on its next update.
+    if (agent->corridor.getPathCount() > 0)
+    {
+        moved->corridor.setCorridor(agent->corridor.getTarget(), agent->corridor.getPath(), agent->corridor.getPathCount());
+        moved->topologyOptTime = agent->topologyOptTime;
+        moved->partial = agent->partial;
+        memcpy(moved->cornerVerts, agent->cornerVerts, sizeof(agent->cornerVerts));
+        memcpy(moved->cornerFlags, agent->cornerFlags, sizeof(agent->cornerFlags));
+        memcpy(moved->cornerPolys, agent->cornerPolys, sizeof(agent->cornerPolys));
+        moved->ncorners = agent->ncorners;
+    }
+
+    moved->targetState = agent->targetState;
+    moved->targetRef = agent->targetRef;
+    dtVcopy(moved->targetPos, agent->targetPos);
+    moved->targetPathqRef = agent->targetPathqRef;
+    moved->targetReplan = agent->targetReplan;
+    moved->targetReplanTime = agent->targetReplanTime;
+
+    // A path request belongs to the old shard's path queue; ask the new one
+    // again, keeping the corridor for the agent to follow meanwhile
+    if (moved->targetState == DT_CROWDAGENT_TARGET_WAITING_FOR_QUEUE ||
+        moved->targetState == DT_CROWDAGENT_TARGET_WAITING_FOR_PATH)
+    {
+        moved->targetState = DT_CROWDAGENT_TARGET_REQUESTING;
+        moved->targetPathqRef = DT_PATHQ_INVALID;
+    }
+
+    // Only an agent without a corridor plans from scratch
+    if (agent->corridor.getPathCount() == 0 && agent->targetRef &&
+        agent->targetState != DT_CROWDAGENT_TARGET_NONE &&
+        agent->targetState != DT_CROWDAGENT_TARGET_FAILED &&
+        agent->targetState != DT_CROWDAGENT_TARGET_VELOCITY)
+    {
+        crowd->requestMoveTarget(local, agent->targetRef, agent->targetPos);
+    }
+
+    _removeFromShard(slot.Shard, slot.Local);
+    slot.Shard = toShard;
+    slot.Local = local;
+    return true;
+}
+
+void CShardedCrowd::_updateGhosts()
+{
+    for (Ghost& ghost : _ghosts)
+        ghost.Seen = false;
+
+    for (int id = 0; id < (int)_slots.size(); ++id)
+    {
+        if (_slots[id].Shard < 0)
+            continue;
+
+        const dtCrowdAgent* agent = getAgent(id);
+        const float* pos = agent->npos;
+
+        // Every shard within the margin of the agent sees a ghost of it
+        const float lo[3] = { pos[0] - _ghostMargin, pos[1], pos[2] - _ghostMargin };
+        const float hi[3] = { pos[0] + _ghostMargin, pos[1], pos[2] + _ghostMargin };
+        const int first = _shardAt(lo);
+        const int last = _shardAt(hi);
+        if (first == last && first == _slots[id].Shard)
+            continue;
+
+        for (int row = first / _cols; row <= last / _cols; ++row)
+        {
+            for (int col = first % _cols; col <= last % _cols; ++col)
+            {
+                const int shard = col + row * _cols;
+                if (shard == _slots[id].Shard)
+                    continue;
+
+                const long long key = _ghostKey(id, shard);
+                auto it = _ghostIndex.find(key);
+                int index = it != _ghostIndex.end() ? it->second : -1;
+                if (index < 0)
+                {
+                    // Moved by its agent, not steered
+                    dtCrowdAgentParams params = agent->params;
+                    params.updateFlags = 0;
+
+                    const int local = _addToShard(shard, pos, &params);
+                    if (local < 0)
+                        continue;
+
+                    index = (int)_ghosts.size();
+                    _ghosts.push_back(Ghost{ id, shard, local, false });
+                    _ghostIndex[key] = index;
+                }
+
+                Ghost& ghost = _ghosts[index];
+                ghost.Seen = true;
+
+                dtCrowd* crowd = _shards[shard].Crowd.get();
+                dtCrowdAgent* mirror = crowd->getEditableAgent(ghost.Local);
+                mirror->corridor.reset(agent->corridor.getFirstPoly(), pos);
+                dtVcopy(mirror->npos, pos);
+                dtVcopy(mirror->vel, agent->vel);
+                dtVcopy(mirror->nvel, agent->nvel);
+                dtVcopy(mirror->dvel, agent->dvel);
+
+                // Avoidance of the other agents reads the velocity the ghost wants
+                crowd->requestMoveVelocity(ghost.Local, agent->vel);
+            }
+        }
+    }
+
+    // Agents that left the margin lose their ghosts
+    for (int i = (int)_ghosts.size() - 1; i >= 0; --i)
+    {
+        if (!_ghosts[i].Seen)
+            _removeGhost(i);
+    }
+}
+
+void CShardedCrowd::_removeGhost(int index)
+{
+    const Ghost ghost = _ghosts[index];
+    _removeFromShard(ghost.Shard, ghost.Local);
+    _ghostIndex.erase(_ghostKey(ghost.AgentId, ghost.Shard));
+
+    // Move the last ghost into the freed slot
+    const int last = (int)_ghosts.size() - 1;
+    if (index != last)
+    {
+        _ghosts[index] = _ghosts[last];
+        _ghostIndex[_ghostKey(_ghosts[index].AgentId, _ghosts[index].Shard)] = index;
+    }
+    _ghosts.pop_back();
+}
+
+void CShardedCrowd::_removeGhostsOf(int id)
+{
+    for (int shard = 0; shard < (int)_shards.size(); ++shard)
+    {
+        auto it = _ghostIndex.find(_ghostKey(id, shard));
+        if (it != _ghostIndex.end())
+            _removeGhost(it->second);
+    }
+}
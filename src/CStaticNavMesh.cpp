@@ -9,7 +9,7 @@ using irr::scene::IMeshSceneNode;
 
 CStaticNavMesh::CStaticNavMesh(irr::scene::ISceneNode* parent, irr::scene::ISceneManager* mgr, irr::s32 id)
     : INavMesh(parent, mgr, id), // Call the base constructor
-    _ctx(new rcContext()),
+    _ctx(new CNavMeshBuildContext()),
     _totalBuildTimeMs(0.0f)
 {
     // Constructor logic specific to StaticNavMesh (if any) goes here.
@@ -29,6 +29,25 @@ bool CStaticNavMesh::build(IMeshSceneNode* levelNode, const NavMeshParams& param
         return false;
     }
 
+    //
+    // Step 1. Extract Irrlicht geometry
+    //
+    std::vector<float> verts;
+    std::vector<int> tris;
+    std::vector<unsigned char> triAreaOverrides;
+    if (!this->_getMeshBufferData(levelNode, verts, tris, triAreaOverrides))
+    {
+        printf("ERROR: StaticNavMesh::build: _getMeshBufferData() failed.\n");
+        return false;
+    }
+
+    // With unchanged geometry, only the stages affected by the new params are rerun
+    BuildStage fromStage = BuildStage::Rasterize;
+    if (_hasCachedBuild && verts == _verts && tris == _tris && triAreaOverrides == _triAreaOverrides)
+    {
+        fromStage = _getRestartStage(params);
+    }
+
     _params = params;
     _totalBuildTimeMs = 0.0f;
 
@@ -36,19 +55,8 @@ bool CStaticNavMesh::build(IMeshSceneNode* levelNode, const NavMeshParams& param
     _defaultAgentRadius = _params.AgentRadius;
     _defaultAgentHeight = _params.AgentHeight;
 
-    // Clear all previous build data
-    // The .reset() calls will trigger the custom deleters on any existing data.
-    _solid.reset();
-    _chf.reset();
-    _cset.reset();
-    _pmesh.reset();
-    _dmesh.reset();
-
     // Clear Detour objects (in base class)
-    _navMesh.reset();
-    _navQuery.reset();
-    _crowd.reset();
-
+    _resetDetour();
 
     // Remove old debug mesh if it exists
     if (_naviDebugData)
@@ -57,17 +65,132 @@ bool CStaticNavMesh::build(IMeshSceneNode* levelNode, const NavMeshParams& param
         _naviDebugData = nullptr;
     }
 
-    //
-    // Step 1. Extract Irrlicht geometry
-    //
-    _verts.clear();
-    _tris.clear();
-    if (!this->_getMeshBufferData(levelNode, _verts, _tris))
+    if (fromStage == BuildStage::Rasterize)
     {
-        printf("ERROR: StaticNavMesh::build: _getMeshBufferData() failed.\n");
-        return false;
+        // Clear all previous build data
+        // The .reset() calls will trigger the custom deleters on any existing data.
+        _solid.reset();
+        _chf.reset();
+        _cset.reset();
+        _pmesh.reset();
+        _dmesh.reset();
+
+        _verts.swap(verts);
+        _tris.swap(tris);
+        _triAreaOverrides.swap(triAreaOverrides);
+    }
+
+    return _buildFromInput(fromStage);
+}
+
+std::shared_future<bool> CStaticNavMesh::buildAsync(IMeshSceneNode* levelNode, const NavMeshParams& params)
+{
+    if (!levelNode)
+    {
+        printf("ERROR: StaticNavMesh::buildAsync: levelNode is null.\n");
+        return std::shared_future<bool>();
+    }
+    if (isBuildPending())
+    {
+        printf("ERROR: StaticNavMesh::buildAsync: A background build is already running.\n");
+        return std::shared_future<bool>();
+    }
+
+    // The worker builds into a detached node, so this one stays usable meanwhile
+    CStaticNavMesh* builder = new CStaticNavMesh(nullptr, SceneManager);
+    builder->_params = params;
+    builder->_defaultAgentRadius = params.AgentRadius;
+    builder->_defaultAgentHeight = params.AgentHeight;
+    builder->_bufferAreas = _bufferAreas;
+    builder->_materialAreas = _materialAreas;
+    builder->_minIslandSize = _minIslandSize;
+    builder->_buildProgressLog = _buildProgressLog;
+    builder->_crowdParams = _crowdParams;
+
+    // Irrlicht meshes are not thread-safe, so the geometry is copied here
+    if (!builder->_getMeshBufferData(levelNode, builder->_verts, builder->_tris, builder->_triAreaOverrides))
+    {
+        printf("ERROR: StaticNavMesh::buildAsync: _getMeshBufferData() failed.\n");
+        builder->drop();
+        return std::shared_future<bool>();
     }
 
+    return _startPendingBuild(builder, [builder]()
+    {
+        return builder->_buildFromInput(BuildStage::Rasterize);
+    });
+}
+
+void CStaticNavMesh::_adoptBuild(INavMesh& other)
+{
+    CStaticNavMesh& builder = static_cast<CStaticNavMesh&>(other);
+
+    _cfg = builder._cfg;
+    _solid = std::move(builder._solid);
+    _chf = std::move(builder._chf);
+    _cset = std::move(builder._cset);
+    _pmesh = std::move(builder._pmesh);
+    _dmesh = std::move(builder._dmesh);
+    _verts.swap(builder._verts);
+    _tris.swap(builder._tris);
+    _triareas.swap(builder._triareas);
+    _triAreaOverrides.swap(builder._triAreaOverrides);
+    _hasCachedBuild = builder._hasCachedBuild;
+    _totalBuildTimeMs = builder._totalBuildTimeMs;
+}
+
+CStaticNavMesh::BuildStage CStaticNavMesh::_getRestartStage(const NavMeshParams& params) const
+{
+    const NavMeshParams& last = _params;
+
+    // Earliest stage that reads a changed parameter
+    BuildStage stage = BuildStage::Detour;
+    if (params.DetailSampleDist != last.DetailSampleDist ||
+        params.DetailSampleMaxError != last.DetailSampleMaxError)
+        stage = BuildStage::DetailMesh;
+    if (params.VertsPerPoly != last.VertsPerPoly)
+        stage = BuildStage::PolyMesh;
+    if (params.EdgeMaxLen != last.EdgeMaxLen ||
+        params.EdgeMaxError != last.EdgeMaxError)
+        stage = BuildStage::Contours;
+    if (params.RegionMinSize != last.RegionMinSize ||
+        params.RegionMergeSize != last.RegionMergeSize ||
+        params.MonotonePartitioning != last.MonotonePartitioning)
+        stage = BuildStage::Regions;
+    if (params.AgentRadius != last.AgentRadius)
+        stage = BuildStage::Compact;
+    if (params.CellSize != last.CellSize ||
+        params.CellHeight != last.CellHeight ||
+        params.AgentHeight != last.AgentHeight ||
+        params.AgentMaxClimb != last.AgentMaxClimb ||
+        params.AgentMaxSlope != last.AgentMaxSlope ||
+        params.KeepInterResults != last.KeepInterResults)
+        stage = BuildStage::Rasterize;
+
+    // Step back while the stage's input was not kept (see KeepInterResults)
+    if (stage == BuildStage::Detour && (!_pmesh || !_dmesh))
+        stage = BuildStage::DetailMesh;
+    if (stage == BuildStage::DetailMesh && (!_pmesh || !_chf))
+        stage = BuildStage::PolyMesh;
+    if (stage == BuildStage::PolyMesh && !_cset)
+        stage = BuildStage::Contours;
+    if (stage == BuildStage::Contours && !_chf)
+        stage = BuildStage::Regions;
+    if (stage == BuildStage::Regions && !_chf)
+        stage = BuildStage::Compact;
+    if (stage == BuildStage::Compact && !_solid)
+        stage = BuildStage::Rasterize;
+
+    return stage;
+}
+
+bool CStaticNavMesh::_buildFromInput(BuildStage fromStage)
+{
+    _buildReport = NavMeshBuildReport();
+
+    // Stages before fromStage reuse their results; the build is only reusable again once it succeeds
+    _hasCachedBuild = false;
+
     int nverts = _verts.size() / 3;
     int ntris = _tris.size() / 3;
 
@@ -107,6 +230,7 @@ bool CStaticNavMesh::build(IMeshSceneNode* levelNode, const NavMeshParams& param
     rcVcopy(_cfg.bmax, bmax);
     rcCalcGridSize(_cfg.bmin, _cfg.bmax, _cfg.cs, &_cfg.width, &_cfg.height);
 
+    _ctx->setProgressLog(_buildProgressLog);
     _ctx->resetTimers();
     _ctx->startTimer(RC_TIMER_TOTAL);
 
@@ -114,139 +238,166 @@ bool CStaticNavMesh::build(IMeshSceneNode* levelNode, const NavMeshParams& param
     _ctx->log(RC_LOG_PROGRESS, " - %d x %d cells", _cfg.width, _cfg.height);
     _ctx->log(RC_LOG_PROGRESS, " - %.1fK verts, %.1fK tris", nverts / 1000.0f, ntris / 1000.0f);
 
-    //
-    // Step 3. Rasterize input polygon soup.
-    //
-    _solid.reset(rcAllocHeightfield());
-    if (!_solid)
+    if (fromStage != BuildStage::Rasterize)
     {
-        _ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'solid'.");
-        return false;
+        static const char* stageNames[] = { "rasterization", "compaction", "regions", "contours", "polymesh", "detail mesh", "Detour data" };
+        _ctx->log(RC_LOG_PROGRESS, " - reusing intermediate results, restarting at %s", stageNames[(int)fromStage]);
     }
-    if (!rcCreateHeightfield(_ctx.get(), *_solid, _cfg.width, _cfg.height, _cfg.bmin, _cfg.bmax, _cfg.cs, _cfg.ch))
-    {
-        _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not create solid heightfield.");
-        return false;
-    }
-
-    _triareas.resize(ntris);
 
-    memset(_triareas.data(), 0, ntris * sizeof(unsigned char));
-    rcMarkWalkableTriangles(_ctx.get(), _cfg.walkableSlopeAngle, _verts.data(), nverts, _tris.data(), ntris, _triareas.data());
-    rcRasterizeTriangles(_ctx.get(), _verts.data(), nverts, _tris.data(), _triareas.data(), ntris, *_solid, _cfg.walkableClimb);
-
-    this->_showHeightFieldInfo(*_solid);
-
-    if (!_params.KeepInterResults)
+    if (fromStage <= BuildStage::Rasterize)
     {
-        _triareas.clear();
-    }
+        //
+        // Step 3. Rasterize input polygon soup.
+        //
+        _solid.reset(rcAllocHeightfield());
+        if (!_solid)
+        {
+            _ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'solid'.");
+            return false;
+        }
+        if (!rcCreateHeightfield(_ctx.get(), *_solid, _cfg.width, _cfg.height, _cfg.bmin, _cfg.bmax, _cfg.cs, _cfg.ch))
+        {
+            _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not create solid heightfield.");
+            return false;
+        }
 
-    //
-    // Step 4. Filter walkables surfaces.
-    //
-    rcFilterLowHangingWalkableObstacles(_ctx.get(), _cfg.walkableClimb, *_solid);
-    rcFilterLedgeSpans(_ctx.get(), _cfg.walkableHeight, _cfg.walkableClimb, *_solid);
-    rcFilterWalkableLowHeightSpans(_ctx.get(), _cfg.walkableHeight, *_solid);
+        _markTriangleAreas(_ctx.get(), _cfg.walkableSlopeAngle, _verts, _tris, _triAreaOverrides, _triareas);
+        rcRasterizeTriangles(_ctx.get(), _verts.data(), nverts, _tris.data(), _triareas.data(), ntris, *_solid, _cfg.walkableClimb);
 
-    //
-    // Step 5. Partition walkable surface to simple regions.
-    //
-    _chf.reset(rcAllocCompactHeightfield());
-    if (!_chf)
-    {
-        _ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'chf'.");
-        return false;
-    }
-    if (!rcBuildCompactHeightfield(_ctx.get(), _cfg.walkableHeight, _cfg.walkableClimb, *_solid, *_chf))
-    {
-        _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build compact data.");
-        return false;
-    }
+        this->_showHeightFieldInfo(*_solid);
+        _noteIntermediateMemory();
 
-    if (!_params.KeepInterResults)
-    {
-        _solid.reset(); // Frees the heightfield
-    }
+        if (!_params.KeepInterResults)
+        {
+            _triareas.clear();
+        }
 
-    if (!rcErodeWalkableArea(_ctx.get(), _cfg.walkableRadius, *_chf))
-    {
-        _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not erode.");
-        return false;
+        //
+        // Step 4. Filter walkables surfaces.
+        //
+        rcFilterLowHangingWalkableObstacles(_ctx.get(), _cfg.walkableClimb, *_solid);
+        rcFilterLedgeSpans(_ctx.get(), _cfg.walkableHeight, _cfg.walkableClimb, *_solid);
+        rcFilterWalkableLowHeightSpans(_ctx.get(), _cfg.walkableHeight, *_solid);
     }
 
-    if (_params.MonotonePartitioning)
+    if (fromStage <= BuildStage::Compact)
     {
-        if (!rcBuildRegionsMonotone(_ctx.get(), *_chf, 0, _cfg.minRegionArea, _cfg.mergeRegionArea))
+        //
+        // Step 5. Partition walkable surface to simple regions.
+        //
+        _chf.reset(rcAllocCompactHeightfield());
+        if (!_chf)
         {
-            _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build regions.");
+            _ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'chf'.");
             return false;
         }
-    }
-    else
-    {
-        if (!rcBuildDistanceField(_ctx.get(), *_chf))
+        if (!rcBuildCompactHeightfield(_ctx.get(), _cfg.walkableHeight, _cfg.walkableClimb, *_solid, *_chf))
         {
-            _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build distance field.");
+            _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build compact data.");
             return false;
         }
-        if (!rcBuildRegions(_ctx.get(), *_chf, 0, _cfg.minRegionArea, _cfg.mergeRegionArea))
+        _noteIntermediateMemory();
+
+        if (!_params.KeepInterResults)
+        {
+            _solid.reset(); // Frees the heightfield
+        }
+
+        if (!rcErodeWalkableArea(_ctx.get(), _cfg.walkableRadius, *_chf))
         {
-            _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build regions.");
+            _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not erode.");
             return false;
         }
     }
 
-    //
-    // Step 6. Trace and simplify region contours.
-    //
-    _cset.reset(rcAllocContourSet());
-    if (!_cset)
+    if (fromStage <= BuildStage::Regions)
     {
-        _ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'cset'.");
-        return false;
-    }
-    if (!rcBuildContours(_ctx.get(), *_chf, _cfg.maxSimplificationError, _cfg.maxEdgeLen, *_cset))
-    {
-        _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not create contours.");
-        return false;
+        if (_params.MonotonePartitioning)
+        {
+            if (!rcBuildRegionsMonotone(_ctx.get(), *_chf, 0, _cfg.minRegionArea, _cfg.mergeRegionArea))
+            {
+                _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build regions.");
+                return false;
+            }
+        }
+        else
+        {
+            if (!rcBuildDistanceField(_ctx.get(), *_chf))
+            {
+                _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build distance field.");
+                return false;
+            }
+            if (!rcBuildRegions(_ctx.get(), *_chf, 0, _cfg.minRegionArea, _cfg.mergeRegionArea))
+            {
+                _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build regions.");
+                return false;
+            }
+        }
+        _noteIntermediateMemory();
     }
-    printf("_cset->nconts=%i\n", _cset->nconts);
 
-    //
-    // Step 7. Build polygons mesh from contours.
-    //
-    _pmesh.reset(rcAllocPolyMesh());
-    if (!_pmesh)
+    if (fromStage <= BuildStage::Contours)
     {
-        _ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'pmesh'.");
-        return false;
-    }
-    if (!rcBuildPolyMesh(_ctx.get(), *_cset, _cfg.maxVertsPerPoly, *_pmesh))
-    {
-        _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not triangulate contours.");
-        return false;
+        //
+        // Step 6. Trace and simplify region contours.
+        //
+        _cset.reset(rcAllocContourSet());
+        if (!_cset)
+        {
+            _ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'cset'.");
+            return false;
+        }
+        if (!rcBuildContours(_ctx.get(), *_chf, _cfg.maxSimplificationError, _cfg.maxEdgeLen, *_cset))
+        {
+            _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not create contours.");
+            return false;
+        }
+        printf("_cset->nconts=%i\n", _cset->nconts);
+        _noteIntermediateMemory();
     }
 
-    //
-    // Step 8. Create detail mesh.
-    //
-    _dmesh.reset(rcAllocPolyMeshDetail());
-    if (!_dmesh)
+    if (fromStage <= BuildStage::PolyMesh)
     {
-        _ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'pmdtl'.");
-        return false;
-    }
-    if (!rcBuildPolyMeshDetail(_ctx.get(), *_pmesh, *_chf, _cfg.detailSampleDist, _cfg.detailSampleMaxError, *_dmesh))
-    {
-        _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build detail mesh.");
-        return false;
+        //
+        // Step 7. Build polygons mesh from contours.
+        //
+        _pmesh.reset(rcAllocPolyMesh());
+        if (!_pmesh)
+        {
+            _ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'pmesh'.");
+            return false;
+        }
+        if (!rcBuildPolyMesh(_ctx.get(), *_cset, _cfg.maxVertsPerPoly, *_pmesh))
+        {
+            _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not triangulate contours.");
+            return false;
+        }
+        _noteIntermediateMemory();
     }
 
-    if (!_params.KeepInterResults)
+    if (fromStage <= BuildStage::DetailMesh)
     {
-        _chf.reset();
-        _cset.reset();
+        //
+        // Step 8. Create detail mesh.
+        //
+        _dmesh.reset(rcAllocPolyMeshDetail());
+        if (!_dmesh)
+        {
+            _ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'pmdtl'.");
+            return false;
+        }
+        if (!rcBuildPolyMeshDetail(_ctx.get(), *_pmesh, *_chf, _cfg.detailSampleDist, _cfg.detailSampleMaxError, *_dmesh))
+        {
+            _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build detail mesh.");
+            return false;
+        }
+        _noteIntermediateMemory();
+
+        if (!_params.KeepInterResults)
+        {
+            _chf.reset();
+            _cset.reset();
+        }
     }
 
     //
@@ -257,27 +408,8 @@ bool CStaticNavMesh::build(IMeshSceneNode* levelNode, const NavMeshParams& param
         unsigned char* navData = nullptr;
         int navDataSize = 0;
 
-        // Set polygon flags
-        for (int i = 0; i < _pmesh->npolys; ++i)
-        {
-            if (_pmesh->areas[i] == RC_WALKABLE_AREA)
-                _pmesh->areas[i] = (unsigned char)PolyAreas::GROUND;
-
-            if (_pmesh->areas[i] == (unsigned char)PolyAreas::GROUND ||
-                _pmesh->areas[i] == (unsigned char)PolyAreas::GRASS ||
-                _pmesh->areas[i] == (unsigned char)PolyAreas::ROAD)
-            {
-                _pmesh->flags[i] = (unsigned short)PolyFlags::WALK;
-            }
-            else if (_pmesh->areas[i] == (unsigned char)PolyAreas::WATER)
-            {
-                _pmesh->flags[i] = (unsigned short)PolyFlags::SWIM;
-            }
-            else if (_pmesh->areas[i] == (unsigned char)PolyAreas::DOOR)
-            {
-                _pmesh->flags[i] = (unsigned short)PolyFlags::WALK | (unsigned short)PolyFlags::DOOR;
-            }
-        }
+        // Set polygon areas and flags
+        _applyPolyAreaFlags(*_pmesh);
 
         dtNavMeshCreateParams params;
         memset(&params, 0, sizeof(params));
@@ -326,37 +458,54 @@ bool CStaticNavMesh::build(IMeshSceneNode* levelNode, const NavMeshParams& param
             return false;
         }
 
-        // --- Initialize the BASE CLASS's _navQuery ---
-        _navQuery.reset(dtAllocNavMeshQuery());
-        status = _navQuery->init(_navMesh.get(), 2048);
-        if (dtStatusFailed(status))
-        {
-            _ctx->log(RC_LOG_ERROR, "Could not init Detour navmesh query");
-            return false;
-        }
-
-        // --- Initialize the BASE CLASS's _crowd ---
-        _crowd.reset(dtAllocCrowd());
-        if (!_crowd)
-        {
-            _ctx->log(RC_LOG_ERROR, "Could not alloc crowd");
-            return false;
-        }
-
-        if (!_crowd->init(MAX_AGENTS, _params.AgentRadius, _navMesh.get()))
+        // --- Initialize the BASE CLASS's _query and _crowd ---
+        if (!_initQueryAndCrowd())
         {
-            _ctx->log(RC_LOG_ERROR, "Could not init crowd");
+            _ctx->log(RC_LOG_ERROR, "Could not init Detour navmesh query and crowd");
             return false;
         }
     }
 
     _ctx->stopTimer(RC_TIMER_TOTAL);
     _totalBuildTimeMs = _ctx->getAccumulatedTime(RC_TIMER_TOTAL) / 1000.0f;
+    _fillBuildReport(_ctx.get());
+    _hasCachedBuild = true;
     _ctx->log(RC_LOG_PROGRESS, ">> Polymesh: %d vertices  %d polygons", _pmesh->nverts, _pmesh->npolys);
 
     return true;
 }
 
+void CStaticNavMesh::_noteIntermediateMemory()
+{
+    size_t bytes = _triareas.size();
+    if (_solid) bytes += CNavMeshBuildContext::getMemoryUsage(*_solid);
+    if (_chf) bytes += CNavMeshBuildContext::getMemoryUsage(*_chf);
+    if (_cset) bytes += CNavMeshBuildContext::getMemoryUsage(*_cset);
+    if (_pmesh) bytes += CNavMeshBuildContext::getMemoryUsage(*_pmesh);
+    if (_dmesh) bytes += CNavMeshBuildContext::getMemoryUsage(*_dmesh);
+    _ctx->notePeakMemory(bytes);
+}
+
+void CStaticNavMesh::_clearBuildData()
+{
+    _solid.reset();
+    _chf.reset();
+    _cset.reset();
+    _pmesh.reset();
+    _dmesh.reset();
+    _verts.clear();
+    _tris.clear();
+    _triareas.clear();
+    _triAreaOverrides.clear();
+    _hasCachedBuild = false;
+
+    if (_naviDebugData)
+    {
+        _naviDebugData->remove();
+        _naviDebugData = nullptr;
+    }
+}
+
 ISceneNode* CStaticNavMesh::renderNavMesh()
 {
     if (!SceneManager)
@@ -407,77 +556,6 @@ ISceneNode* CStaticNavMesh::renderNavMesh()
 
 // --- Private Helper Functions ---
 
-bool CStaticNavMesh::_getMeshBufferData(
-    IMeshSceneNode* node,
-    std::vector<float>& verts,
-    std::vector<int>& tris)
-{
-    if (!node) return false;
-    irr::scene::IMesh* mesh = node->getMesh();
-    if (!mesh) return false;
-
-    matrix4 transform = node->getAbsoluteTransformation();
-    verts.clear();
-    tris.clear();
-
-    irr::u32 vertexOffset = 0;
-
-    for (irr::u32 i = 0; i < mesh->getMeshBufferCount(); ++i)
-    {
-        irr::scene::IMeshBuffer* buffer = mesh->getMeshBuffer(i);
-        irr::u32 currentVertCount = buffer->getVertexCount();
-        irr::u32 currentIdxCount = buffer->getIndexCount();
-
-        if (currentVertCount == 0 || currentIdxCount == 0)
-        {
-            continue;
-        }
-
-        // Add vertices
-        verts.reserve(verts.size() + currentVertCount * 3);
-        for (irr::u32 j = 0; j < currentVertCount; ++j)
-        {
-            vector3df pos = buffer->getPosition(j);
-            transform.transformVect(pos);
-            verts.push_back(pos.X);
-            verts.push_back(pos.Y);
-            verts.push_back(pos.Z);
-        }
-
-        // Add triangles (indices)
-        tris.reserve(tris.size() + currentIdxCount);
-        const irr::u16* indices16 = buffer->getIndices();
-        const irr::u32* indices32 = (const irr::u32*)indices16;
-
-        if (buffer->getIndexType() == irr::video::EIT_16BIT)
-        {
-            for (irr::u32 j = 0; j < currentIdxCount; ++j)
-            {
-                tris.push_back(indices16[j] + vertexOffset);
-            }
-        }
-        else // EIT_32BIT
-        {
-            for (irr::u32 j = 0; j < currentIdxCount; ++j)
-            {
-                tris.push_back(indices32[j] + vertexOffset);
-            }
-        }
-
-        vertexOffset += currentVertCount;
-    }
-
-    if (verts.empty() || tris.empty())
-    {
-        printf("WARNING: StaticNavMesh::_getMeshBufferData: No vertices or triangles found.\n");
-        return false;
-    }
-
-    printf("_getMeshBufferData: Total vertices=%u\n", vertexOffset);
-    printf("_getMeshBufferData: Total indices=%zu\n", tris.size());
-    return true;
-}
-
 bool CStaticNavMesh::_setupIrrSMeshFromRecastDetailMesh(irr::scene::SMesh* smesh)
 {
     rcPolyMeshDetail* dmesh = _dmesh.get();
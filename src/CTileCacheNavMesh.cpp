@@ -0,0 +1,705 @@
+#include "IrrRecastDetour/CTileCacheNavMesh.h"
+#include <irrlicht.h>
+#include "DetourCommon.h"
+
+#include <algorithm>
+#include <chrono>
+
+// Use explicit namespaces
+using irr::core::vector3df;
+using irr::core::matrix4;
+using irr::scene::ISceneNode;
+using irr::scene::IMeshSceneNode;
+
+using namespace irr;
+using namespace scene;
+
+namespace
+{
+    // Heightfield layers per tile the tile cache reserves room for
+    const int EXPECTED_LAYERS_PER_TILE = 4;
+    // Layers per tile that are actually kept
+    const int MAX_LAYERS_PER_TILE = 32;
+    // Every layer becomes its own Detour tile. A 32-bit dtPolyRef has 22 bits
+    // for the tile and poly indices; the rest is the salt. 14 tile bits leave
+    // 8 for the polygons of a layer.
+    const int MAX_TILE_BITS = 14;
+
+    /**
+     * Run-length (PackBits) compressor for the cached layers.
+     * Layers are mostly long runs of equal heights and areas, which compress well.
+     * A control byte c < 128 is followed by c + 1 literal bytes; c >= 128 repeats
+     * the next byte c - 125 times.
+     */
+    struct RunLengthCompressor : public dtTileCacheCompressor
+    {
+        virtual int maxCompressedSize(const int bufferSize) override
+        {
+            return bufferSize + (bufferSize + 127) / 128 + 1;
+        }
+
+        virtual dtStatus compress(
+            const unsigned char* buffer, const int bufferSize,
+            unsigned char* compressed, const int maxCompressedSize, int* compressedSize) override
+        {
+            int out = 0;
+            int i = 0;
+            while (i < bufferSize)
+            {
+                int run = 1;
+                while (i + run < bufferSize && run < 130 && buffer[i + run] == buffer[i])
+                    run++;
+
+                if (run >= 3)
+                {
+                    if (out + 2 > maxCompressedSize)
+                        return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+                    compressed[out++] = (unsigned char)(run + 125);
+                    compressed[out++] = buffer[i];
+                    i += run;
+                    continue;
+                }
+
+                // Literals until the next run of 3 or more
+                const int start = i;
+                while (i < bufferSize && i - start < 128)
+                {
+                    if (i + 2 < bufferSize && buffer[i] == buffer[i + 1] && buffer[i] == buffer[i + 2])
+                        break;
+                    i++;
+                }
+
+                const int len = i - start;
+                if (out + 1 + len > maxCompressedSize)
+                    return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+                compressed[out++] = (unsigned char)(len - 1);
+                memcpy(&compressed[out], &buffer[start], len);
+                out += len;
+            }
+
+            *compressedSize = out;
+            return DT_SUCCESS;
+        }
+
+        virtual dtStatus decompress(
+            const unsigned char* compressed, const int compressedSize,
+            unsigned char* buffer, const int maxBufferSize, int* bufferSize) override
+        {
+            int out = 0;
+            int i = 0;
+            while (i < compressedSize)
+            {
+                const int c = compressed[i++];
+                if (c < 128)
+                {
+                    const int len = c + 1;
+                    if (i + len > compressedSize || out + len > maxBufferSize)
+                        return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+                    memcpy(&buffer[out], &compressed[i], len);
+                    i += len;
+                    out += len;
+                }
+                else
+                {
+                    const int len = c - 125;
+                    if (i >= compressedSize || out + len > maxBufferSize)
+                        return DT_FAILURE | DT_BUFFER_TOO_SMALL;
+                    memset(&buffer[out], compressed[i++], len);
+                    out += len;
+                }
+            }
+
+            *bufferSize = out;
+            return DT_SUCCESS;
+        }
+    };
+
+    /**
+     * Bump allocator for the temporary data of a tile rebuild.
+     * dtTileCache resets it before every tile, so a rebuild does no heap
+     * allocations once the buffer has grown to the largest tile seen.
+     */
+    struct LinearAllocator : public dtTileCacheAlloc
+    {
+        explicit LinearAllocator(const size_t capacity) : _buffer(capacity) {}
+
+        virtual void reset() override
+        {
+            // Grow to the high-water mark; nothing is allocated at this point
+            if (_high > _buffer.size())
+                _buffer.resize(_high);
+            _top = 0;
+            _overflow = 0;
+        }
+
+        virtual void* alloc(const size_t size) override
+        {
+            const size_t alignedSize = (size + 15) & ~(size_t)15;
+            _high = std::max(_high, _top + _overflow + alignedSize);
+
+            if (_top + alignedSize > _buffer.size())
+            {
+                // Out of room until the next reset(), use the heap meanwhile
+                _overflow += alignedSize;
+                return dtAlloc(size, DT_ALLOC_TEMP);
+            }
+
+            void* mem = &_buffer[_top];
+            _top += alignedSize;
+            return mem;
+        }
+
+        virtual void free(void* ptr) override
+        {
+            const unsigned char* p = (const unsigned char*)ptr;
+            if (p && (p < _buffer.data() || p >= _buffer.data() + _buffer.size()))
+                dtFree(ptr);
+        }
+
+        std::vector<unsigned char> _buffer;
+        size_t _top = 0;
+        size_t _high = 0;
+        size_t _overflow = 0;
+    };
+}
+
+/**
+ * Converts the layer areas of rebuilt tiles to PolyAreas and sets PolyFlags,
+ * the same way the static and tiled builds do.
+ */
+struct CTileCacheNavMesh::MeshProcess : public dtTileCacheMeshProcess
+{
+    virtual void process(dtNavMeshCreateParams* params, unsigned char* polyAreas, unsigned short* polyFlags) override
+    {
+        _applyPolyAreaFlags(polyAreas, polyFlags, params->polyCount);
+    }
+};
+
+CTileCacheNavMesh::CTileCacheNavMesh(irr::scene::ISceneNode* parent, irr::scene::ISceneManager* mgr, irr::s32 id)
+    : INavMesh(parent, mgr, id), // Call the base constructor
+    _ctx(new CNavMeshBuildContext(true)) // true = enable logging
+{
+}
+
+CTileCacheNavMesh::~CTileCacheNavMesh()
+{
+    // All smart pointers handle their own cleanup.
+}
+
+void CTileCacheNavMesh::OnAnimate(irr::u32 timeMs)
+{
+    // Apply pending obstacle changes before the crowd moves
+    if (_tileCache && _lastUpdateTimeMs != 0)
+    {
+        update((timeMs - _lastUpdateTimeMs) / 1000.0f);
+    }
+
+    INavMesh::OnAnimate(timeMs);
+}
+
+bool CTileCacheNavMesh::build(IMeshSceneNode* levelNode, const NavMeshParams& params, const int tileSize, const int maxObstacles)
+{
+    if (!levelNode)
+    {
+        printf("ERROR: TileCacheNavMesh::build: levelNode is null.\n");
+        return false;
+    }
+    if (tileSize <= 0 || tileSize > 255)
+    {
+        printf("ERROR: TileCacheNavMesh::build: tileSize must be in 1..255 (got %d).\n", tileSize);
+        return false;
+    }
+
+    _params = params;
+    _tileSize = tileSize;
+    _totalBuildTimeMs = 0.0f;
+    _buildReport = NavMeshBuildReport();
+
+    // Store defaults for the base class
+    _defaultAgentRadius = _params.AgentRadius;
+    _defaultAgentHeight = _params.AgentHeight;
+
+    // Clear previous build data
+    _resetDetour();
+    _clearBuildData();
+
+    _ctx->setProgressLog(_buildProgressLog);
+    _ctx->resetTimers();
+    _ctx->startTimer(RC_TIMER_TOTAL);
+
+    //
+    // Step 1. Extract Irrlicht geometry
+    //
+    std::vector<unsigned char> triAreaOverrides;
+    if (!this->_getMeshBufferData(levelNode, _verts, _tris, triAreaOverrides))
+    {
+        printf("ERROR: TileCacheNavMesh::build: _getMeshBufferData() failed.\n");
+        return false;
+    }
+
+    float bmin[3], bmax[3];
+    rcCalcBounds(_verts.data(), (int)_verts.size() / 3, bmin, bmax);
+
+    // Set the ISceneNode's bounding box (from base class)
+    _box.reset(irr::core::vector3df(bmin[0], bmin[1], bmin[2]));
+    _box.addInternalPoint(irr::core::vector3df(bmax[0], bmax[1], bmax[2]));
+
+    // Index the triangles on a grid of tile-sized cells
+    _triGrid.build(_verts.data(), _tris.data(), (int)_tris.size() / 3, bmin, bmax, _tileSize * _params.CellSize);
+
+    // Slope classification does not depend on the tile, so do it once for all tiles
+    _markTriangleAreas(_ctx.get(), _params.AgentMaxSlope, _verts, _tris, triAreaOverrides, _triareas);
+
+    int gridW = 0, gridH = 0;
+    rcCalcGridSize(bmin, bmax, _params.CellSize, &gridW, &gridH);
+    const int tilesW = (gridW + _tileSize - 1) / _tileSize;
+    const int tilesH = (gridH + _tileSize - 1) / _tileSize;
+
+    // Layers beyond what a dtPolyRef can address would be dropped, leaving holes
+    const int maxLayerTiles = tilesW * tilesH * EXPECTED_LAYERS_PER_TILE;
+    if (maxLayerTiles > (1 << MAX_TILE_BITS))
+    {
+        printf("ERROR: TileCacheNavMesh::build: %d x %d tiles need room for %d layers, more than the %d a navmesh can hold. Use a larger tileSize.\n",
+            tilesW, tilesH, maxLayerTiles, 1 << MAX_TILE_BITS);
+        return false;
+    }
+
+    //
+    // Step 2. Initialize the tile cache
+    //
+    dtTileCacheParams tcParams;
+    memset(&tcParams, 0, sizeof(tcParams));
+    rcVcopy(tcParams.orig, bmin);
+    tcParams.cs = _params.CellSize;
+    tcParams.ch = _params.CellHeight;
+    tcParams.width = _tileSize;
+    tcParams.height = _tileSize;
+    tcParams.walkableHeight = _params.AgentHeight;
+    tcParams.walkableRadius = _params.AgentRadius;
+    tcParams.walkableClimb = _params.AgentMaxClimb;
+    tcParams.maxSimplificationError = _params.EdgeMaxError;
+    tcParams.maxTiles = maxLayerTiles;
+    tcParams.maxObstacles = maxObstacles;
+
+    _talloc.reset(new LinearAllocator(32 * 1024));
+    _tcomp.reset(new RunLengthCompressor());
+    _tmproc.reset(new MeshProcess());
+
+    _tileCache.reset(dtAllocTileCache());
+    if (!_tileCache)
+    {
+        _ctx->log(RC_LOG_ERROR, "build: Could not alloc tile cache.");
+        return false;
+    }
+    if (dtStatusFailed(_tileCache->init(&tcParams, _talloc.get(), _tcomp.get(), _tmproc.get())))
+    {
+        _ctx->log(RC_LOG_ERROR, "build: Could not init tile cache.");
+        return false;
+    }
+
+    //
+    // Step 3. Initialize dtNavMesh parameters for tiling
+    //
+    _navMesh.reset(dtAllocNavMesh());
+    if (!_navMesh)
+    {
+        _ctx->log(RC_LOG_ERROR, "build: Could not alloc navmesh.");
+        return false;
+    }
+
+    dtNavMeshParams dtParams;
+    memset(&dtParams, 0, sizeof(dtParams));
+    rcVcopy(dtParams.orig, bmin);
+    dtParams.tileWidth = _tileSize * _params.CellSize;
+    dtParams.tileHeight = _tileSize * _params.CellSize;
+
+    // Every layer becomes its own Detour tile, see MAX_TILE_BITS
+    const int tileBits = (int)dtIlog2(dtNextPow2((unsigned int)tcParams.maxTiles));
+    const int polyBits = 22 - tileBits;
+    dtParams.maxTiles = 1 << tileBits;
+    dtParams.maxPolys = 1 << polyBits;
+
+    if (dtStatusFailed(_navMesh->init(&dtParams)))
+    {
+        _ctx->log(RC_LOG_ERROR, "build: Could not init navmesh.");
+        return false;
+    }
+
+    //
+    // Step 4. Rasterize every tile into compressed layers
+    //
+    _ctx->log(RC_LOG_PROGRESS, "Building %d x %d tile cache tiles...", tilesW, tilesH);
+
+    _buildReport.Tiles.resize(tilesW * tilesH);
+
+    int layerCount = 0;
+    for (int y = 0; y < tilesH; ++y)
+    {
+        for (int x = 0; x < tilesW; ++x)
+        {
+            const auto tileStart = std::chrono::steady_clock::now();
+            const double cpuStart = CNavMeshBuildContext::getThreadCpuTimeMs();
+
+            const int n = _rasterizeTileLayers(x, y, bmin, bmax);
+            if (n > 0)
+                layerCount += n;
+
+            NavMeshTileReport& report = _buildReport.Tiles[x + y * tilesW];
+            report.TileX = x;
+            report.TileY = y;
+            report.BuildTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - tileStart).count();
+            report.CpuTimeMs = (float)(CNavMeshBuildContext::getThreadCpuTimeMs() - cpuStart);
+        }
+    }
+
+    //
+    // Step 5. Build the Detour tiles from the layers
+    //
+    int failedTiles = 0;
+    for (int y = 0; y < tilesH; ++y)
+    {
+        for (int x = 0; x < tilesW; ++x)
+        {
+            if (dtStatusFailed(_tileCache->buildNavMeshTilesAt(x, y, _navMesh.get())))
+            {
+                _ctx->log(RC_LOG_ERROR, "Failed to build navmesh tiles at %d, %d.", x, y);
+                failedTiles++;
+            }
+
+            // Sum the Detour tiles of all layers
+            const dtMeshTile* tiles[MAX_LAYERS_PER_TILE];
+            const int ntiles = ((const dtNavMesh*)_navMesh.get())->getTilesAt(x, y, tiles, MAX_LAYERS_PER_TILE);
+            NavMeshTileReport& report = _buildReport.Tiles[x + y * tilesW];
+            for (int i = 0; i < ntiles; ++i)
+            {
+                report.PolyCount += tiles[i]->header->polyCount;
+                report.VertCount += tiles[i]->header->vertCount;
+            }
+        }
+    }
+
+    if (failedTiles > 0)
+    {
+        printf("ERROR: TileCacheNavMesh::build: %d tiles could not be built.\n", failedTiles);
+        return false;
+    }
+
+    //
+    // Step 6. Initialize Query and Crowd (from base class)
+    //
+    if (!_initQueryAndCrowd())
+    {
+        _ctx->log(RC_LOG_ERROR, "build: Could not init Detour navmesh query and crowd");
+        return false;
+    }
+
+    // The geometry is baked into the layers; obstacle updates never re-rasterize
+    _triGrid.clear();
+    _verts.clear();
+    _tris.clear();
+    _triareas.clear();
+
+    _ctx->stopTimer(RC_TIMER_TOTAL);
+    _totalBuildTimeMs = _ctx->getAccumulatedTime(RC_TIMER_TOTAL) / 1000.0f;
+    _fillBuildReport(_ctx.get());
+    _ctx->log(RC_LOG_PROGRESS, ">> Tile cache build complete in %.1f ms (%d layers, %d bytes compressed).",
+        _totalBuildTimeMs, layerCount, (int)getCompressedLayerBytes());
+
+    return true;
+}
+
+dtObstacleRef CTileCacheNavMesh::addObstacle(const vector3df& pos, float radius, float height)
+{
+    if (!_tileCache)
+    {
+        printf("ERROR: TileCacheNavMesh::addObstacle: No tile cache. Call build() first.\n");
+        return 0;
+    }
+
+    const float p[3] = { pos.X, pos.Y, pos.Z };
+    dtObstacleRef ref = 0;
+    if (dtStatusFailed(_tileCache->addObstacle(p, radius, height, &ref)))
+    {
+        printf("ERROR: TileCacheNavMesh::addObstacle: Obstacle or request limit reached.\n");
+        return 0;
+    }
+    _obstaclesChanged = true;
+    return ref;
+}
+
+dtObstacleRef CTileCacheNavMesh::addBoxObstacle(const irr::core::aabbox3df& box)
+{
+    if (!_tileCache)
+    {
+        printf("ERROR: TileCacheNavMesh::addBoxObstacle: No tile cache. Call build() first.\n");
+        return 0;
+    }
+
+    const float bmin[3] = { box.MinEdge.X, box.MinEdge.Y, box.MinEdge.Z };
+    const float bmax[3] = { box.MaxEdge.X, box.MaxEdge.Y, box.MaxEdge.Z };
+    dtObstacleRef ref = 0;
+    if (dtStatusFailed(_tileCache->addBoxObstacle(bmin, bmax, &ref)))
+    {
+        printf("ERROR: TileCacheNavMesh::addBoxObstacle: Obstacle or request limit reached.\n");
+        return 0;
+    }
+    _obstaclesChanged = true;
+    return ref;
+}
+
+dtObstacleRef CTileCacheNavMesh::addBoxObstacle(const vector3df& center, const vector3df& halfExtents, float yRotationDeg)
+{
+    if (!_tileCache)
+    {
+        printf("ERROR: TileCacheNavMesh::addBoxObstacle: No tile cache. Call build() first.\n");
+        return 0;
+    }
+
+    const float c[3] = { center.X, center.Y, center.Z };
+    const float h[3] = { halfExtents.X, halfExtents.Y, halfExtents.Z };
+    dtObstacleRef ref = 0;
+    if (dtStatusFailed(_tileCache->addBoxObstacle(c, h, yRotationDeg * irr::core::DEGTORAD, &ref)))
+    {
+        printf("ERROR: TileCacheNavMesh::addBoxObstacle: Obstacle or request limit reached.\n");
+        return 0;
+    }
+    _obstaclesChanged = true;
+    return ref;
+}
+
+bool CTileCacheNavMesh::removeObstacle(dtObstacleRef ref)
+{
+    if (!_tileCache || !ref)
+        return false;
+
+    if (dtStatusFailed(_tileCache->removeObstacle(ref)))
+    {
+        printf("ERROR: TileCacheNavMesh::removeObstacle: Request limit reached.\n");
+        return false;
+    }
+    _obstaclesChanged = true;
+    return true;
+}
+
+bool CTileCacheNavMesh::update(float dt)
+{
+    if (!_tileCache || !_navMesh)
+        return true;
+
+    // A threaded crowd step must not see tiles change
+    _finishCrowdStep();
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Each dtTileCache::update() call rebuilds at most one tile
+    bool upToDate = false;
+    for (;;)
+    {
+        if (dtStatusFailed(_tileCache->update(dt, _navMesh.get(), &upToDate)))
+        {
+            printf("ERROR: TileCacheNavMesh::update: Tile cache update failed.\n");
+            return false;
+        }
+
+        if (upToDate)
+            break;
+
+        const float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (elapsedMs >= _updateBudgetMs)
+            break;
+    }
+
+    // Tiles are rebuilt while obstacle changes are being processed
+    if (_obstaclesChanged)
+    {
+        _onTilesChanged();
+        _obstaclesChanged = !upToDate;
+    }
+
+    return upToDate;
+}
+
+size_t CTileCacheNavMesh::getCompressedLayerBytes() const
+{
+    if (!_tileCache)
+        return 0;
+
+    size_t bytes = 0;
+    for (int i = 0; i < _tileCache->getTileCount(); ++i)
+    {
+        const dtCompressedTile* tile = _tileCache->getTile(i);
+        if (tile && tile->header)
+            bytes += tile->dataSize;
+    }
+    return bytes;
+}
+
+void CTileCacheNavMesh::_clearBuildData()
+{
+    _tileCache.reset();
+    _obstaclesChanged = false;
+    _triGrid.clear();
+    _triareas.clear();
+}
+
+int CTileCacheNavMesh::_rasterizeTileLayers(
+    const int tx, const int ty,
+    const float* bmin, const float* bmax)
+{
+    rcContext* ctx = _ctx.get();
+
+    rcConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.cs = _params.CellSize;
+    cfg.ch = _params.CellHeight;
+    cfg.walkableSlopeAngle = _params.AgentMaxSlope;
+    cfg.walkableHeight = (int)ceilf(_params.AgentHeight / cfg.ch);
+    cfg.walkableClimb = (int)floorf(_params.AgentMaxClimb / cfg.ch);
+    cfg.walkableRadius = (int)ceilf(_params.AgentRadius / cfg.cs);
+    cfg.tileSize = _tileSize;
+    cfg.borderSize = cfg.walkableRadius + 3; // 3 = default padding
+    cfg.width = cfg.tileSize + cfg.borderSize * 2;
+    cfg.height = cfg.tileSize + cfg.borderSize * 2;
+
+    // Calculate tile bounds, expanded by the border
+    cfg.bmin[0] = bmin[0] + (tx * cfg.tileSize - cfg.borderSize) * cfg.cs;
+    cfg.bmin[1] = bmin[1];
+    cfg.bmin[2] = bmin[2] + (ty * cfg.tileSize - cfg.borderSize) * cfg.cs;
+    cfg.bmax[0] = bmin[0] + ((tx + 1) * cfg.tileSize + cfg.borderSize) * cfg.cs;
+    cfg.bmax[1] = bmax[1];
+    cfg.bmax[2] = bmin[2] + ((ty + 1) * cfg.tileSize + cfg.borderSize) * cfg.cs;
+
+    // Collect the triangles overlapping the (border-expanded) tile
+    std::vector<int> tileTriIds;
+    const int ntris = _triGrid.query(cfg.bmin, cfg.bmax, tileTriIds);
+
+    ctx->log(RC_LOG_PROGRESS, "Building tile cache tile %d, %d (%d of %d tris)...", tx, ty, ntris, (int)_tris.size() / 3);
+
+    if (ntris == 0)
+    {
+        return 0; // Nothing to rasterize
+    }
+
+    // Gather the candidates and their precomputed areas
+    std::vector<int> tileTris(ntris * 3);
+    std::vector<unsigned char> triareas(ntris);
+    bool anyWalkable = false;
+    for (int i = 0; i < ntris; ++i)
+    {
+        const int* tri = &_tris[tileTriIds[i] * 3];
+        tileTris[i * 3 + 0] = tri[0];
+        tileTris[i * 3 + 1] = tri[1];
+        tileTris[i * 3 + 2] = tri[2];
+        triareas[i] = _triareas[tileTriIds[i]];
+        anyWalkable |= triareas[i] != RC_NULL_AREA;
+    }
+
+    if (!anyWalkable)
+    {
+        return 0; // Only steep geometry, nothing to walk on
+    }
+
+    // Rasterize
+    std::unique_ptr<rcHeightfield, RecastHeightfieldDeleter> solid(rcAllocHeightfield());
+    if (!solid)
+    {
+        ctx->log(RC_LOG_ERROR, "rasterizeTileLayers: Out of memory 'solid'.");
+        return -1;
+    }
+    if (!rcCreateHeightfield(ctx, *solid, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs, cfg.ch))
+    {
+        ctx->log(RC_LOG_ERROR, "rasterizeTileLayers: Could not create solid heightfield.");
+        return -1;
+    }
+
+    rcRasterizeTriangles(ctx, _verts.data(), (int)_verts.size() / 3, tileTris.data(), triareas.data(), ntris, *solid, cfg.walkableClimb);
+    _ctx->notePeakMemory(CNavMeshBuildContext::getMemoryUsage(*solid) + tileTris.size() * sizeof(int) + triareas.size());
+
+    // Filter
+    rcFilterLowHangingWalkableObstacles(ctx, cfg.walkableClimb, *solid);
+    rcFilterLedgeSpans(ctx, cfg.walkableHeight, cfg.walkableClimb, *solid);
+    rcFilterWalkableLowHeightSpans(ctx, cfg.walkableHeight, *solid);
+
+    // Compact and erode
+    std::unique_ptr<rcCompactHeightfield, RecastCompactHeightfieldDeleter> chf(rcAllocCompactHeightfield());
+    if (!chf)
+    {
+        ctx->log(RC_LOG_ERROR, "rasterizeTileLayers: Out of memory 'chf'.");
+        return -1;
+    }
+    if (!rcBuildCompactHeightfield(ctx, cfg.walkableHeight, cfg.walkableClimb, *solid, *chf))
+    {
+        ctx->log(RC_LOG_ERROR, "rasterizeTileLayers: Could not build compact data.");
+        return -1;
+    }
+    _ctx->notePeakMemory(CNavMeshBuildContext::getMemoryUsage(*solid) + CNavMeshBuildContext::getMemoryUsage(*chf));
+
+    solid.reset(); // No longer needed
+
+    if (!rcErodeWalkableArea(ctx, cfg.walkableRadius, *chf))
+    {
+        ctx->log(RC_LOG_ERROR, "rasterizeTileLayers: Could not erode.");
+        return -1;
+    }
+
+    // Split into non-overlapping height layers
+    std::unique_ptr<rcHeightfieldLayerSet, RecastHeightfieldLayerSetDeleter> lset(rcAllocHeightfieldLayerSet());
+    if (!lset)
+    {
+        ctx->log(RC_LOG_ERROR, "rasterizeTileLayers: Out of memory 'lset'.");
+        return -1;
+    }
+    if (!rcBuildHeightfieldLayers(ctx, *chf, cfg.borderSize, cfg.walkableHeight, *lset))
+    {
+        ctx->log(RC_LOG_ERROR, "rasterizeTileLayers: Could not build heightfield layers.");
+        return -1;
+    }
+    _ctx->notePeakMemory(CNavMeshBuildContext::getMemoryUsage(*chf) + CNavMeshBuildContext::getMemoryUsage(*lset));
+
+    chf.reset(); // No longer needed
+
+    // Compress each layer and store it in the tile cache
+    int added = 0;
+    const int nlayers = std::min(lset->nlayers, MAX_LAYERS_PER_TILE);
+    for (int i = 0; i < nlayers; ++i)
+    {
+        const rcHeightfieldLayer* layer = &lset->layers[i];
+
+        dtTileCacheLayerHeader header;
+        memset(&header, 0, sizeof(header));
+        header.magic = DT_TILECACHE_MAGIC;
+        header.version = DT_TILECACHE_VERSION;
+        header.tx = tx;
+        header.ty = ty;
+        header.tlayer = i;
+        rcVcopy(header.bmin, layer->bmin);
+        rcVcopy(header.bmax, layer->bmax);
+        header.width = (unsigned char)layer->width;
+        header.height = (unsigned char)layer->height;
+        header.minx = (unsigned char)layer->minx;
+        header.maxx = (unsigned char)layer->maxx;
+        header.miny = (unsigned char)layer->miny;
+        header.maxy = (unsigned char)layer->maxy;
+        header.hmin = (unsigned short)layer->hmin;
+        header.hmax = (unsigned short)layer->hmax;
+
+        unsigned char* data = nullptr;
+        int dataSize = 0;
+        if (dtStatusFailed(dtBuildTileCacheLayer(_tcomp.get(), &header, layer->heights, layer->areas, layer->cons, &data, &dataSize)))
+        {
+            ctx->log(RC_LOG_ERROR, "rasterizeTileLayers: Could not compress layer %d of tile %d, %d.", i, tx, ty);
+            return -1;
+        }
+
+        if (dtStatusFailed(_tileCache->addTile(data, dataSize, DT_COMPRESSEDTILE_FREE_DATA, nullptr)))
+        {
+            ctx->log(RC_LOG_ERROR, "rasterizeTileLayers: Failed to add layer %d of tile %d, %d.", i, tx, ty);
+            dtFree(data);
+            continue;
+        }
+        added++;
+    }
+
+    return added;
+}
+
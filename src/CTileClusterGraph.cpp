@@ -0,0 +1,469 @@
+#include "IrrRecastDetour/CTileClusterGraph.h"
+#include "IrrRecastDetour/CNavQueryContext.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+#include <functional>
+#include "DetourCommon.h"
+#include "DetourGraphUtils.h"
+
+namespace
+{
+    // Longest corridor of one refinement segment; segments stay within a tile
+    const int MAX_SEGMENT_POLYS = 2048;
+
+    // Appends a polygon search result to a corridor, without repeating the joint polygon
+    void appendCorridor(std::vector<dtPolyRef>& corridor, const dtPolyRef* polys, const int count)
+    {
+        int first = 0;
+        if (count > 0 && !corridor.empty() && corridor.back() == polys[0])
+            first = 1;
+        corridor.insert(corridor.end(), polys + first, polys + count);
+    }
+}
+
+CTileClusterGraph::CTileClusterGraph()
+    : _tileSearch(new CPolySearch())
+{
+}
+
+CTileClusterGraph::~CTileClusterGraph()
+{
+}
+
+CTileClusterGraph::CTileClusterGraph(CTileClusterGraph&&) = default;
+CTileClusterGraph& CTileClusterGraph::operator=(CTileClusterGraph&&) = default;
+
+bool CTileClusterGraph::build(const dtNavMesh* navMesh, const dtQueryFilter& filter, int tilesW, int tilesH)
+{
+    clear();
+    if (!navMesh)
+        return false;
+
+    // Without a known grid, it is as large as the tiles that exist
+    for (int i = 0; i < navMesh->getMaxTiles(); ++i)
+    {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (!tile || !tile->header)
+            continue;
+        tilesW = std::max(tilesW, tile->header->x + 1);
+        tilesH = std::max(tilesH, tile->header->y + 1);
+    }
+    if (tilesW == 0 || tilesH == 0)
+        return false;
+
+    _tilesW = tilesW;
+    _tilesH = tilesH;
+    _tiles.resize(tilesW * tilesH);
+
+    updateTiles(navMesh, filter, 0, 0, tilesW - 1, tilesH - 1);
+    return true;
+}
+
+void CTileClusterGraph::updateTiles(const dtNavMesh* navMesh, const dtQueryFilter& filter, int tx0, int ty0, int tx1, int ty1)
+{
+    if (!navMesh || !isBuilt())
+        return;
+
+    tx0 = std::max(tx0, 0);
+    ty0 = std::max(ty0, 0);
+    tx1 = std::min(tx1, _tilesW - 1);
+    ty1 = std::min(ty1, _tilesH - 1);
+    if (tx0 > tx1 || ty0 > ty1)
+        return;
+
+    // Portals of rebuilt tiles point at their old polygons
+    for (int y = ty0; y <= ty1; ++y)
+    {
+        for (int x = tx0; x <= tx1; ++x)
+            _removeTilePortals(x + y * _tilesW);
+    }
+
+    // Every edge of a rebuilt tile gets new portals, each edge once
+    auto isRebuilt = [&](int x, int y) { return x >= tx0 && x <= tx1 && y >= ty0 && y <= ty1; };
+    for (int y = ty0; y <= ty1; ++y)
+    {
+        for (int x = tx0; x <= tx1; ++x)
+        {
+            if (x + 1 < _tilesW)
+                _addEdgePortals(navMesh, filter, x, y, x + 1, y);
+            if (y + 1 < _tilesH)
+                _addEdgePortals(navMesh, filter, x, y, x, y + 1);
+            if (x > 0 && !isRebuilt(x - 1, y))
+                _addEdgePortals(navMesh, filter, x - 1, y, x, y);
+            if (y > 0 && !isRebuilt(x, y - 1))
+                _addEdgePortals(navMesh, filter, x, y - 1, x, y);
+        }
+    }
+
+    // Neighbours lost and gained portals too
+    for (int y = std::max(ty0 - 1, 0); y <= std::min(ty1 + 1, _tilesH - 1); ++y)
+    {
+        for (int x = std::max(tx0 - 1, 0); x <= std::min(tx1 + 1, _tilesW - 1); ++x)
+            _computeTileCosts(navMesh, filter, x + y * _tilesW);
+    }
+}
+
+void CTileClusterGraph::clear()
+{
+    _portals.clear();
+    _freePortals.clear();
+    _portalCount = 0;
+    _tiles.clear();
+    _tilesW = 0;
+    _tilesH = 0;
+}
+
+void CTileClusterGraph::_addEdgePortals(const dtNavMesh* navMesh, const dtQueryFilter& filter, int ax, int ay, int bx, int by)
+{
+    const dtMeshTile* tileA = navMesh->getTileAt(ax, ay, 0);
+    const dtMeshTile* tileB = navMesh->getTileAt(bx, by, 0);
+    if (!tileA || !tileA->header || !tileB || !tileB->header)
+        return;
+
+    const int indexA = ax + ay * _tilesW;
+    const int indexB = bx + by * _tilesW;
+    const dtPolyRef baseA = navMesh->getPolyRefBase(tileA);
+    const unsigned int navTileB = navMesh->decodePolyIdTile(navMesh->getPolyRefBase(tileB));
+
+    for (int i = 0; i < tileA->header->polyCount; ++i)
+    {
+        const dtPoly* polyA = &tileA->polys[i];
+        const dtPolyRef refA = baseA | (dtPolyRef)i;
+        if (polyA->getType() == DT_POLYTYPE_OFFMESH_CONNECTION || !filter.passFilter(refA, tileA, polyA))
+            continue;
+
+        for (unsigned int l = polyA->firstLink; l != DT_NULL_LINK; l = tileA->links[l].next)
+        {
+            const dtLink& link = tileA->links[l];
+
+            // Only links across the tile border to tile B
+            if (link.side == 0xff || !link.ref || navMesh->decodePolyIdTile(link.ref) != navTileB)
+                continue;
+
+            const dtPoly* polyB = &tileB->polys[navMesh->decodePolyIdPoly(link.ref)];
+            if (polyB->getType() == DT_POLYTYPE_OFFMESH_CONNECTION || !filter.passFilter(link.ref, tileB, polyB))
+                continue;
+
+            // Portals are walked both ways
+            if (!findPolyLink(tileB, polyB, refA))
+                continue;
+
+            // Polygons can be linked by more than one edge piece; keep one portal per pair
+            bool known = false;
+            for (int p : _tiles[indexA].Portals)
+            {
+                if (_portals[p].Polys[0] == refA && _portals[p].Polys[1] == link.ref)
+                {
+                    known = true;
+                    break;
+                }
+            }
+            if (known)
+                continue;
+
+            int index;
+            if (!_freePortals.empty())
+            {
+                index = _freePortals.back();
+                _freePortals.pop_back();
+            }
+            else
+            {
+                index = (int)_portals.size();
+                _portals.push_back(Portal());
+            }
+
+            Portal& portal = _portals[index];
+            portal.Polys[0] = refA;
+            portal.Polys[1] = link.ref;
+            portal.Tiles[0] = indexA;
+            portal.Tiles[1] = indexB;
+            portal.Used = true;
+            CNavQueryContext::getPortalMidpoint(refA, tileA, polyA, link, tileB, polyB, portal.Pos);
+
+            _tiles[indexA].Portals.push_back(index);
+            _tiles[indexB].Portals.push_back(index);
+            ++_portalCount;
+        }
+    }
+}
+
+void CTileClusterGraph::_removeTilePortals(int tileIndex)
+{
+    for (int p : _tiles[tileIndex].Portals)
+    {
+        Portal& portal = _portals[p];
+        if (!portal.Used)
+            continue;
+
+        const int other = portal.Tiles[0] == tileIndex ? portal.Tiles[1] : portal.Tiles[0];
+        std::vector<int>& otherPortals = _tiles[other].Portals;
+        otherPortals.erase(std::remove(otherPortals.begin(), otherPortals.end(), p), otherPortals.end());
+
+        portal = Portal();
+        _freePortals.push_back(p);
+        --_portalCount;
+    }
+
+    _tiles[tileIndex].Portals.clear();
+    _tiles[tileIndex].Costs.clear();
+}
+
+void CTileClusterGraph::_computeTileCosts(const dtNavMesh* navMesh, const dtQueryFilter& filter, int tileIndex)
+{
+    Tile& tile = _tiles[tileIndex];
+    const int count = (int)tile.Portals.size();
+
+    for (int i = 0; i < count; ++i)
+    {
+        Portal& portal = _portals[tile.Portals[i]];
+        portal.Slots[portal.Tiles[0] == tileIndex ? 0 : 1] = i;
+    }
+
+    tile.Costs.assign(count * count, FLT_MAX);
+    std::vector<float> costs;
+    for (int i = 0; i < count; ++i)
+    {
+        const Portal& portal = _portals[tile.Portals[i]];
+        _getPortalCosts(navMesh, filter, tileIndex, _getPortalPoly(portal, tileIndex), portal.Pos, costs);
+        std::copy(costs.begin(), costs.end(), tile.Costs.begin() + i * count);
+    }
+}
+
+void CTileClusterGraph::_getPortalCosts(
+    const dtNavMesh* navMesh, const dtQueryFilter& filter,
+    int tileIndex, dtPolyRef startRef, const float* startPos,
+    std::vector<float>& costs)
+{
+    const Tile& tile = _tiles[tileIndex];
+    costs.assign(tile.Portals.size(), FLT_MAX);
+
+    const dtMeshTile* meshTile = navMesh->getTileAt(tileIndex % _tilesW, tileIndex / _tilesW, 0);
+    if (!meshTile)
+        return;
+
+    // Search only the polygons of this tile
+    if (!_tileSearch)
+        _tileSearch.reset(new CPolySearch());
+    CPolySearch& search = *_tileSearch;
+    search.clear();
+    search.addStart(startRef, startPos);
+    search.run(navMesh, filter, false, 0.0f,
+        [meshTile](dtPolyRef, const dtMeshTile* tile, const dtPoly*) { return tile == meshTile; },
+        [](int) { return true; });
+
+    for (size_t i = 0; i < tile.Portals.size(); ++i)
+    {
+        const Portal& portal = _portals[tile.Portals[i]];
+        const dtPolyRef ref = _getPortalPoly(portal, tileIndex);
+
+        const int node = search.findNode(ref);
+        if (node < 0 || !search[node].Closed)
+            continue;
+
+        // Last step: from where the search entered the polygon to the portal
+        const dtMeshTile* polyTile = nullptr;
+        const dtPoly* poly = nullptr;
+        navMesh->getTileAndPolyByRefUnsafe(ref, &polyTile, &poly);
+        costs[i] = search[node].Cost + filter.getCost(
+            search[node].Pos, portal.Pos,
+            0, nullptr, nullptr,
+            ref, polyTile, poly,
+            0, nullptr, nullptr
+        );
+    }
+}
+
+PathStatus CTileClusterGraph::findPath(
+    CNavQueryContext& query,
+    const irr::core::vector3df& startPos,
+    const irr::core::vector3df& endPos,
+    PathResult& result)
+{
+    if (!query.isValid() || !isBuilt())
+        return query.findPath(startPos, endPos, result);
+
+    const dtNavMesh* navMesh = query.getQuery()->getAttachedNavMesh();
+    const dtQueryFilter& filter = query.getFilter();
+
+    float startNearest[3];
+    float endNearest[3];
+    const dtPolyRef startRef = query.findNearestPoly(startPos, startNearest);
+    const dtPolyRef endRef = query.findNearestPoly(endPos, endNearest);
+    if (!startRef || !endRef || !query.isReachable(startRef, endRef))
+        return query.findPath(startPos, endPos, result);
+
+    const dtMeshTile* startMeshTile = nullptr;
+    const dtMeshTile* endMeshTile = nullptr;
+    const dtPoly* unused = nullptr;
+    navMesh->getTileAndPolyByRefUnsafe(startRef, &startMeshTile, &unused);
+    navMesh->getTileAndPolyByRefUnsafe(endRef, &endMeshTile, &unused);
+
+    const int sx = startMeshTile->header->x;
+    const int sy = startMeshTile->header->y;
+    const int ex = endMeshTile->header->x;
+    const int ey = endMeshTile->header->y;
+
+    // Short queries are cheaper on the polygons directly
+    if (std::max(std::abs(ex - sx), std::abs(ey - sy)) < _minTileDistance ||
+        sx >= _tilesW || sy >= _tilesH || ex >= _tilesW || ey >= _tilesH)
+    {
+        return query.findPath(startPos, endPos, result);
+    }
+
+    const int startTile = sx + sy * _tilesW;
+    const int endTile = ex + ey * _tilesW;
+
+    _getPortalCosts(navMesh, filter, startTile, startRef, startNearest, _startCosts);
+    _getPortalCosts(navMesh, filter, endTile, endRef, endNearest, _endCosts);
+
+    //
+    // A* over the portals. Node GOAL stands for the end position; each node
+    // remembers the tile it was reached through.
+    //
+    const int GOAL = (int)_portals.size();
+    _beginSearch(GOAL + 1);
+    typedef std::greater<std::pair<float, int>> MinHeap;
+
+    auto relax = [&](int node, float cost, int from, int tile)
+    {
+        SearchNode& searchNode = _getSearchNode(node);
+        if (searchNode.Closed || cost >= searchNode.G)
+            return;
+        searchNode.G = cost;
+        searchNode.Parent = from;
+        searchNode.ViaTile = tile;
+        const float h = node == GOAL ? 0.0f : dtVdist(_portals[node].Pos, endNearest);
+        _open.push_back(std::make_pair(cost + h, node));
+        std::push_heap(_open.begin(), _open.end(), MinHeap());
+    };
+
+    const Tile& start = _tiles[startTile];
+    for (size_t i = 0; i < start.Portals.size(); ++i)
+    {
+        if (_startCosts[i] < FLT_MAX)
+            relax(start.Portals[i], _startCosts[i], -1, startTile);
+    }
+
+    while (!_open.empty())
+    {
+        std::pop_heap(_open.begin(), _open.end(), MinHeap());
+        const int node = _open.back().second;
+        _open.pop_back();
+
+        SearchNode& searchNode = _getSearchNode(node);
+        if (searchNode.Closed)
+            continue;
+        searchNode.Closed = true;
+        if (node == GOAL)
+            break;
+
+        const float g = searchNode.G;
+        const Portal& portal = _portals[node];
+        for (int side = 0; side < 2; ++side)
+        {
+            const int tileIndex = portal.Tiles[side];
+            const Tile& tile = _tiles[tileIndex];
+            const int count = (int)tile.Portals.size();
+            const int slot = portal.Slots[side];
+
+            for (int j = 0; j < count; ++j)
+            {
+                const float cost = tile.Costs[slot * count + j];
+                if (j != slot && cost < FLT_MAX)
+                    relax(tile.Portals[j], g + cost, node, tileIndex);
+            }
+
+            if (tileIndex == endTile && _endCosts[slot] < FLT_MAX)
+                relax(GOAL, g + _endCosts[slot], node, tileIndex);
+        }
+    }
+
+    if (!_getSearchNode(GOAL).Closed)
+    {
+        // No portal route: the end may only be partly reachable, or the route
+        // leaves and re-enters a tile the graph does not model; search directly
+        return query.findPath(startPos, endPos, result);
+    }
+
+    // Portal chain from start to end
+    _chain.clear();
+    for (int node = _getSearchNode(GOAL).Parent; node >= 0; node = _getSearchNode(node).Parent)
+        _chain.push_back(node);
+    std::reverse(_chain.begin(), _chain.end());
+
+    //
+    // Refine: a short polygon search inside each tile on the route, from
+    // where the previous portal was crossed to the next portal
+    //
+    dtNavMeshQuery* navQuery = query.getQuery();
+    _corridor.clear();
+    _segment.resize(MAX_SEGMENT_POLYS);
+
+    dtPolyRef fromRef = startRef;
+    float fromPos[3];
+    dtVcopy(fromPos, startNearest);
+
+    for (size_t i = 0; i <= _chain.size(); ++i)
+    {
+        const bool last = i == _chain.size();
+        const int tileIndex = _getSearchNode(last ? GOAL : _chain[i]).ViaTile;
+        const dtPolyRef toRef = last ? endRef : _getPortalPoly(_portals[_chain[i]], tileIndex);
+        const float* toPos = last ? endNearest : _portals[_chain[i]].Pos;
+
+        // A portal joins two tiles; continue from its polygon on the side of the next tile
+        if (i > 0)
+        {
+            const dtPolyRef sideRef = _getPortalPoly(_portals[_chain[i - 1]], tileIndex);
+            if (sideRef != fromRef)
+            {
+                appendCorridor(_corridor, &sideRef, 1);
+                fromRef = sideRef;
+            }
+        }
+
+        int segmentCount = 0;
+        const dtStatus status = navQuery->findPath(fromRef, toRef, fromPos, toPos, &filter, _segment.data(), &segmentCount, MAX_SEGMENT_POLYS);
+        if (dtStatusFailed(status) || segmentCount == 0 || _segment[segmentCount - 1] != toRef)
+        {
+            // The graph is out of date here; search the whole way instead
+            return query.findPath(startPos, endPos, result);
+        }
+        appendCorridor(_corridor, _segment.data(), segmentCount);
+
+        fromRef = toRef;
+        dtVcopy(fromPos, toPos);
+    }
+
+    return query.straightenPath(startNearest, endNearest, _corridor.data(), (int)_corridor.size(), endRef, result);
+}
+
+void CTileClusterGraph::_beginSearch(int nodeCount)
+{
+    if ((int)_searchNodes.size() < nodeCount)
+        _searchNodes.resize(nodeCount);
+    _open.clear();
+
+    // Stamps of old searches are all below the new generation, until it wraps
+    if (++_generation == 0)
+    {
+        for (SearchNode& node : _searchNodes)
+            node.Stamp = 0;
+        _generation = 1;
+    }
+}
+
+CTileClusterGraph::SearchNode& CTileClusterGraph::_getSearchNode(int index)
+{
+    SearchNode& node = _searchNodes[index];
+    if (node.Stamp != _generation)
+    {
+        node.G = FLT_MAX;
+        node.Parent = -1;
+        node.ViaTile = -1;
+        node.Closed = false;
+        node.Stamp = _generation;
+    }
+    return node;
+}
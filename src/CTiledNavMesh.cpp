@@ -1,6 +1,15 @@
 #include "IrrRecastDetour/CTiledNavMesh.h"
+#include "IrrRecastDetour/CNavQueryContext.h"
 #include <irrlicht.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 // Use explicit namespaces
 using irr::core::vector3df;
 using irr::core::matrix4;
@@ -12,7 +21,7 @@ using namespace scene;
 
 CTiledNavMesh::CTiledNavMesh(irr::scene::ISceneNode* parent, irr::scene::ISceneManager* mgr, irr::s32 id)
     : INavMesh(parent, mgr, id), // Call the base constructor
-    _ctx(new rcContext(true)), // true = enable logging
+    _ctx(new CNavMeshBuildContext(true)), // true = enable logging
     _nverts(0),
     _ntris(0),
     _tileSize(0)
@@ -26,6 +35,10 @@ CTiledNavMesh::~CTiledNavMesh()
     {
         _naviDebugParent->remove();
     }
+    if (_levelNode)
+    {
+        _levelNode->drop();
+    }
 }
 
 bool CTiledNavMesh::build(IMeshSceneNode* levelNode, const NavMeshParams& params, const int tileSize)
@@ -39,34 +52,123 @@ bool CTiledNavMesh::build(IMeshSceneNode* levelNode, const NavMeshParams& params
     _params = params;
     _tileSize = tileSize;
     _totalBuildTimeMs = 0.0f;
+    _totalTileCpuTimeMs = 0.0f;
 
     // Store defaults for the base class
     _defaultAgentRadius = _params.AgentRadius;
     _defaultAgentHeight = _params.AgentHeight;
 
+    // Hold on to the node before the previous one (possibly the same) is dropped
+    levelNode->grab();
+
     // Clear previous build data
-    _navMesh.reset();
-    _navQuery.reset();
-    _crowd.reset();
-    _tileDMeshes.clear();
-    if (_naviDebugParent)
-    {
-        _naviDebugParent->remove();
-        _naviDebugParent = nullptr;
-    }
+    _resetDetour();
+    _clearBuildData();
 
-    _ctx->resetTimers();
-    _ctx->startTimer(RC_TIMER_TOTAL);
+    _levelNode = levelNode;
 
     //
     // Step 1. Extract Irrlicht geometry
     //
-    if (!this->_getMeshBufferData(levelNode))
+    std::vector<unsigned char> triAreaOverrides;
+    if (!this->_getMeshBufferData(levelNode, _verts, _tris, triAreaOverrides))
     {
         printf("ERROR: TiledNavMesh::build: _getMeshBufferData() failed.\n");
         return false;
     }
+    _levelTransform = levelNode->getAbsoluteTransformation();
+
+    return _buildFromInput(triAreaOverrides);
+}
+
+std::shared_future<bool> CTiledNavMesh::buildAsync(IMeshSceneNode* levelNode, const NavMeshParams& params, const int tileSize)
+{
+    if (!levelNode)
+    {
+        printf("ERROR: TiledNavMesh::buildAsync: levelNode is null.\n");
+        return std::shared_future<bool>();
+    }
+    if (isBuildPending())
+    {
+        printf("ERROR: TiledNavMesh::buildAsync: A background build is already running.\n");
+        return std::shared_future<bool>();
+    }
 
+    // The worker builds into a detached node, so this one stays usable meanwhile
+    CTiledNavMesh* builder = new CTiledNavMesh(nullptr, SceneManager);
+    builder->_params = params;
+    builder->_tileSize = tileSize;
+    // The main thread keeps rendering meanwhile, so by default it keeps a core
+    builder->_buildThreadCount = _buildThreadCount > 0 ? _buildThreadCount :
+        std::max(1, (int)std::thread::hardware_concurrency() - 1);
+    builder->_clusterPathfinding = _clusterPathfinding;
+    builder->_clusterGraph.setMinTileDistance(_clusterGraph.getMinTileDistance());
+    builder->_defaultAgentRadius = params.AgentRadius;
+    builder->_defaultAgentHeight = params.AgentHeight;
+    builder->_bufferAreas = _bufferAreas;
+    builder->_materialAreas = _materialAreas;
+    builder->_minIslandSize = _minIslandSize;
+    builder->_buildProgressLog = _buildProgressLog;
+    builder->_crowdParams = _crowdParams;
+
+    levelNode->grab();
+    builder->_levelNode = levelNode;
+
+    // Irrlicht meshes are not thread-safe, so the geometry is copied here
+    std::vector<unsigned char> triAreaOverrides;
+    if (!builder->_getMeshBufferData(levelNode, builder->_verts, builder->_tris, triAreaOverrides))
+    {
+        printf("ERROR: TiledNavMesh::buildAsync: _getMeshBufferData() failed.\n");
+        builder->drop();
+        return std::shared_future<bool>();
+    }
+    builder->_levelTransform = levelNode->getAbsoluteTransformation();
+
+    return _startPendingBuild(builder, [builder, overrides = std::move(triAreaOverrides)]()
+    {
+        return builder->_buildFromInput(overrides);
+    });
+}
+
+void CTiledNavMesh::_adoptBuild(INavMesh& other)
+{
+    CTiledNavMesh& builder = static_cast<CTiledNavMesh&>(other);
+
+    // _clearBuildData() has released our level node already
+    std::swap(_levelNode, builder._levelNode);
+
+    _verts.swap(builder._verts);
+    _tris.swap(builder._tris);
+    _nverts = builder._nverts;
+    _ntris = builder._ntris;
+    _triareas.swap(builder._triareas);
+    _triGrid = std::move(builder._triGrid);
+    _levelTransform = builder._levelTransform;
+    _removedTris.clear();
+    _removedTriCount = 0;
+    _patchTris.clear();
+    _clusterGraph = std::move(builder._clusterGraph);
+    _tileDMeshes = std::move(builder._tileDMeshes);
+
+    _tileSize = builder._tileSize;
+    _tilesW = builder._tilesW;
+    _tilesH = builder._tilesH;
+    rcVcopy(_buildBMin, builder._buildBMin);
+    rcVcopy(_buildBMax, builder._buildBMax);
+    _totalBuildTimeMs = builder._totalBuildTimeMs;
+    _totalTileCpuTimeMs = builder._totalTileCpuTimeMs;
+}
+
+bool CTiledNavMesh::_buildFromInput(const std::vector<unsigned char>& triAreaOverrides)
+{
+    _buildReport = NavMeshBuildReport();
+
+    _ctx->setProgressLog(_buildProgressLog);
+    _ctx->resetTimers();
+    _ctx->startTimer(RC_TIMER_TOTAL);
+
+    _nverts = (int)_verts.size() / 3;
+    _ntris = (int)_tris.size() / 3;
     if (_nverts == 0 || _ntris == 0)
     {
             printf("ERROR: TiledNavMesh::build: No geometry found in levelNode.\n");
@@ -80,6 +182,12 @@ bool CTiledNavMesh::build(IMeshSceneNode* levelNode, const NavMeshParams& params
     _box.reset(irr::core::vector3df(bmin[0], bmin[1], bmin[2]));
     _box.addInternalPoint(irr::core::vector3df(bmax[0], bmax[1], bmax[2]));
 
+    // Index the triangles on a grid of tile-sized cells
+    _triGrid.build(_verts.data(), _tris.data(), _ntris, bmin, bmax, _tileSize * _params.CellSize);
+
+    // Slope classification does not depend on the tile, so do it once for all tiles
+    _markTriangleAreas(_ctx.get(), _params.AgentMaxSlope, _verts, _tris, triAreaOverrides, _triareas);
+
     //
     // Step 2. Initialize dtNavMesh parameters for tiling
     //
@@ -103,6 +211,11 @@ bool CTiledNavMesh::build(IMeshSceneNode* levelNode, const NavMeshParams& params
     const int tilesH = (gridH + _tileSize - 1) / _tileSize;
     dtParams.maxTiles = tilesW * tilesH;
 
+    _tilesW = tilesW;
+    _tilesH = tilesH;
+    rcVcopy(_buildBMin, bmin);
+    rcVcopy(_buildBMax, bmax);
+
     // Set max polys per tile. (A 128x128 tile is common)
     // This is a guess; 2048 is often safe.
     dtParams.maxPolys = 1 << 12; // 4096
@@ -118,60 +231,643 @@ bool CTiledNavMesh::build(IMeshSceneNode* levelNode, const NavMeshParams& params
     //
     _ctx->log(RC_LOG_PROGRESS, "Building %d x %d tiles...", tilesW, tilesH);
 
-    for (int y = 0; y < tilesH; ++y)
+    this->_buildAllTiles(tilesW, tilesH, bmin, bmax);
+
+    //
+    // Step 4. Initialize Query and Crowd (from base class)
+    //
+    if (!_initQueryAndCrowd())
     {
-        for (int x = 0; x < tilesW; ++x)
-        {
-            int dataSize = 0;
-            unsigned char* data = _buildTile(x, y, bmin, bmax, dataSize);
+        _ctx->log(RC_LOG_ERROR, "build: Could not init Detour navmesh query and crowd");
+        return false;
+    }
+
+    if (_clusterPathfinding)
+    {
+        _clusterGraph.build(_navMesh.get(), _query->getFilter(), tilesW, tilesH);
+        _ctx->log(RC_LOG_PROGRESS, "Tile cluster graph: %d portals.", _clusterGraph.getPortalCount());
+    }
+
+    _ctx->stopTimer(RC_TIMER_TOTAL);
+    _totalBuildTimeMs = _ctx->getAccumulatedTime(RC_TIMER_TOTAL) / 1000.0f;
+    _fillBuildReport(_ctx.get());
+    _ctx->log(RC_LOG_PROGRESS, ">> Tiled build complete in %.1f ms (%.1f ms summed over tiles).", _totalBuildTimeMs, _totalTileCpuTimeMs);
+
+    return true;
+}
+
 
-            if (data)
+void CTiledNavMesh::_buildAllTiles(
+    const int tilesW, const int tilesH,
+    const float* bmin, const float* bmax)
+{
+    const int tileCount = tilesW * tilesH;
+    _tileDMeshes.clear();
+    _tileDMeshes.resize(tileCount);
+    _buildReport.Tiles.resize(tileCount);
+
+    int threadCount = _buildThreadCount;
+    if (threadCount <= 0)
+        threadCount = (int)std::thread::hardware_concurrency();
+    if (threadCount > tileCount)
+        threadCount = tileCount;
+    if (threadCount < 1)
+        threadCount = 1;
+
+    //
+    // Serial build: every tile is built and added on this thread.
+    //
+    if (threadCount == 1)
+    {
+        for (int y = 0; y < tilesH; ++y)
+        {
+            for (int x = 0; x < tilesW; ++x)
             {
-                // Add the tile data to the navmesh
-                if (dtStatusFailed(_navMesh->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, nullptr)))
+                const auto tileStart = std::chrono::steady_clock::now();
+                const double cpuStart = CNavMeshBuildContext::getThreadCpuTimeMs();
+
+                int dataSize = 0;
+                unsigned char* data = _buildTile(_ctx.get(), x, y, bmin, bmax, dataSize, _tileDMeshes[x + y * tilesW]);
+
+                const float buildTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - tileStart).count();
+                const float cpuTimeMs = (float)(CNavMeshBuildContext::getThreadCpuTimeMs() - cpuStart);
+                _totalTileCpuTimeMs += cpuTimeMs;
+                _setTileReport(x, y, buildTimeMs, cpuTimeMs, data);
+
+                if (data)
                 {
-                    _ctx->log(RC_LOG_ERROR, "Failed to add tile %d, %d.", x, y);
-                    dtFree(data);
+                    // Add the tile data to the navmesh
+                    if (dtStatusFailed(_navMesh->addTile(data, dataSize, DT_TILE_FREE_DATA, 0, nullptr)))
+                    {
+                        _ctx->log(RC_LOG_ERROR, "Failed to add tile %d, %d.", x, y);
+                        dtFree(data);
+                    }
                 }
             }
         }
+        return;
     }
 
     //
-    // Step 4. Initialize Query and Crowd (from base class)
+    // Parallel build: workers pull tile indices from a shared counter and build
+    // them with their own rcContext. This thread adds the finished tiles in row
+    // order, which keeps the result identical to the serial build.
     //
-    _navQuery.reset(dtAllocNavMeshQuery());
-    if (dtStatusFailed(_navQuery->init(_navMesh.get(), 2048)))
+    _ctx->log(RC_LOG_PROGRESS, "Using %d build threads.", threadCount);
+
+    struct TileResult
     {
-        _ctx->log(RC_LOG_ERROR, "build: Could not init Detour navmesh query");
-        return false;
+        unsigned char* data = nullptr;
+        int dataSize = 0;
+        float buildTimeMs = 0.0f;
+        float cpuTimeMs = 0.0f;
+        bool done = false;
+    };
+    std::vector<TileResult> results(tileCount);
+
+    std::atomic<int> nextTile(0);
+    std::mutex resultMutex;
+    std::condition_variable resultReady;
+
+    auto worker = [&]()
+    {
+        CNavMeshBuildContext ctx(true);
+        ctx.setProgressLog(_buildProgressLog);
+
+        for (;;)
+        {
+            const int i = nextTile++;
+            if (i >= tileCount)
+                break;
+
+            const auto tileStart = std::chrono::steady_clock::now();
+            const double cpuStart = CNavMeshBuildContext::getThreadCpuTimeMs();
+
+            int dataSize = 0;
+            unsigned char* data = _buildTile(&ctx, i % tilesW, i / tilesW, bmin, bmax, dataSize, _tileDMeshes[i]);
+
+            const float buildTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - tileStart).count();
+            const float cpuTimeMs = (float)(CNavMeshBuildContext::getThreadCpuTimeMs() - cpuStart);
+
+            {
+                std::lock_guard<std::mutex> lock(resultMutex);
+                results[i].data = data;
+                results[i].dataSize = dataSize;
+                results[i].buildTimeMs = buildTimeMs;
+                results[i].cpuTimeMs = cpuTimeMs;
+                results[i].done = true;
+            }
+            resultReady.notify_one();
+        }
+
+        std::lock_guard<std::mutex> lock(resultMutex);
+        _ctx->mergeTimers(ctx);
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount);
+    for (int i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back(worker);
+    }
+
+    for (int i = 0; i < tileCount; ++i)
+    {
+        TileResult result;
+        {
+            std::unique_lock<std::mutex> lock(resultMutex);
+            resultReady.wait(lock, [&]() { return results[i].done; });
+            result = results[i];
+        }
+
+        _totalTileCpuTimeMs += result.cpuTimeMs;
+        _setTileReport(i % tilesW, i / tilesW, result.buildTimeMs, result.cpuTimeMs, result.data);
+
+        if (result.data)
+        {
+            if (dtStatusFailed(_navMesh->addTile(result.data, result.dataSize, DT_TILE_FREE_DATA, 0, nullptr)))
+            {
+                _ctx->log(RC_LOG_ERROR, "Failed to add tile %d, %d.", i % tilesW, i / tilesW);
+                dtFree(result.data);
+            }
+        }
+    }
+
+    for (auto& thread : workers)
+    {
+        thread.join();
     }
+}
 
-    _crowd.reset(dtAllocCrowd());
-    if (!_crowd)
+bool CTiledNavMesh::rebuildTiles(const irr::core::aabbox3df& box)
+{
+    if (!_navMesh || !_levelNode || _tileDMeshes.empty())
     {
-        _ctx->log(RC_LOG_ERROR, "build: Could not alloc crowd");
+        printf("ERROR: TiledNavMesh::rebuildTiles: Nothing to rebuild. Call build() first.\n");
         return false;
     }
 
-    if (!_crowd->init(MAX_AGENTS, _params.AgentRadius, _navMesh.get()))
+    // A threaded crowd step must not see tiles change
+    _finishCrowdStep();
+
+    if (box.MaxEdge.X < _buildBMin[0] || box.MinEdge.X > _buildBMax[0] ||
+        box.MaxEdge.Z < _buildBMin[2] || box.MinEdge.Z > _buildBMax[2])
+    {
+        printf("WARNING: TiledNavMesh::rebuildTiles: Box is outside the navmesh bounds.\n");
+        return true;
+    }
+
+    _ctx->setProgressLog(_buildProgressLog);
+    _ctx->resetTimers();
+    _ctx->startTimer(RC_TIMER_TOTAL);
+
+    // Tiles overlapping the box
+    const float tileWorldSize = _tileSize * _params.CellSize;
+    auto tileIndex = [&](float v, float orig, int count)
+    {
+        return std::min(std::max((int)floorf((v - orig) / tileWorldSize), 0), count - 1);
+    };
+    int tx0 = tileIndex(box.MinEdge.X, _buildBMin[0], _tilesW);
+    int tx1 = tileIndex(box.MaxEdge.X, _buildBMin[0], _tilesW);
+    int ty0 = tileIndex(box.MinEdge.Z, _buildBMin[2], _tilesH);
+    int ty1 = tileIndex(box.MaxEdge.Z, _buildBMin[2], _tilesH);
+
+    //
+    // Step 1. Refresh the cached geometry around the affected tiles, as far
+    // as their (border-expanded) bounds reach
+    //
+    const float border = ((int)ceilf(_params.AgentRadius / _params.CellSize) + 3) * _params.CellSize;
+    const float regionMin[3] = { _buildBMin[0] + tx0 * tileWorldSize - border, 0.0f, _buildBMin[2] + ty0 * tileWorldSize - border };
+    const float regionMax[3] = { _buildBMin[0] + (tx1 + 1) * tileWorldSize + border, 0.0f, _buildBMin[2] + (ty1 + 1) * tileWorldSize + border };
+
+    bool heightChanged = false;
+    if (!_updateRegionGeometry(regionMin, regionMax, heightChanged))
     {
-        _ctx->log(RC_LOG_ERROR, "build: Could not init crowd");
+        printf("ERROR: TiledNavMesh::rebuildTiles: Could not read the level geometry.\n");
         return false;
     }
 
+    // Tiles are voxelized from the bottom of the build bounds. Once that moves,
+    // tiles left as they are would no longer line up with rebuilt neighbours.
+    if (heightChanged)
+    {
+        _ctx->log(RC_LOG_PROGRESS, "Geometry left the height range of the build, rebuilding all tiles.");
+        tx0 = 0;
+        ty0 = 0;
+        tx1 = _tilesW - 1;
+        ty1 = _tilesH - 1;
+    }
+
+    //
+    // Step 2. Build the replacement tiles
+    //
+    struct NewTile
+    {
+        int tx, ty;
+        unsigned char* data;
+        int dataSize;
+    };
+    std::vector<NewTile> newTiles;
+
+    for (int ty = ty0; ty <= ty1; ++ty)
+    {
+        for (int tx = tx0; tx <= tx1; ++tx)
+        {
+            auto& dmesh = _tileDMeshes[tx + ty * _tilesW];
+            dmesh.reset();
+
+            const auto tileStart = std::chrono::steady_clock::now();
+            const double cpuStart = CNavMeshBuildContext::getThreadCpuTimeMs();
+
+            int dataSize = 0;
+            unsigned char* data = _buildTile(_ctx.get(), tx, ty, _buildBMin, _buildBMax, dataSize, dmesh);
+            newTiles.push_back({ tx, ty, data, dataSize });
+
+            _setTileReport(tx, ty,
+                std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - tileStart).count(),
+                (float)(CNavMeshBuildContext::getThreadCpuTimeMs() - cpuStart), data);
+        }
+    }
+
+    //
+    // Step 3. Swap them in. Agents keep their state; crowd paths through the
+    // replaced tiles no longer validate and are re-planned.
+    //
+    bool ok = true;
+    for (const NewTile& tile : newTiles)
+    {
+        const dtTileRef oldRef = _navMesh->getTileRefAt(tile.tx, tile.ty, 0);
+        if (oldRef)
+        {
+            _navMesh->removeTile(oldRef, nullptr, nullptr);
+        }
+
+        if (tile.data && dtStatusFailed(_navMesh->addTile(tile.data, tile.dataSize, DT_TILE_FREE_DATA, 0, nullptr)))
+        {
+            _ctx->log(RC_LOG_ERROR, "Failed to add tile %d, %d.", tile.tx, tile.ty);
+            dtFree(tile.data);
+            ok = false;
+        }
+    }
+
+    // Only the portals around the replaced tiles change
+    if (_clusterGraph.isBuilt())
+    {
+        _clusterGraph.updateTiles(_navMesh.get(), _query->getFilter(), tx0, ty0, tx1, ty1);
+    }
+
+    _onTilesChanged();
+
     _ctx->stopTimer(RC_TIMER_TOTAL);
-    _totalBuildTimeMs = _ctx->getAccumulatedTime(RC_TIMER_TOTAL) / 1000.0f;
-    _ctx->log(RC_LOG_PROGRESS, ">> Tiled build complete in %.1f ms.", _totalBuildTimeMs);
+    _fillBuildReport(_ctx.get());
+    _ctx->log(RC_LOG_PROGRESS, ">> Rebuilt %d tiles in %.1f ms.", (int)newTiles.size(), _ctx->getAccumulatedTime(RC_TIMER_TOTAL) / 1000.0f);
+
+    // Refresh the debug meshes if they are shown
+    if (_naviDebugParent)
+    {
+        renderNavMesh();
+    }
+
+    return ok;
+}
+
+void CTiledNavMesh::setClusterPathfinding(bool enabled, int minTileDistance)
+{
+    _clusterPathfinding = enabled;
+    _clusterGraph.setMinTileDistance(minTileDistance);
+
+    if (!enabled)
+    {
+        _clusterGraph.clear();
+    }
+    else if (_navMesh && _query && !_clusterGraph.isBuilt())
+    {
+        _clusterGraph.build(_navMesh.get(), _query->getFilter(), _tilesW, _tilesH);
+    }
+}
+
+PathStatus CTiledNavMesh::findClusterPath(const vector3df& startPos, const vector3df& endPos, PathResult& result)
+{
+    if (!_query)
+    {
+        return GetPath(startPos, endPos, result);
+    }
 
+    // A loaded navmesh gets its graph on first use
+    if (_clusterPathfinding && !_clusterGraph.isBuilt())
+    {
+        _clusterGraph.build(_navMesh.get(), _query->getFilter(), _tilesW, _tilesH);
+    }
+
+    if (!_clusterGraph.isBuilt())
+    {
+        return _query->findPath(startPos, endPos, result);
+    }
+
+    return _clusterGraph.findPath(*_query, startPos, endPos, result);
+}
+
+void CTiledNavMesh::_setTileReport(const int tx, const int ty, const float buildTimeMs, const float cpuTimeMs, const unsigned char* tileData)
+{
+    const size_t index = tx + ty * _tilesW;
+    if (index >= _buildReport.Tiles.size())
+        return;
+
+    NavMeshTileReport& report = _buildReport.Tiles[index];
+    report.TileX = tx;
+    report.TileY = ty;
+    report.BuildTimeMs = buildTimeMs;
+    report.CpuTimeMs = cpuTimeMs;
+    report.PolyCount = 0;
+    report.VertCount = 0;
+
+    if (tileData)
+    {
+        const dtMeshHeader* header = (const dtMeshHeader*)tileData;
+        report.PolyCount = header->polyCount;
+        report.VertCount = header->vertCount;
+    }
+}
+
+void CTiledNavMesh::_clearBuildData()
+{
+    _tileDMeshes.clear();
+    _triGrid.clear();
+    _clusterGraph.clear();
+    _triareas.clear();
+    _removedTris.clear();
+    _removedTriCount = 0;
+    _patchTris.clear();
+
+    if (_levelNode)
+    {
+        _levelNode->drop();
+        _levelNode = nullptr;
+    }
+
+    if (_naviDebugParent)
+    {
+        _naviDebugParent->remove();
+        _naviDebugParent = nullptr;
+    }
+}
+
+INavMesh::TileGrid CTiledNavMesh::_getTileGrid() const
+{
+    TileGrid grid;
+    grid.TileSize = _tileSize;
+    grid.TilesW = _tilesW;
+    grid.TilesH = _tilesH;
+    rcVcopy(grid.BMin, _buildBMin);
+    rcVcopy(grid.BMax, _buildBMax);
+    return grid;
+}
+
+void CTiledNavMesh::_setTileGrid(const TileGrid& grid)
+{
+    // The cluster graph of a loaded navmesh is laid out on this grid
+    _tileSize = grid.TileSize;
+    _tilesW = grid.TilesW;
+    _tilesH = grid.TilesH;
+    rcVcopy(_buildBMin, grid.BMin);
+    rcVcopy(_buildBMax, grid.BMax);
+}
+
+bool CTiledNavMesh::_reloadLevelGeometry(bool& heightChanged)
+{
+    std::vector<unsigned char> triAreaOverrides;
+    if (!_getMeshBufferData(_levelNode, _verts, _tris, triAreaOverrides))
+        return false;
+
+    _levelTransform = _levelNode->getAbsoluteTransformation();
+    _nverts = (int)_verts.size() / 3;
+    _ntris = (int)_tris.size() / 3;
+    _removedTris.clear();
+    _removedTriCount = 0;
+    _patchTris.clear();
+
+    if (_nverts > 0)
+    {
+        float bmin[3], bmax[3];
+        rcCalcBounds(_verts.data(), _nverts, bmin, bmax);
+        heightChanged = _extendBuildHeight(bmin[1], bmax[1]);
+    }
+
+    _triGrid.build(_verts.data(), _tris.data(), _ntris, _buildBMin, _buildBMax, _tileSize * _params.CellSize);
+    _markTriangleAreas(_ctx.get(), _params.AgentMaxSlope, _verts, _tris, triAreaOverrides, _triareas);
+    return true;
+}
+
+bool CTiledNavMesh::_extendBuildHeight(const float minY, const float maxY)
+{
+    if (minY >= _buildBMin[1] && maxY <= _buildBMax[1])
+        return false;
+
+    _buildBMin[1] = std::min(_buildBMin[1], minY);
+    _buildBMax[1] = std::max(_buildBMax[1], maxY);
+    _box.MinEdge.Y = std::min(_box.MinEdge.Y, minY);
+    _box.MaxEdge.Y = std::max(_box.MaxEdge.Y, maxY);
+    return true;
+}
+
+bool CTiledNavMesh::_updateRegionGeometry(const float* regionMin, const float* regionMax, bool& heightChanged)
+{
+    heightChanged = false;
+
+    irr::scene::IMesh* mesh = _levelNode->getMesh();
+    if (!mesh)
+        return false;
+
+    // A moved node moves every triangle
+    const matrix4& transform = _levelNode->getAbsoluteTransformation();
+    if (!(transform == _levelTransform))
+        return _reloadLevelGeometry(heightChanged);
+
+    // Drop the cached triangles of the region. The grid still holds those
+    // dropped by earlier calls, so only count each one once.
+    _removedTris.resize(_ntris, 0);
+    std::vector<int> regionTris;
+    _triGrid.query(regionMin, regionMax, regionTris);
+    for (int tri : regionTris)
+    {
+        if (!_removedTris[tri])
+        {
+            _removedTris[tri] = 1;
+            _removedTriCount++;
+        }
+    }
+
+    size_t keptPatch = 0;
+    for (int tri : _patchTris)
+    {
+        if (_triOverlaps(tri, regionMin, regionMax))
+        {
+            _removedTris[tri] = 1;
+            _removedTriCount++;
+        }
+        else
+        {
+            _patchTris[keptPatch++] = tri;
+        }
+    }
+    _patchTris.resize(keptPatch);
+
+    // Buffers are tested in their own space, so only the vertices near the
+    // region are transformed. The box spans the height of the level.
+    const irr::core::aabbox3df nodeBox = _levelNode->getTransformedBoundingBox();
+    irr::core::aabbox3df localBox(
+        regionMin[0], std::min(_buildBMin[1], nodeBox.MinEdge.Y), regionMin[2],
+        regionMax[0], std::max(_buildBMax[1], nodeBox.MaxEdge.Y), regionMax[2]);
+    matrix4 inverse;
+    const bool localTest = transform.getInverse(inverse);
+    if (localTest)
+        inverse.transformBoxEx(localBox);
+
+    // Read the triangles of the region again. Each gets its own three vertices;
+    // the ones it replaced stay unused until _compactGeometry().
+    float minY = FLT_MAX;
+    float maxY = -FLT_MAX;
+    std::vector<int> newTris;
+    std::vector<unsigned char> newOverrides;
+    for (irr::u32 i = 0; i < mesh->getMeshBufferCount(); ++i)
+    {
+        irr::scene::IMeshBuffer* buffer = mesh->getMeshBuffer(i);
+        if (buffer->getVertexCount() == 0 || buffer->getIndexCount() < 3)
+            continue;
+        if (localTest && !buffer->getBoundingBox().intersectsWithBox(localBox))
+            continue;
+
+        const unsigned char areaOverride = _getMeshBufferAreaOverride(i, buffer);
+        const irr::u16* indices16 = buffer->getIndices();
+        const irr::u32* indices32 = (const irr::u32*)indices16;
+        const bool is16 = buffer->getIndexType() == irr::video::EIT_16BIT;
+
+        for (irr::u32 j = 0; j + 2 < buffer->getIndexCount(); j += 3)
+        {
+            vector3df pos[3];
+            for (int k = 0; k < 3; ++k)
+                pos[k] = buffer->getPosition(is16 ? indices16[j + k] : indices32[j + k]);
+
+            if (localTest)
+            {
+                irr::core::aabbox3df triBox(pos[0]);
+                triBox.addInternalPoint(pos[1]);
+                triBox.addInternalPoint(pos[2]);
+                if (!triBox.intersectsWithBox(localBox))
+                    continue;
+            }
+
+            for (int k = 0; k < 3; ++k)
+                transform.transformVect(pos[k]);
+
+            // The same test as _triOverlaps(), so every replaced triangle is read again
+            if (std::min(pos[0].X, std::min(pos[1].X, pos[2].X)) > regionMax[0] ||
+                std::max(pos[0].X, std::max(pos[1].X, pos[2].X)) < regionMin[0] ||
+                std::min(pos[0].Z, std::min(pos[1].Z, pos[2].Z)) > regionMax[2] ||
+                std::max(pos[0].Z, std::max(pos[1].Z, pos[2].Z)) < regionMin[2])
+                continue;
+
+            for (int k = 0; k < 3; ++k)
+            {
+                newTris.push_back((int)_verts.size() / 3);
+                _verts.push_back(pos[k].X);
+                _verts.push_back(pos[k].Y);
+                _verts.push_back(pos[k].Z);
+
+                minY = std::min(minY, pos[k].Y);
+                maxY = std::max(maxY, pos[k].Y);
+            }
+            newOverrides.push_back(areaOverride);
+        }
+    }
+
+    std::vector<unsigned char> newAreas;
+    _markTriangleAreas(_ctx.get(), _params.AgentMaxSlope, _verts, newTris, newOverrides, newAreas);
+
+    for (size_t i = 0; i < newAreas.size(); ++i)
+        _patchTris.push_back(_ntris + (int)i);
+    _tris.insert(_tris.end(), newTris.begin(), newTris.end());
+    _triareas.insert(_triareas.end(), newAreas.begin(), newAreas.end());
+    _nverts = (int)_verts.size() / 3;
+    _ntris = (int)_tris.size() / 3;
+    _removedTris.resize(_ntris, 0);
+
+    if (!newAreas.empty())
+        heightChanged = _extendBuildHeight(minY, maxY);
+
+    // Repeated edits of the same area would otherwise grow the cache without
+    // bound. Every tile scans the added triangles, so once there are many they
+    // go into the grid as well.
+    if (_removedTriCount * 4 > _ntris)
+    {
+        _compactGeometry();
+    }
+    else if (_patchTris.size() > 4096 && _patchTris.size() * 8 > (size_t)_ntris)
+    {
+        _triGrid.build(_verts.data(), _tris.data(), _ntris, _buildBMin, _buildBMax, _tileSize * _params.CellSize);
+        _patchTris.clear();
+    }
     return true;
 }
 
+void CTiledNavMesh::_compactGeometry()
+{
+    std::vector<int> vertRemap(_nverts, -1);
+    std::vector<float> verts;
+    std::vector<int> tris;
+    std::vector<unsigned char> triareas;
+    verts.reserve(_verts.size());
+    tris.reserve((_ntris - _removedTriCount) * 3);
+    triareas.reserve(_ntris - _removedTriCount);
+
+    for (int i = 0; i < _ntris; ++i)
+    {
+        if (!_removedTris.empty() && _removedTris[i])
+            continue;
+
+        for (int k = 0; k < 3; ++k)
+        {
+            const int v = _tris[i * 3 + k];
+            if (vertRemap[v] < 0)
+            {
+                vertRemap[v] = (int)verts.size() / 3;
+                verts.insert(verts.end(), &_verts[v * 3], &_verts[v * 3] + 3);
+            }
+            tris.push_back(vertRemap[v]);
+        }
+        triareas.push_back(_triareas[i]);
+    }
+
+    _verts.swap(verts);
+    _tris.swap(tris);
+    _triareas.swap(triareas);
+    _nverts = (int)_verts.size() / 3;
+    _ntris = (int)_tris.size() / 3;
+    _removedTris.clear();
+    _removedTriCount = 0;
+    _patchTris.clear();
+
+    _triGrid.build(_verts.data(), _tris.data(), _ntris, _buildBMin, _buildBMax, _tileSize * _params.CellSize);
+}
+
+bool CTiledNavMesh::_triOverlaps(int tri, const float* qmin, const float* qmax) const
+{
+    const float* v0 = &_verts[_tris[tri * 3 + 0] * 3];
+    const float* v1 = &_verts[_tris[tri * 3 + 1] * 3];
+    const float* v2 = &_verts[_tris[tri * 3 + 2] * 3];
+
+    return !(std::min(v0[0], std::min(v1[0], v2[0])) > qmax[0] ||
+             std::max(v0[0], std::max(v1[0], v2[0])) < qmin[0] ||
+             std::min(v0[2], std::min(v1[2], v2[2])) > qmax[2] ||
+             std::max(v0[2], std::max(v1[2], v2[2])) < qmin[2]);
+}
 
 unsigned char* CTiledNavMesh::_buildTile(
+    CNavMeshBuildContext* ctx,
     const int tx, const int ty,
     const float* bmin, const float* bmax,
-    int& dataSize)
+    int& dataSize,
+    std::unique_ptr<rcPolyMeshDetail, RecastPolyMeshDetailDeleter>& dmeshOut)
 {
     dataSize = 0;
 
@@ -209,7 +905,48 @@ unsigned char* CTiledNavMesh::_buildTile(
     cfg.bmax[0] += cfg.borderSize * cfg.cs;
     cfg.bmax[2] += cfg.borderSize * cfg.cs;
 
-    _ctx->log(RC_LOG_PROGRESS, "Building tile %d, %d...", tx, ty);
+    // Collect the triangles overlapping the (border-expanded) tile, with the
+    // changes of rebuildTiles() since the grid was built
+    std::vector<int> tileTriIds;
+    _triGrid.query(cfg.bmin, cfg.bmax, tileTriIds);
+    if (!_removedTris.empty())
+    {
+        tileTriIds.erase(std::remove_if(tileTriIds.begin(), tileTriIds.end(),
+            [this](int tri) { return _removedTris[tri] != 0; }), tileTriIds.end());
+    }
+    // Added triangles come after every gridded one, so the order stays ascending
+    for (int tri : _patchTris)
+    {
+        if (_triOverlaps(tri, cfg.bmin, cfg.bmax))
+            tileTriIds.push_back(tri);
+    }
+    const int ntris = (int)tileTriIds.size();
+
+    ctx->log(RC_LOG_PROGRESS, "Building tile %d, %d (%d of %d tris)...", tx, ty, ntris, _ntris);
+
+    if (ntris == 0)
+    {
+        return nullptr; // Nothing to rasterize
+    }
+
+    // Gather the candidates and their precomputed areas
+    std::vector<int> tileTris(ntris * 3);
+    std::vector<unsigned char> triareas(ntris);
+    bool anyWalkable = false;
+    for (int i = 0; i < ntris; ++i)
+    {
+        const int* tri = &_tris[tileTriIds[i] * 3];
+        tileTris[i * 3 + 0] = tri[0];
+        tileTris[i * 3 + 1] = tri[1];
+        tileTris[i * 3 + 2] = tri[2];
+        triareas[i] = _triareas[tileTriIds[i]];
+        anyWalkable |= triareas[i] != RC_NULL_AREA;
+    }
+
+    if (!anyWalkable)
+    {
+        return nullptr; // Only steep geometry, nothing to walk on
+    }
 
     //
     // NOTE: All Recast objects are local to this function and auto-deleted
@@ -220,65 +957,64 @@ unsigned char* CTiledNavMesh::_buildTile(
     std::unique_ptr<rcHeightfield, RecastHeightfieldDeleter> solid(rcAllocHeightfield());
     if (!solid)
     {
-        _ctx->log(RC_LOG_ERROR, "buildTile: Out of memory 'solid'.");
+        ctx->log(RC_LOG_ERROR, "buildTile: Out of memory 'solid'.");
         return nullptr;
     }
-    if (!rcCreateHeightfield(_ctx.get(), *solid, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs, cfg.ch))
+    if (!rcCreateHeightfield(ctx, *solid, cfg.width, cfg.height, cfg.bmin, cfg.bmax, cfg.cs, cfg.ch))
     {
-        _ctx->log(RC_LOG_ERROR, "buildTile: Could not create solid heightfield.");
+        ctx->log(RC_LOG_ERROR, "buildTile: Could not create solid heightfield.");
         return nullptr;
     }
 
-    std::vector<unsigned char> triareas(_ntris);
-    memset(triareas.data(), 0, _ntris * sizeof(unsigned char));
-    rcMarkWalkableTriangles(_ctx.get(), cfg.walkableSlopeAngle, _verts.data(), _nverts, _tris.data(), _ntris, triareas.data());
-    // Rasterize *all* geometry. Recast will clip it to the heightfield's bounds.
-    rcRasterizeTriangles(_ctx.get(), _verts.data(), _nverts, _tris.data(), triareas.data(), _ntris, *solid, cfg.walkableClimb);
+    // Rasterize only the triangles near this tile. Recast clips them to the heightfield's bounds.
+    rcRasterizeTriangles(ctx, _verts.data(), _nverts, tileTris.data(), triareas.data(), ntris, *solid, cfg.walkableClimb);
+    ctx->notePeakMemory(CNavMeshBuildContext::getMemoryUsage(*solid) + tileTris.size() * sizeof(int) + triareas.size());
 
     // Step 4. Filter
-    rcFilterLowHangingWalkableObstacles(_ctx.get(), cfg.walkableClimb, *solid);
-    rcFilterLedgeSpans(_ctx.get(), cfg.walkableHeight, cfg.walkableClimb, *solid);
-    rcFilterWalkableLowHeightSpans(_ctx.get(), cfg.walkableHeight, *solid);
+    rcFilterLowHangingWalkableObstacles(ctx, cfg.walkableClimb, *solid);
+    rcFilterLedgeSpans(ctx, cfg.walkableHeight, cfg.walkableClimb, *solid);
+    rcFilterWalkableLowHeightSpans(ctx, cfg.walkableHeight, *solid);
 
     // Step 5. Partition
     std::unique_ptr<rcCompactHeightfield, RecastCompactHeightfieldDeleter> chf(rcAllocCompactHeightfield());
     if (!chf)
     {
-        _ctx->log(RC_LOG_ERROR, "buildTile: Out of memory 'chf'.");
+        ctx->log(RC_LOG_ERROR, "buildTile: Out of memory 'chf'.");
         return nullptr;
     }
-    if (!rcBuildCompactHeightfield(_ctx.get(), cfg.walkableHeight, cfg.walkableClimb, *solid, *chf))
+    if (!rcBuildCompactHeightfield(ctx, cfg.walkableHeight, cfg.walkableClimb, *solid, *chf))
     {
-        _ctx->log(RC_LOG_ERROR, "buildTile: Could not build compact data.");
+        ctx->log(RC_LOG_ERROR, "buildTile: Could not build compact data.");
         return nullptr;
     }
+    ctx->notePeakMemory(CNavMeshBuildContext::getMemoryUsage(*solid) + CNavMeshBuildContext::getMemoryUsage(*chf));
 
     solid.reset(); // No longer needed
 
-    if (!rcErodeWalkableArea(_ctx.get(), cfg.walkableRadius, *chf))
+    if (!rcErodeWalkableArea(ctx, cfg.walkableRadius, *chf))
     {
-        _ctx->log(RC_LOG_ERROR, "buildTile: Could not erode.");
+        ctx->log(RC_LOG_ERROR, "buildTile: Could not erode.");
         return nullptr;
     }
 
     if (_params.MonotonePartitioning)
     {
-        if (!rcBuildRegionsMonotone(_ctx.get(), *chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
+        if (!rcBuildRegionsMonotone(ctx, *chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
         {
-            _ctx->log(RC_LOG_ERROR, "buildTile: Could not build regions.");
+            ctx->log(RC_LOG_ERROR, "buildTile: Could not build regions.");
             return nullptr;
         }
     }
     else
     {
-        if (!rcBuildDistanceField(_ctx.get(), *chf))
+        if (!rcBuildDistanceField(ctx, *chf))
         {
-            _ctx->log(RC_LOG_ERROR, "buildTile: Could not build distance field.");
+            ctx->log(RC_LOG_ERROR, "buildTile: Could not build distance field.");
             return nullptr;
         }
-        if (!rcBuildRegions(_ctx.get(), *chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
+        if (!rcBuildRegions(ctx, *chf, cfg.borderSize, cfg.minRegionArea, cfg.mergeRegionArea))
         {
-            _ctx->log(RC_LOG_ERROR, "buildTile: Could not build regions.");
+            ctx->log(RC_LOG_ERROR, "buildTile: Could not build regions.");
             return nullptr;
         }
     }
@@ -287,27 +1023,29 @@ unsigned char* CTiledNavMesh::_buildTile(
     std::unique_ptr<rcContourSet, RecastContourSetDeleter> cset(rcAllocContourSet());
     if (!cset)
     {
-        _ctx->log(RC_LOG_ERROR, "buildTile: Out of memory 'cset'.");
+        ctx->log(RC_LOG_ERROR, "buildTile: Out of memory 'cset'.");
         return nullptr;
     }
-    if (!rcBuildContours(_ctx.get(), *chf, cfg.maxSimplificationError, cfg.maxEdgeLen, *cset))
+    if (!rcBuildContours(ctx, *chf, cfg.maxSimplificationError, cfg.maxEdgeLen, *cset))
     {
-        _ctx->log(RC_LOG_ERROR, "buildTile: Could not create contours.");
+        ctx->log(RC_LOG_ERROR, "buildTile: Could not create contours.");
         return nullptr;
     }
+    ctx->notePeakMemory(CNavMeshBuildContext::getMemoryUsage(*chf) + CNavMeshBuildContext::getMemoryUsage(*cset));
 
     // Step 7. PolyMesh
     std::unique_ptr<rcPolyMesh, RecastPolyMeshDeleter> pmesh(rcAllocPolyMesh());
     if (!pmesh)
     {
-        _ctx->log(RC_LOG_ERROR, "buildTile: Out of memory 'pmesh'.");
+        ctx->log(RC_LOG_ERROR, "buildTile: Out of memory 'pmesh'.");
         return nullptr;
     }
-    if (!rcBuildPolyMesh(_ctx.get(), *cset, cfg.maxVertsPerPoly, *pmesh))
+    if (!rcBuildPolyMesh(ctx, *cset, cfg.maxVertsPerPoly, *pmesh))
     {
-        _ctx->log(RC_LOG_ERROR, "buildTile: Could not triangulate contours.");
+        ctx->log(RC_LOG_ERROR, "buildTile: Could not triangulate contours.");
         return nullptr;
     }
+    ctx->notePeakMemory(CNavMeshBuildContext::getMemoryUsage(*chf) + CNavMeshBuildContext::getMemoryUsage(*cset) + CNavMeshBuildContext::getMemoryUsage(*pmesh));
 
     cset.reset(); // No longer needed
 
@@ -315,29 +1053,23 @@ unsigned char* CTiledNavMesh::_buildTile(
     std::unique_ptr<rcPolyMeshDetail, RecastPolyMeshDetailDeleter> dmesh(rcAllocPolyMeshDetail());
     if (!dmesh)
     {
-        _ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'pmdtl'.");
+        ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'pmdtl'.");
         return nullptr;
     }
-    if (!rcBuildPolyMeshDetail(_ctx.get(), *pmesh, *chf, cfg.detailSampleDist, cfg.detailSampleMaxError, *dmesh))
+    if (!rcBuildPolyMeshDetail(ctx, *pmesh, *chf, cfg.detailSampleDist, cfg.detailSampleMaxError, *dmesh))
     {
-        _ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build detail mesh.");
+        ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build detail mesh.");
         return nullptr;
     }
+    ctx->notePeakMemory(CNavMeshBuildContext::getMemoryUsage(*chf) + CNavMeshBuildContext::getMemoryUsage(*pmesh) + CNavMeshBuildContext::getMemoryUsage(*dmesh));
 
     chf.reset(); // No longer needed
 
     // Step 9. Create Detour data
     if (cfg.maxVertsPerPoly <= DT_VERTS_PER_POLYGON)
     {
-        // Set polygon flags
-        for (int i = 0; i < pmesh->npolys; ++i)
-        {
-            if (pmesh->areas[i] == RC_WALKABLE_AREA)
-            {
-                pmesh->areas[i] = (unsigned char)PolyAreas::GROUND;
-                pmesh->flags[i] = (unsigned short)PolyFlags::WALK;
-            }
-        }
+        // Set polygon areas and flags
+        _applyPolyAreaFlags(*pmesh);
 
         dtNavMeshCreateParams dtParams;
         memset(&dtParams, 0, sizeof(dtParams));
@@ -368,20 +1100,20 @@ unsigned char* CTiledNavMesh::_buildTile(
         unsigned char* navData = nullptr;
         if (!dtCreateNavMeshData(&dtParams, &navData, &dataSize))
         {
-            _ctx->log(RC_LOG_ERROR, "Could not build Detour navmesh tile data.");
+            ctx->log(RC_LOG_ERROR, "Could not build Detour navmesh tile data.");
             return nullptr;
         }
 
-        // Store the detail mesh if we want to render it later
+        // Hand the detail mesh back if we want to render it later
         if (_params.KeepInterResults)
         {
-            _tileDMeshes.push_back(std::move(dmesh));
+            dmeshOut = std::move(dmesh);
         }
 
         return navData;
     }
 
-    _ctx->log(RC_LOG_ERROR, "maxVertsPerPoly > DT_VERTS_PER_POLYGON");
+    ctx->log(RC_LOG_ERROR, "maxVertsPerPoly > DT_VERTS_PER_POLYGON");
     return nullptr;
 }
 
@@ -450,75 +1182,7 @@ ISceneNode* CTiledNavMesh::renderNavMesh()
 }
 
 
-// --- Private Helper Functions (Copied from StaticNavMesh) ---
-
-bool CTiledNavMesh::_getMeshBufferData(IMeshSceneNode* node)
-{
-    if (!node) return false;
-    irr::scene::IMesh* mesh = node->getMesh();
-    if (!mesh) return false;
-
-    matrix4 transform = node->getAbsoluteTransformation();
-    _verts.clear();
-    _tris.clear();
-
-    irr::u32 vertexOffset = 0;
-
-    for (irr::u32 i = 0; i < mesh->getMeshBufferCount(); ++i)
-    {
-        irr::scene::IMeshBuffer* buffer = mesh->getMeshBuffer(i);
-        irr::u32 currentVertCount = buffer->getVertexCount();
-        irr::u32 currentIdxCount = buffer->getIndexCount();
-
-        if (currentVertCount == 0 || currentIdxCount == 0)
-        {
-            continue;
-        }
-
-        _verts.reserve(_verts.size() + currentVertCount * 3);
-        for (irr::u32 j = 0; j < currentVertCount; ++j)
-        {
-            vector3df pos = buffer->getPosition(j);
-            transform.transformVect(pos);
-            _verts.push_back(pos.X);
-            _verts.push_back(pos.Y);
-            _verts.push_back(pos.Z);
-        }
-
-        _tris.reserve(_tris.size() + currentIdxCount);
-        const irr::u16* indices16 = buffer->getIndices();
-        const irr::u32* indices32 = (const irr::u32*)indices16;
-
-        if (buffer->getIndexType() == irr::video::EIT_16BIT)
-        {
-            for (irr::u32 j = 0; j < currentIdxCount; ++j)
-            {
-                _tris.push_back(indices16[j] + vertexOffset);
-            }
-        }
-        else // EIT_32BIT
-        {
-            for (irr::u32 j = 0; j < currentIdxCount; ++j)
-            {
-                _tris.push_back(indices32[j] + vertexOffset);
-            }
-        }
-        vertexOffset += currentVertCount;
-    }
-
-    if (_verts.empty() || _tris.empty())
-    {
-        printf("WARNING: TiledNavMesh::_getMeshBufferData: No vertices or triangles found.\n");
-        return false;
-    }
-
-    _nverts = _verts.size() / 3;
-    _ntris = _tris.size() / 3;
-
-    printf("_getMeshBufferData: Total vertices=%d\n", _nverts);
-    printf("_getMeshBufferData: Total triangles=%d\n", _ntris);
-    return true;
-}
+// --- Private Helper Functions ---
 
 bool CTiledNavMesh::_setupIrrSMeshFromRecastDetailMesh(irr::scene::SMesh* smesh, rcPolyMeshDetail* dmesh, irr::video::SColor color)
 {
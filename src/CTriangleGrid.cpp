@@ -0,0 +1,132 @@
+#include "IrrRecastDetour/CTriangleGrid.h"
+#include <algorithm>
+#include <math.h>
+
+void CTriangleGrid::build(
+    const float* verts, const int* tris, const int ntris,
+    const float* bmin, const float* bmax,
+    const float cellSize)
+{
+    clear();
+
+    if (!verts || !tris || ntris <= 0 || cellSize <= 0.0f)
+        return;
+
+    _orig[0] = bmin[0];
+    _orig[1] = bmin[2];
+    _cellSize = cellSize;
+    _width = std::max(1, (int)ceilf((bmax[0] - bmin[0]) / cellSize));
+    _height = std::max(1, (int)ceilf((bmax[2] - bmin[2]) / cellSize));
+
+    // Compute the XZ bounds of every triangle
+    _triBounds.resize(ntris * 4);
+    for (int i = 0; i < ntris; ++i)
+    {
+        const float* v0 = &verts[tris[i * 3 + 0] * 3];
+        const float* v1 = &verts[tris[i * 3 + 1] * 3];
+        const float* v2 = &verts[tris[i * 3 + 2] * 3];
+
+        float* b = &_triBounds[i * 4];
+        b[0] = std::min(v0[0], std::min(v1[0], v2[0]));
+        b[1] = std::min(v0[2], std::min(v1[2], v2[2]));
+        b[2] = std::max(v0[0], std::max(v1[0], v2[0]));
+        b[3] = std::max(v0[2], std::max(v1[2], v2[2]));
+    }
+
+    // Pass 1: count the triangles per cell
+    const int cellCount = _width * _height;
+    _cellStart.assign(cellCount + 1, 0);
+
+    for (int i = 0; i < ntris; ++i)
+    {
+        const float* b = &_triBounds[i * 4];
+        int x0, z0, x1, z1;
+        _cellRange(b[0], b[1], b[2], b[3], x0, z0, x1, z1);
+
+        for (int z = z0; z <= z1; ++z)
+            for (int x = x0; x <= x1; ++x)
+                _cellStart[x + z * _width + 1]++;
+    }
+
+    for (int c = 0; c < cellCount; ++c)
+        _cellStart[c + 1] += _cellStart[c];
+
+    // Pass 2: fill the cell lists (triangles stay in ascending order per cell)
+    _cellTris.resize(_cellStart[cellCount]);
+    std::vector<int> fill(_cellStart.begin(), _cellStart.end() - 1);
+
+    for (int i = 0; i < ntris; ++i)
+    {
+        const float* b = &_triBounds[i * 4];
+        int x0, z0, x1, z1;
+        _cellRange(b[0], b[1], b[2], b[3], x0, z0, x1, z1);
+
+        for (int z = z0; z <= z1; ++z)
+            for (int x = x0; x <= x1; ++x)
+                _cellTris[fill[x + z * _width]++] = i;
+    }
+}
+
+void CTriangleGrid::clear()
+{
+    _width = 0;
+    _height = 0;
+    _triBounds.clear();
+    _triBounds.shrink_to_fit();
+    _cellStart.clear();
+    _cellStart.shrink_to_fit();
+    _cellTris.clear();
+    _cellTris.shrink_to_fit();
+}
+
+int CTriangleGrid::query(const float* qmin, const float* qmax, std::vector<int>& trisOut) const
+{
+    trisOut.clear();
+
+    if (_cellTris.empty())
+        return 0;
+
+    int x0, z0, x1, z1;
+    _cellRange(qmin[0], qmin[2], qmax[0], qmax[2], x0, z0, x1, z1);
+
+    for (int z = z0; z <= z1; ++z)
+    {
+        for (int x = x0; x <= x1; ++x)
+        {
+            const int c = x + z * _width;
+            for (int j = _cellStart[c]; j < _cellStart[c + 1]; ++j)
+            {
+                const int i = _cellTris[j];
+                const float* b = &_triBounds[i * 4];
+
+                if (b[0] > qmax[0] || b[2] < qmin[0] ||
+                    b[1] > qmax[2] || b[3] < qmin[2])
+                    continue;
+
+                // A triangle spanning several cells is only reported from the
+                // cell that holds the lower corner of its overlap with the query.
+                int ox, oz, unusedX, unusedZ;
+                _cellRange(std::max(b[0], qmin[0]), std::max(b[1], qmin[2]), 0.0f, 0.0f, ox, oz, unusedX, unusedZ);
+                if (ox != x || oz != z)
+                    continue;
+
+                trisOut.push_back(i);
+            }
+        }
+    }
+
+    // Keep the input order so rasterization matches a full-soup pass
+    std::sort(trisOut.begin(), trisOut.end());
+    return (int)trisOut.size();
+}
+
+void CTriangleGrid::_cellRange(
+    const float minX, const float minZ,
+    const float maxX, const float maxZ,
+    int& x0, int& z0, int& x1, int& z1) const
+{
+    x0 = std::min(std::max((int)floorf((minX - _orig[0]) / _cellSize), 0), _width - 1);
+    z0 = std::min(std::max((int)floorf((minZ - _orig[1]) / _cellSize), 0), _height - 1);
+    x1 = std::min(std::max((int)floorf((maxX - _orig[0]) / _cellSize), 0), _width - 1);
+    z1 = std::min(std::max((int)floorf((maxZ - _orig[1]) / _cellSize), 0), _height - 1);
+}
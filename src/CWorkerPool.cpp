@@ -0,0 +1,82 @@
+#include "IrrRecastDetour/CWorkerPool.h"
+#include <algorithm>
+
+CWorkerPool::CWorkerPool(int threadCount)
+{
+    threadCount = std::max(threadCount, 1);
+    _threads.reserve(threadCount);
+    for (int i = 0; i < threadCount; ++i)
+        _threads.emplace_back(&CWorkerPool::_threadMain, this, i);
+}
+
+CWorkerPool::~CWorkerPool()
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+
+    for (std::thread& thread : _threads)
+        thread.join();
+}
+
+void CWorkerPool::dispatch(int count, std::function<void(int)> job)
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _job = std::move(job);
+        _jobCount = std::max(0, std::min(count, getThreadCount()));
+        _pending = _jobCount;
+        ++_jobId;
+    }
+    _wake.notify_all();
+}
+
+void CWorkerPool::wait()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this]() { return _pending == 0; });
+}
+
+void CWorkerPool::run(int count, const std::function<void(int)>& job)
+{
+    if (count <= 0)
+        return;
+
+    if (count > 1)
+        dispatch(count - 1, [&job](int index) { job(index + 1); });
+    job(0);
+    wait();
+}
+
+int CWorkerPool::resolveThreadCount(int requested)
+{
+    if (requested > 0)
+        return requested;
+    return std::max(1, (int)std::thread::hardware_concurrency());
+}
+
+void CWorkerPool::_threadMain(int index)
+{
+    unsigned int seenJob = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [&]() { return _stop || (_jobId != seenJob && index < _jobCount); });
+            if (_stop)
+                return;
+            seenJob = _jobId;
+        }
+
+        // _job is only replaced once every thread is done with it
+        _job(index);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--_pending == 0)
+            _done.notify_all();
+    }
+}
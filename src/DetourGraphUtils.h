@@ -0,0 +1,258 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <functional>
+#include <utility>
+#include <vector>
+#include "IrrRecastDetour/CNavQueryContext.h"
+#include "DetourCommon.h"
+
+// Internal helpers shared by the polygon graph searches of CNavQueryContext,
+// CFlowField and CTileClusterGraph
+
+/**
+ * @brief Gets the link from poly to toRef, or nullptr if Detour does not link them that way.
+ */
+inline const dtLink* findPolyLink(const dtMeshTile* tile, const dtPoly* poly, const dtPolyRef toRef)
+{
+    for (unsigned int i = poly->firstLink; i != DT_NULL_LINK; i = tile->links[i].next)
+    {
+        if (tile->links[i].ref == toRef)
+            return &tile->links[i];
+    }
+    return nullptr;
+}
+
+/**
+ * @class CPolySearch
+ * @brief Dijkstra expansion over navmesh polygons, with storage reused across searches.
+ *
+ * Nodes sit at portal midpoints, like those of dtNavMeshQuery::findPath().
+ * A forward search follows the links out of each polygon. A reverse search
+ * (from a goal) only enters a neighbour that links back into the polygon, so
+ * the Parent chain of every settled node leads an agent to the goal.
+ */
+class CPolySearch
+{
+public:
+    struct Node
+    {
+        dtPolyRef Ref = 0;
+        int Parent = -1;        // Node index, -1 for a start
+        float Cost = FLT_MAX;
+        float Pos[3];
+        bool Closed = false;
+        bool Target = false;    // Free for the caller, e.g. to mark goals
+    };
+
+    /**
+     * @brief Drops every node, keeping the storage.
+     */
+    void clear()
+    {
+        _nodes.clear();
+        _open.clear();
+
+        // Bumping the generation empties the index without touching it
+        if (++_generation == 0)
+        {
+            std::fill(_stamps.begin(), _stamps.end(), 0u);
+            _generation = 1;
+        }
+    }
+
+    /**
+     * @brief Gets the node of a polygon, adding it if new. Indices stay valid
+     * until clear(); references only until the next node is added.
+     */
+    int getNode(const dtPolyRef ref)
+    {
+        if ((_nodes.size() + 1) * 2 > _keys.size())
+            _growIndex();
+
+        size_t slot = _findSlot(ref);
+        if (_stamps[slot] == _generation)
+            return _values[slot];
+
+        _nodes.push_back(Node());
+        _nodes.back().Ref = ref;
+        _keys[slot] = ref;
+        _values[slot] = (int)_nodes.size() - 1;
+        _stamps[slot] = _generation;
+        return (int)_nodes.size() - 1;
+    }
+
+    /**
+     * @return The node of a polygon, or -1 if the search never reached it.
+     */
+    int findNode(const dtPolyRef ref) const
+    {
+        if (_keys.empty())
+            return -1;
+        const size_t slot = _findSlot(ref);
+        return _stamps[slot] == _generation ? _values[slot] : -1;
+    }
+
+    Node& operator[](int index) { return _nodes[index]; }
+    const Node& operator[](int index) const { return _nodes[index]; }
+
+    /**
+     * @brief Adds a polygon the search starts from, at cost 0.
+     */
+    void addStart(const dtPolyRef ref, const float* pos)
+    {
+        const int index = getNode(ref);
+        _nodes[index].Cost = 0.0f;
+        _nodes[index].Parent = -1;
+        dtVcopy(_nodes[index].Pos, pos);
+        _open.push_back(std::make_pair(0.0f, index));
+        std::push_heap(_open.begin(), _open.end(), MinHeap());
+    }
+
+    /**
+     * @brief Settles polygons in cost order until none are left.
+     * @param reverse Search towards the starts instead of away from them.
+     * @param maxCost Stops at this cost, 0 = no limit.
+     * @param accept bool(dtPolyRef, const dtMeshTile*, const dtPoly*): limits
+     * the polygons entered beyond the filter.
+     * @param settle bool(int node): called for every settled node; return false to stop.
+     */
+    template <class Accept, class Settle>
+    void run(const dtNavMesh* navMesh, const dtQueryFilter& filter, bool reverse, float maxCost, Accept accept, Settle settle)
+    {
+        while (!_open.empty())
+        {
+            std::pop_heap(_open.begin(), _open.end(), MinHeap());
+            const float cost = _open.back().first;
+            const int bestIndex = _open.back().second;
+            _open.pop_back();
+
+            // Stale heap entries of nodes that were relaxed again
+            if (_nodes[bestIndex].Closed || cost > _nodes[bestIndex].Cost)
+                continue;
+            if (maxCost > 0.0f && cost > maxCost)
+                break;
+
+            _nodes[bestIndex].Closed = true;
+            if (!settle(bestIndex))
+                break;
+
+            const dtPolyRef bestRef = _nodes[bestIndex].Ref;
+            const dtMeshTile* bestTile = nullptr;
+            const dtPoly* bestPoly = nullptr;
+            navMesh->getTileAndPolyByRefUnsafe(bestRef, &bestTile, &bestPoly);
+
+            const int parentIndex = _nodes[bestIndex].Parent;
+            const dtPolyRef parentRef = parentIndex >= 0 ? _nodes[parentIndex].Ref : 0;
+            const dtMeshTile* parentTile = nullptr;
+            const dtPoly* parentPoly = nullptr;
+            if (parentRef)
+                navMesh->getTileAndPolyByRefUnsafe(parentRef, &parentTile, &parentPoly);
+
+            for (unsigned int i = bestPoly->firstLink; i != DT_NULL_LINK; i = bestTile->links[i].next)
+            {
+                const dtLink& link = bestTile->links[i];
+                const dtPolyRef neighbourRef = link.ref;
+                if (!neighbourRef || neighbourRef == parentRef)
+                    continue;
+
+                const dtMeshTile* neighbourTile = nullptr;
+                const dtPoly* neighbourPoly = nullptr;
+                navMesh->getTileAndPolyByRefUnsafe(neighbourRef, &neighbourTile, &neighbourPoly);
+                if (!filter.passFilter(neighbourRef, neighbourTile, neighbourPoly) ||
+                    !accept(neighbourRef, neighbourTile, neighbourPoly))
+                {
+                    continue;
+                }
+
+                float neighbourPos[3];
+                float neighbourCost;
+                if (reverse)
+                {
+                    // Agents move from the neighbour into this polygon, so that link must exist
+                    const dtLink* back = findPolyLink(neighbourTile, neighbourPoly, bestRef);
+                    if (!back)
+                        continue;
+
+                    // The step from the portal to this node's position runs across this polygon
+                    CNavQueryContext::getPortalMidpoint(neighbourRef, neighbourTile, neighbourPoly, *back, bestTile, bestPoly, neighbourPos);
+                    neighbourCost = cost + filter.getCost(
+                        neighbourPos, _nodes[bestIndex].Pos,
+                        neighbourRef, neighbourTile, neighbourPoly,
+                        bestRef, bestTile, bestPoly,
+                        parentRef, parentTile, parentPoly
+                    );
+                }
+                else
+                {
+                    CNavQueryContext::getPortalMidpoint(bestRef, bestTile, bestPoly, link, neighbourTile, neighbourPoly, neighbourPos);
+                    neighbourCost = cost + filter.getCost(
+                        _nodes[bestIndex].Pos, neighbourPos,
+                        parentRef, parentTile, parentPoly,
+                        bestRef, bestTile, bestPoly,
+                        neighbourRef, neighbourTile, neighbourPoly
+                    );
+                }
+
+                // getNode() may grow the node array, so index it afresh
+                const int neighbourIndex = getNode(neighbourRef);
+                Node& neighbour = _nodes[neighbourIndex];
+                if (neighbour.Closed || neighbourCost >= neighbour.Cost)
+                    continue;
+
+                neighbour.Parent = bestIndex;
+                neighbour.Cost = neighbourCost;
+                dtVcopy(neighbour.Pos, neighbourPos);
+                _open.push_back(std::make_pair(neighbourCost, neighbourIndex));
+                std::push_heap(_open.begin(), _open.end(), MinHeap());
+            }
+        }
+    }
+
+private:
+    typedef std::greater<std::pair<float, int>> MinHeap;
+
+    std::vector<Node> _nodes;
+
+    // Open-addressing index from polygon to node. A slot is in use only if its
+    // stamp is the current generation, so clear() does not have to wipe it.
+    std::vector<dtPolyRef> _keys;
+    std::vector<int> _values;
+    std::vector<unsigned int> _stamps;
+    unsigned int _generation = 1;
+    // Min-heap of (cost, node index); stale entries are skipped when popped
+    std::vector<std::pair<float, int>> _open;
+
+    /**
+     * @brief Gets the slot of a polygon, or the free slot it would go into.
+     */
+    size_t _findSlot(const dtPolyRef ref) const
+    {
+        const size_t mask = _keys.size() - 1;
+        size_t slot = (size_t)(((unsigned long long)ref * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+        while (_stamps[slot] == _generation && _keys[slot] != ref)
+            slot = (slot + 1) & mask;
+        return slot;
+    }
+
+    /**
+     * @brief Doubles the index (a power of two, at most half full) and reinserts the nodes.
+     */
+    void _growIndex()
+    {
+        const size_t size = std::max<size_t>(_keys.size() * 2, 256);
+        _keys.assign(size, 0);
+        _values.assign(size, -1);
+        _stamps.assign(size, 0u);
+        _generation = 1;
+
+        for (size_t i = 0; i < _nodes.size(); ++i)
+        {
+            const size_t slot = _findSlot(_nodes[i].Ref);
+            _keys[slot] = _nodes[i].Ref;
+            _values[slot] = (int)i;
+            _stamps[slot] = _generation;
+        }
+    }
+};
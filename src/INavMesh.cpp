@@ -1,5 +1,26 @@
 #include "IrrRecastDetour/INavMesh.h"
+#include "IrrRecastDetour/CNavQueryContext.h"
+#include "IrrRecastDetour/CPathScheduler.h"
+#include "IrrRecastDetour/CFlowField.h"
+#include "IrrRecastDetour/CShardedCrowd.h"
+#include "IrrRecastDetour/CWorkerPool.h"
 #include <irrlicht.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include "DetourCommon.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
 
 // Use explicit namespaces from original file
 using irr::core::vector3df;
@@ -9,11 +30,102 @@ using irr::scene::ISceneNode;
 using namespace irr;
 using namespace scene;
 
+namespace
+{
+    // --- Navmesh file layout ---
+    // [NavMeshFileHeader][NavMeshFileTileHeader][tile data]...[NavMeshFileTileHeader][tile data]
+    // Tile data sizes from dtCreateNavMeshData are multiples of 4, so every
+    // tile blob starts 4-byte aligned within the file.
+    const int NAVMESH_FILE_MAGIC = 'I' << 24 | 'R' << 16 | 'N' << 8 | 'M';
+    const int NAVMESH_FILE_VERSION = 2;
+
+    struct NavMeshFileHeader
+    {
+        int magic;
+        int version;
+        int tileCount;
+        NavMeshParams buildParams;
+        dtNavMeshParams meshParams;
+        // Tile layout of a CTiledNavMesh build, all 0 for the other builders
+        int tileSize;
+        int tilesW;
+        int tilesH;
+        float buildBMin[3];
+        float buildBMax[3];
+    };
+
+    struct NavMeshFileTileHeader
+    {
+        dtTileRef tileRef;
+        int dataSize;
+    };
+
+    bool checkFileHeader(const NavMeshFileHeader& header, const char* path)
+    {
+        if (header.magic != NAVMESH_FILE_MAGIC)
+        {
+            printf("ERROR: INavMesh::load: '%s' is not a navmesh file.\n", path);
+            return false;
+        }
+        if (header.version != NAVMESH_FILE_VERSION)
+        {
+            printf("ERROR: INavMesh::load: '%s' has version %d, expected %d.\n", path, header.version, NAVMESH_FILE_VERSION);
+            return false;
+        }
+        if (header.tileCount < 0)
+        {
+            printf("ERROR: INavMesh::load: '%s' has an invalid tile count.\n", path);
+            return false;
+        }
+        return true;
+    }
+
+    // Grid is INavMesh::TileGrid, which is only reachable from its members
+    template <class Grid>
+    Grid getFileTileGrid(const NavMeshFileHeader& header)
+    {
+        Grid grid;
+        grid.TileSize = header.tileSize;
+        grid.TilesW = header.tilesW;
+        grid.TilesH = header.tilesH;
+        dtVcopy(grid.BMin, header.buildBMin);
+        dtVcopy(grid.BMax, header.buildBMax);
+        return grid;
+    }
+
+    bool initLoadMesh(std::unique_ptr<dtNavMesh, DetourNavMeshDeleter>& navMesh, const dtNavMeshParams& meshParams, const char* caller)
+    {
+        navMesh.reset(dtAllocNavMesh());
+        if (!navMesh || dtStatusFailed(navMesh->init(&meshParams)))
+        {
+            printf("ERROR: INavMesh::%s: Could not init navmesh.\n", caller);
+            return false;
+        }
+        return true;
+    }
+
+    // Moves a fully written file over the target in one step. Processes that
+    // mapped the old file keep its data; truncating it in place would fault them.
+    bool replaceFile(const char* from, const char* to)
+    {
+#ifdef _WIN32
+        return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        return std::rename(from, to) == 0;
+#endif
+    }
+
+    // Polygons of a flow field that are straightened per agent and frame
+    const int FLOW_LOOKAHEAD_POLYS = 16;
+}
+
 INavMesh::INavMesh(irr::scene::ISceneNode* parent, irr::scene::ISceneManager* mgr, irr::s32 id)
     : irr::scene::ISceneNode(parent, mgr, id),
     _defaultAgentRadius(0.2f), // Set some sane defaults
     _defaultAgentHeight(1.0f)
 {
+    _pathScheduler.reset(new CPathScheduler());
+
     // The base node itself does not render, so it can be invisible.
     // Children (like debug meshes) can be made visible by the subclass.
     setVisible(false);
@@ -21,6 +133,14 @@ INavMesh::INavMesh(irr::scene::ISceneNode* parent, irr::scene::ISceneManager* mg
 
 INavMesh::~INavMesh()
 {
+    // A background build still writes into _pendingBuilder; let it finish
+    if (_pendingBuild.valid())
+        _pendingBuild.wait();
+
+    // So does a threaded crowd step into the crowd
+    if (_crowdStepRunning)
+        _crowdWorker->wait();
+
     // Smart pointers handle all cleanup automatically
 }
 
@@ -34,6 +154,22 @@ void INavMesh::OnRegisterSceneNode()
 
 void INavMesh::OnAnimate(irr::u32 timeMs)
 {
+    // Sync point of the threaded crowd: wait for the step started last frame
+    // and apply the agent calls queued while it ran
+    _finishCrowdStep();
+
+    // Swap in a finished background build before stepping the crowd
+    if (_pendingBuild.valid())
+        applyPendingBuild();
+
+    // Calls queued by other threads go in before the crowd moves
+    _drainAgentCommands();
+
+    // Advance the time-sliced path requests within their budget
+    if (_navMesh && !_pathScheduler->hasQuery())
+        _pathScheduler->setQuery(createQueryContext());
+    _pathScheduler->update();
+
     if (!_crowd)
         return;
 
@@ -53,29 +189,319 @@ void INavMesh::OnAnimate(irr::u32 timeMs)
         return; // Skip if no time has passed
 
     // --- 2. Update the Crowd Simulation ---
-    // The second parameter (update_request) can usually be nullptr for simple updates
-    _crowd->update(deltaTime, nullptr);
+    if (_threadedCrowd)
+    {
+        // Show the step that finished at the sync point, then run the next
+        // one on the worker while this frame renders
+        if (_hasStepResult)
+        {
+            _frontStates = 1 - _frontStates;
+            _hasStepResult = false;
+        }
+        const std::vector<AgentState>& states = _agentStates[_frontStates];
+        _agents.syncPositions(states.data(), (int)states.size(), _stepAlpha);
+
+        _startCrowdStep(deltaTime);
+        return;
+    }
+
+    const float alpha = _advanceCrowd(deltaTime, _query.get(), nullptr);
 
     // --- 3. Update all Irrlicht nodes based on their agent's new position ---
-    for (auto const& [id, node] : _agentNodeMap)
+    // Only nodes whose agent moved are written, between the last two
+    // simulation states with a fixed step
+    _agents.syncPositions(_crowd.get(), alpha);
+}
+
+float INavMesh::_advanceCrowd(float deltaTime, CNavQueryContext* query, std::vector<AgentState>* states)
+{
+    if (_fixedStep <= 0.0f)
     {
-        const dtCrowdAgent* agent = _crowd->getAgent(id);
-        if (!agent || !agent->active)
-            continue;
+        _stepCrowd(deltaTime, query);
+        return 1.0f;
+    }
+
+    // Fixed steps: the crowd runs at the simulation rate whatever the frame rate
+    _stepAccumulator += deltaTime;
+    int steps = 0;
+    while (_stepAccumulator >= _fixedStep && steps < _maxSubSteps)
+    {
+        if (states)
+        {
+            for (int id : _stepAgentIds)
+            {
+                const dtCrowdAgent* agent = _crowd->getAgent(id);
+                AgentState& state = (*states)[id];
+                state.HasPrevious = agent && agent->active;
+                if (state.HasPrevious)
+                    dtVcopy(state.PrevPos, agent->npos);
+            }
+        }
+        else
+        {
+            _agents.savePreviousPositions(_crowd.get());
+        }
+
+        _stepCrowd(_fixedStep, query);
+        _stepAccumulator -= _fixedStep;
+        ++steps;
+    }
+
+    // After a long stall, drop the steps beyond the cap instead of catching up
+    if (_stepAccumulator >= _fixedStep)
+        _stepAccumulator = fmodf(_stepAccumulator, _fixedStep);
+
+    return _stepAccumulator / _fixedStep;
+}
+
+void INavMesh::_stepCrowd(float deltaTime, CNavQueryContext* query)
+{
+    // Agents on a flow field get their desired velocity from it
+    if (!_flowAgents.empty() && query)
+        _steerFlowAgents(*query);
+
+    // The second parameter (update_request) can usually be nullptr for simple updates
+    _crowd->update(deltaTime);
+}
+
+// --- Threaded Crowd ---
+
+void INavMesh::setThreadedCrowd(bool enabled)
+{
+    _finishCrowdStep();
+    _threadedCrowd = enabled;
+    _hasStepResult = false;
+
+    // States left from an earlier threaded session are stale
+    _agentStates[0].clear();
+    _agentStates[1].clear();
+    _removedStateIds.clear();
+}
+
+void INavMesh::_startCrowdStep(float deltaTime)
+{
+    // The worker steers flow agents with its own context, so _query stays free
+    if (!_crowdQuery)
+        _crowdQuery = createQueryContext();
+
+    for (std::vector<AgentState>& states : _agentStates)
+    {
+        if ((int)states.size() != _crowd->getAgentCount())
+            states.assign(_crowd->getAgentCount(), AgentState());
+
+        // The worker does not visit removed agents, so their states are cleared here
+        for (int id : _removedStateIds)
+        {
+            if (id < (int)states.size())
+                states[id] = AgentState();
+        }
+    }
+    _removedStateIds.clear();
+
+    // The table changes on the main thread during the step, so the worker gets a copy
+    _stepAgentIds.resize(_agents.size());
+    for (int i = 0; i < _agents.size(); ++i)
+        _stepAgentIds[i] = _agents.getAgentId(i);
+
+    if (!_crowdWorker)
+        _crowdWorker.reset(new CWorkerPool(1));
+    _crowdStepRunning = true;
+    _crowdWorker->dispatch(1, [this, deltaTime](int) { _runCrowdStep(deltaTime); });
+}
+
+void INavMesh::_runCrowdStep(float deltaTime)
+{
+    // Runs on the worker: only the crowd, flow state and back buffer are touched
+    const std::vector<AgentState>& front = _agentStates[_frontStates];
+    std::vector<AgentState>& back = _agentStates[1 - _frontStates];
+
+    // Without a fixed step this frame, the previous state stays the published one
+    for (int id : _stepAgentIds)
+    {
+        back[id].HasPrevious = front[id].HasPrevious;
+        dtVcopy(back[id].PrevPos, front[id].PrevPos);
+    }
+
+    _stepAlpha = _advanceCrowd(deltaTime, _crowdQuery.get(), &back);
+
+    for (int id : _stepAgentIds)
+        _captureAgentState(id, back[id]);
+}
+
+void INavMesh::_finishCrowdStep()
+{
+    if (!_crowdStepRunning)
+        return;
+
+    _crowdWorker->wait();
+    _crowdStepRunning = false;
+    _hasStepResult = true;
+
+    // Apply the calls made during the step, in call order. The step is over,
+    // so each call now runs directly.
+    std::vector<AgentCommand> commands;
+    commands.swap(_crowdCommands);
+    for (AgentCommand& command : commands)
+        _applyAgentCommand(command, true);
+
+    // Keep the capacity for the next step
+    commands.clear();
+    if (_crowdCommands.empty())
+        _crowdCommands.swap(commands);
+}
+
+void INavMesh::_applyAgentCommand(AgentCommand& command, bool tableUpdated)
+{
+    switch (command.Kind)
+    {
+    case AgentCommand::ADD:
+    {
+        if (!tableUpdated)
+        {
+            const int id = addAgent(command.Node, command.Params);
+            if (command.OnAdded)
+                command.OnAdded(id);
+            break;
+        }
+
+        // The agent table already holds the id reserved during a step
+        const float pos[3] = { command.Pos.X, command.Pos.Y, command.Pos.Z };
+        const int id = _crowd ? _crowd->addAgent(pos, &command.Params) : -1;
+        if (id != command.AgentId)
+        {
+            printf("ERROR: INavMesh::addAgent: Queued agent %d could not be added.\n", command.AgentId);
+            if (id >= 0)
+                _crowd->removeAgent(id);
+            _agents.remove(command.AgentId);
+        }
+        break;
+    }
+    case AgentCommand::REMOVE:
+        if (!tableUpdated)
+        {
+            RemoveAgent(command.AgentId);
+        }
+        else if (_crowd)
+        {
+            // A later add may already have reserved the id again, so only the crowd is touched
+            _crowd->removeAgent(command.AgentId);
+            _flowAgents.erase(command.AgentId);
+        }
+        break;
+    case AgentCommand::MOVE_TARGET:
+        setAgentTarget(command.AgentId, command.Pos);
+        break;
+    case AgentCommand::FLOW_TARGET:
+        setAgentFlowTarget(command.AgentId, command.Pos);
+        break;
+    }
+}
+
+// --- Agent Commands From Other Threads ---
+
+bool INavMesh::queueAddAgent(irr::scene::ISceneNode* node, const dtCrowdAgentParams& params, std::function<void(int)> onAdded)
+{
+    AgentCommand command;
+    command.Kind = AgentCommand::ADD;
+    command.Node = node;
+    command.Params = params;
+    command.OnAdded = std::move(onAdded);
+    return _commandQueue.push(std::move(command));
+}
+
+bool INavMesh::queueRemoveAgent(int agentId)
+{
+    AgentCommand command;
+    command.Kind = AgentCommand::REMOVE;
+    command.AgentId = agentId;
+    return _commandQueue.push(std::move(command));
+}
+
+bool INavMesh::queueAgentTarget(int agentId, const irr::core::vector3df& targetPos)
+{
+    AgentCommand command;
+    command.Kind = AgentCommand::MOVE_TARGET;
+    command.AgentId = agentId;
+    command.Pos = targetPos;
+    return _commandQueue.push(std::move(command));
+}
+
+bool INavMesh::queueAgentFlowTarget(int agentId, const irr::core::vector3df& goalPos)
+{
+    AgentCommand command;
+    command.Kind = AgentCommand::FLOW_TARGET;
+    command.AgentId = agentId;
+    command.Pos = goalPos;
+    return _commandQueue.push(std::move(command));
+}
+
+void INavMesh::_drainAgentCommands()
+{
+    // At most one lap, so producers that keep pushing cannot stall the frame
+    AgentCommand command;
+    for (size_t i = 0; i < _commandQueue.getCapacity() && _commandQueue.pop(command); ++i)
+        _applyAgentCommand(command, false);
+}
+
+void INavMesh::_captureAgentState(int agentId, AgentState& state)
+{
+    const dtCrowdAgent* agent = _crowd->getAgent(agentId);
+    state.Active = agent && agent->active;
+    if (!state.Active)
+    {
+        state.HasPrevious = false;
+        return;
+    }
+
+    dtVcopy(state.Pos, agent->npos);
+    dtVcopy(state.Vel, agent->nvel);
+    state.CornerCount = agent->ncorners;
+    memcpy(state.Corners, agent->cornerVerts, sizeof(float) * 3 * agent->ncorners);
+
+    // Flow field agents move in velocity mode towards their goal
+    auto flow = _flowAgents.find(agentId);
+    if (flow != _flowAgents.end())
+    {
+        state.HasTarget = true;
+        state.Target[0] = flow->second.GoalPos.X;
+        state.Target[1] = flow->second.GoalPos.Y;
+        state.Target[2] = flow->second.GoalPos.Z;
+        state.Reached = flow->second.Arrived;
+        return;
+    }
 
-        // Get agent's position (at their feet)
-        const float* pos = agent->npos;
+    state.HasTarget = agent->targetState != DT_CROWDAGENT_TARGET_NONE &&
+        agent->targetState != DT_CROWDAGENT_TARGET_FAILED;
+    dtVcopy(state.Target, agent->targetPos);
 
-        // Update the scene node's position
-        // This offset (pos[1] + height/2.0f) assumes the Irrlicht node's origin 
-        // is at its center. This is a reasonable guess, but depends on your 
-        // model/node setup.
-        node->setPosition(irr::core::vector3df(
-            pos[0], 
-            pos[1] + (agent->params.height / 2.0f), 
-            pos[2]
-        ));
+    // Agent has reached destination if target state is DT_CROWDAGENT_TARGET_VALID
+    // and ncorners is 0 (no more path corners)
+    state.Reached = agent->targetState == DT_CROWDAGENT_TARGET_VALID && agent->ncorners == 0;
+}
+
+bool INavMesh::_getAgentState(int agentId, AgentState& state)
+{
+    if (!_threadedCrowd)
+    {
+        _captureAgentState(agentId, state);
+        return state.Active;
     }
+
+    // The worker may be stepping the crowd; read the last published step
+    const std::vector<AgentState>& states = _agentStates[_frontStates];
+    if (agentId >= (int)states.size())
+        return false;
+
+    state = states[agentId];
+    return state.Active;
+}
+
+void INavMesh::setSimulationRate(float hz, int maxSubSteps)
+{
+    _finishCrowdStep();
+    _fixedStep = hz > 0.0f ? 1.0f / hz : 0.0f;
+    _maxSubSteps = maxSubSteps < 1 ? 1 : maxSubSteps;
+    _stepAccumulator = 0.0f;
 }
 
 void INavMesh::render()
@@ -152,10 +578,34 @@ int INavMesh::addAgent(irr::scene::ISceneNode* node, const dtCrowdAgentParams& u
     // So, we offset the Y position down by half the agent's height.
     float irrPos[3] = { pos.X, pos.Y - (finalParams.height / 2.0f), pos.Z };
 
+    if (_crowdStepRunning)
+    {
+        // The crowd hands out the lowest free index, so the id is known before
+        // the queued add is applied
+        const int id = _agents.getFirstFreeId();
+        if (id >= _crowd->getAgentCount())
+        {
+            printf("ERROR: AbstractNavMesh::addAgent: Crowd is full.\n");
+            return -1;
+        }
+
+        _agents.add(id, node, finalParams.height / 2.0f);
+
+        AgentCommand command;
+        command.Kind = AgentCommand::ADD;
+        command.AgentId = id;
+        command.Pos.set(irrPos[0], irrPos[1], irrPos[2]);
+        command.Params = finalParams;
+        _crowdCommands.push_back(command);
+        return id;
+    }
+
     int id = _crowd->addAgent(irrPos, &finalParams);
     if (id != -1)
     {
-        _agentNodeMap[id] = node;
+        // This offset (height/2) assumes the Irrlicht node's origin is at its
+        // center. This is a reasonable guess, but depends on your model/node setup.
+        _agents.add(id, node, finalParams.height / 2.0f);
     }
     else
     {
@@ -166,35 +616,201 @@ int INavMesh::addAgent(irr::scene::ISceneNode* node, const dtCrowdAgentParams& u
 
 void INavMesh::setAgentTarget(int agentId, irr::core::vector3df targetPos)
 {
-    if (!_crowd || !_navQuery || agentId == -1)
+    if (!_crowd || !_query || agentId == -1)
     {
         if (!_crowd) printf("ERROR: setAgentTarget: No crowd.\n");
-        if (!_navQuery) printf("ERROR: setAgentTarget: No navQuery.\n");
+        if (!_query) printf("ERROR: setAgentTarget: No navQuery.\n");
+        return;
+    }
+
+    if (_crowdStepRunning)
+    {
+        AgentCommand command;
+        command.Kind = AgentCommand::MOVE_TARGET;
+        command.AgentId = agentId;
+        command.Pos = targetPos;
+        _crowdCommands.push_back(command);
+        return;
+    }
+
+    // Find the nearest walkable polygon (GROUND, ROAD, GRASS, DOOR) to the target position
+    float nearestPt[3];
+    dtPolyRef targetRef = _query->findNearestPoly(targetPos, nearestPt);
+    if (!targetRef)
+    {
+        printf("WARNING: AbstractNavMesh::setAgentTarget: Could not find poly for target at (%f, %f, %f).\n", targetPos.X, targetPos.Y, targetPos.Z);
+        return;
+    }
+
+    // A target on another island would only make the crowd search its whole island
+    const dtCrowdAgent* agent = _crowd->getAgent(agentId);
+    const bool reachable = !agent || !agent->active || _query->isReachable(agent->corridor.getFirstPoly(), targetRef);
+
+    // The agent plans its own path again
+    _flowAgents.erase(agentId);
+
+    if (!reachable)
+    {
+        printf("WARNING: INavMesh::setAgentTarget: Target at (%f, %f, %f) is not reachable from agent %d, stopping it.\n", targetPos.X, targetPos.Y, targetPos.Z, agentId);
+        _crowd->resetMoveTarget(agentId);
         return;
     }
 
+    // Request the agent to move to the new target
+    _crowd->requestMoveTarget(agentId, targetRef, nearestPt);
+}
+
+bool INavMesh::setAgentFlowTarget(int agentId, irr::core::vector3df goalPos)
+{
+    if (!_crowd || !_query)
+    {
+        printf("ERROR: INavMesh::setAgentFlowTarget: Crowd or navQuery is null.\n");
+        return false;
+    }
+
+    if (!_agents.contains(agentId))
+    {
+        printf("ERROR: INavMesh::setAgentFlowTarget: Invalid agent ID: %d\n", agentId);
+        return false;
+    }
+
+    if (_crowdStepRunning)
+    {
+        AgentCommand command;
+        command.Kind = AgentCommand::FLOW_TARGET;
+        command.AgentId = agentId;
+        command.Pos = goalPos;
+        _crowdCommands.push_back(command);
+        return true;
+    }
 
-    // Find the nearest polygon to the target position
-    float pos[3] = { targetPos.X, targetPos.Y, targetPos.Z };
-    float ext[3] = { 2.0f, 4.0f, 2.0f }; // Search extent
-    dtPolyRef targetRef;
     float nearestPt[3];
+    const dtPolyRef goalRef = _query->findNearestPoly(goalPos, nearestPt);
+    if (!goalRef)
+    {
+        printf("WARNING: INavMesh::setAgentFlowTarget: Could not find poly for target at (%f, %f, %f).\n", goalPos.X, goalPos.Y, goalPos.Z);
+        return false;
+    }
 
-    // Setup filter - allow walking on GROUND, ROAD, GRASS, and through DOORS
-    dtQueryFilter filter;
-    filter.setIncludeFlags((unsigned short)PolyFlags::WALK | (unsigned short)PolyFlags::DOOR);
-    filter.setExcludeFlags(0);
+    FlowAgent& flow = _flowAgents[agentId];
+    flow.GoalRef = goalRef;
+    flow.GoalPos.set(nearestPt[0], nearestPt[1], nearestPt[2]);
+    flow.Arrived = false;
 
-    _navQuery->findNearestPoly(pos, ext, &filter, &targetRef, nearestPt);
+    // The field replaces the crowd's own path request
+    _crowd->resetMoveTarget(agentId);
+
+    // Build the field now rather than in the next OnAnimate()
+    return _getFlowField(*_query, goalRef, flow.GoalPos) != nullptr;
+}
 
-    if (targetRef)
+const CFlowField* INavMesh::getFlowField(const irr::core::vector3df& goalPos)
+{
+    if (!_query)
     {
-        // Request the agent to move to the new target
-        _crowd->requestMoveTarget(agentId, targetRef, nearestPt);
+        printf("ERROR: INavMesh::getFlowField: NavQuery or NavMesh is null.\n");
+        return nullptr;
     }
-    else
+
+    // The worker adds fields while it steers
+    _finishCrowdStep();
+
+    float nearestPt[3];
+    const dtPolyRef goalRef = _query->findNearestPoly(goalPos, nearestPt);
+    if (!goalRef)
+        return nullptr;
+
+    return _getFlowField(*_query, goalRef, irr::core::vector3df(nearestPt[0], nearestPt[1], nearestPt[2]));
+}
+
+void INavMesh::clearFlowFields()
+{
+    _finishCrowdStep();
+    _flowFields.clear();
+}
+
+CFlowField* INavMesh::_getFlowField(CNavQueryContext& query, dtPolyRef goalRef, const irr::core::vector3df& goalPos)
+{
+    auto it = _flowFields.find(goalRef);
+    if (it != _flowFields.end())
+        return it->second.get();
+
+    std::unique_ptr<CFlowField> field(new CFlowField());
+    if (!field->build(query, goalPos))
+        return nullptr;
+
+    CFlowField* result = field.get();
+    _flowFields[goalRef] = std::move(field);
+    return result;
+}
+
+void INavMesh::_steerFlowAgents(CNavQueryContext& query)
+{
+    dtNavMeshQuery* navQuery = query.getQuery();
+    if (!navQuery)
+        return;
+
+    _flowCorridor.resize(FLOW_LOOKAHEAD_POLYS);
+
+    for (auto& [id, flow] : _flowAgents)
     {
-        printf("WARNING: AbstractNavMesh::setAgentTarget: Could not find poly for target at (%f, %f, %f).\n", pos[0], pos[1], pos[2]);
+        const dtCrowdAgent* agent = _crowd->getAgent(id);
+        if (!agent || !agent->active || flow.Arrived)
+            continue;
+
+        float vel[3] = { 0.0f, 0.0f, 0.0f };
+        const float goal[3] = { flow.GoalPos.X, flow.GoalPos.Y, flow.GoalPos.Z };
+
+        // Tile changes drop the fields, and possibly the goal polygon
+        if (!flow.GoalRef)
+            flow.GoalRef = query.findNearestPoly(flow.GoalPos);
+
+        const CFlowField* field = flow.GoalRef ? _getFlowField(query, flow.GoalRef, flow.GoalPos) : nullptr;
+        const int polyCount = field ? field->getCorridor(agent->corridor.getFirstPoly(), _flowCorridor.data(), FLOW_LOOKAHEAD_POLYS) : 0;
+
+        if (polyCount > 0)
+        {
+            const bool reachesGoal = _flowCorridor[polyCount - 1] == flow.GoalRef;
+            const float goalDist = dtVdist2D(agent->npos, goal);
+
+            if (reachesGoal && goalDist <= agent->params.radius)
+            {
+                flow.Arrived = true;
+            }
+            else
+            {
+                // Straighten the next few steps; the first corner is where to head
+                float endPos[3];
+                dtVcopy(endPos, goal);
+                if (!reachesGoal)
+                    navQuery->closestPointOnPoly(_flowCorridor[polyCount - 1], goal, endPos, nullptr);
+
+                float corners[2 * 3];
+                unsigned char cornerFlags[2];
+                dtPolyRef cornerPolys[2];
+                int cornerCount = 0;
+                navQuery->findStraightPath(agent->npos, endPos, _flowCorridor.data(), polyCount, corners, cornerFlags, cornerPolys, &cornerCount, 2);
+
+                if (cornerCount >= 2)
+                {
+                    float dir[3];
+                    dtVsub(dir, &corners[3], agent->npos);
+                    dir[1] = 0.0f;
+                    const float len = dtVlen(dir);
+
+                    if (len > 0.0001f)
+                    {
+                        // Slow down over the last two radii, like a dtCrowd move target
+                        float speed = agent->params.maxSpeed;
+                        if (reachesGoal)
+                            speed *= std::min(1.0f, goalDist / (agent->params.radius * 2.0f));
+                        dtVscale(vel, dir, speed / len);
+                    }
+                }
+            }
+        }
+
+        _crowd->requestMoveVelocity(id, vel);
     }
 }
 
@@ -211,24 +827,23 @@ void INavMesh::renderAgentPaths(irr::video::IVideoDriver* driver)
     driver->setTransform(irr::video::ETS_WORLD, matrix4());
 
     // Iterate over all active agents
+    AgentState state;
     for (int i = 0; i < _crowd->getAgentCount(); ++i)
     {
-        const dtCrowdAgent* agent = _crowd->getAgent(i);
-
         // Skip if agent isn't active or has no path (no corners)
-        if (!agent || !agent->active || agent->ncorners == 0)
+        if (!_getAgentState(i, state) || state.CornerCount == 0)
             continue;
 
         // The path starts at the agent's current position.
-        const float* p = agent->npos;
+        const float* p = state.Pos;
         vector3df startPoint(p[0], p[1] + 0.5f, p[2]); // Add a small Y-offset for visibility
 
         // Get the list of waypoints
-        const float* pathPoints = agent->cornerVerts;
+        const float* pathPoints = state.Corners;
 
         // Iterate through all corners
         // The path is: agent->npos -> corner[0] -> corner[1] -> ...
-        for (int j = 0; j < agent->ncorners; ++j)
+        for (int j = 0; j < state.CornerCount; ++j)
         {
             // Get the current corner as the 'end' point for this segment
             vector3df endPoint(
@@ -249,224 +864,262 @@ void INavMesh::renderAgentPaths(irr::video::IVideoDriver* driver)
 irr::core::vector3df INavMesh::getClosestPointOnNavmesh(const irr::core::vector3df& pos)
 {
     // If navmesh query isn't ready, return original position
-    if (!_navQuery || !_navMesh)
+    if (!_query)
     {
         return pos;
     }
 
-    // Convert Irrlicht position to Detour format (float array)
-    float queryPos[3] = { pos.X, pos.Y, pos.Z };
-
-    // Search extents - how far to search for nearest polygon
-    float extents[3] = { 2.0f, 4.0f, 2.0f }; // X, Y, Z search radius
-
-    // Query filter - which polygon types we can walk on
-    dtQueryFilter filter;
-    filter.setIncludeFlags((unsigned short)PolyFlags::WALK | (unsigned short)PolyFlags::DOOR);
-    filter.setExcludeFlags(0);
-
-    // Output variables
-    dtPolyRef nearestPoly = 0;
-    float nearestPoint[3] = { 0, 0, 0 };
-
-    // Find the nearest polygon and point on the navmesh
-    dtStatus status = _navQuery->findNearestPoly(
-        queryPos,
-        extents,
-        &filter,
-        &nearestPoly,
-        nearestPoint
-    );
-
-    // If successful and a polygon was found, return the clamped point
-    if (dtStatusSucceed(status) && nearestPoly != 0)
-    {
-        return irr::core::vector3df(
-            nearestPoint[0],
-            nearestPoint[1],
-            nearestPoint[2]
-        );
-    }
-
-    // If query failed, return original position
-    return pos;
+    return _query->getClosestPointOnNavmesh(pos);
 }
 
 std::vector<irr::core::vector3df> irr::scene::INavMesh::GetPath(const irr::core::vector3df& startPos, const irr::core::vector3df& endPos)
 {
-    std::vector<irr::core::vector3df> path;
-
-    if (!_navQuery || !_navMesh)
+    if (!_query)
     {
         printf("ERROR: INavMesh::getPath: NavQuery or NavMesh is null.\n");
-        return path;
+        return std::vector<irr::core::vector3df>();
     }
 
-    // Convert positions to Detour format
-    float start[3] = { startPos.X, startPos.Y, startPos.Z };
-    float end[3] = { endPos.X, endPos.Y, endPos.Z };
-
-    // Search extents for finding nearest polygons
-    float extents[3] = { 2.0f, 4.0f, 2.0f };
+    return _query->GetPath(startPos, endPos);
+}
 
-    // Query filter - which polygon types we can walk on
-    dtQueryFilter filter;
-    filter.setIncludeFlags((unsigned short)PolyFlags::WALK | (unsigned short)PolyFlags::DOOR);
-    filter.setExcludeFlags(0);
+PathStatus irr::scene::INavMesh::GetPath(
+    const irr::core::vector3df& startPos,
+    const irr::core::vector3df& endPos,
+    PathResult& result)
+{
+    if (!_query)
+    {
+        result.Status = PathStatus::NO_NAVMESH;
+        result.Waypoints.clear();
+        result.Flags.clear();
+        result.Polys.clear();
+        result.Distance = -1.0f;
+        return result.Status;
+    }
 
-    // Find nearest polygons for start and end positions
-    dtPolyRef startRef = 0;
-    dtPolyRef endRef = 0;
-    float startNearest[3];
-    float endNearest[3];
+    return _query->findPath(startPos, endPos, result);
+}
 
-    dtStatus status = _navQuery->findNearestPoly(start, extents, &filter, &startRef, startNearest);
-    if (dtStatusFailed(status) || startRef == 0)
+int irr::scene::INavMesh::GetPath(
+    const irr::core::vector3df& startPos,
+    const irr::core::vector3df& endPos,
+    irr::core::vector3df* waypoints, int maxWaypoints,
+    float* distance,
+    unsigned char* flags,
+    dtPolyRef* polys)
+{
+    if (!_query)
     {
-        printf("ERROR: INavMesh::getPath: Could not find start polygon.\n");
-        return path;
+        if (distance)
+            *distance = -1.0f;
+        return -1;
     }
 
-    status = _navQuery->findNearestPoly(end, extents, &filter, &endRef, endNearest);
-    if (dtStatusFailed(status) || endRef == 0)
+    return _query->GetPath(startPos, endPos, waypoints, maxWaypoints, distance, flags, polys);
+}
+
+float irr::scene::INavMesh::GetPathDistance(const irr::core::vector3df& startPos, const irr::core::vector3df& endPos)
+{
+    if (!_query)
     {
-        printf("ERROR: INavMesh::getPath: Could not find end polygon.\n");
-        return path;
+        printf("ERROR: INavMesh::getPathDistance: NavQuery or NavMesh is null.\n");
+        return -1.0f;
     }
 
-    // Find the path (as a series of polygon references)
-    const int MAX_POLYS = 256;
-    dtPolyRef polys[MAX_POLYS];
-    int polyCount = 0;
+    return _query->GetPathDistance(startPos, endPos);
+}
 
-    status = _navQuery->findPath(startRef, endRef, startNearest, endNearest, &filter, polys, &polyCount, MAX_POLYS);
-    if (dtStatusFailed(status) || polyCount == 0)
+bool irr::scene::INavMesh::IsReachable(const irr::core::vector3df& startPos, const irr::core::vector3df& endPos)
+{
+    if (!_query)
     {
-        printf("ERROR: INavMesh::getPath: Could not find path.\n");
-        return path;
+        printf("ERROR: INavMesh::IsReachable: NavQuery or NavMesh is null.\n");
+        return false;
     }
 
-    // Convert polygon path to actual waypoints using findStraightPath
-    const int MAX_STRAIGHT_PATH = 256;
-    float straightPath[MAX_STRAIGHT_PATH * 3];
-    unsigned char straightPathFlags[MAX_STRAIGHT_PATH];
-    dtPolyRef straightPathPolys[MAX_STRAIGHT_PATH];
-    int straightPathCount = 0;
+    const dtPolyRef startRef = _query->findNearestPoly(startPos);
+    const dtPolyRef endRef = _query->findNearestPoly(endPos);
+    return startRef && endRef && _query->isReachable(startRef, endRef);
+}
 
-    status = _navQuery->findStraightPath(
-        startNearest, endNearest,
-        polys, polyCount,
-        straightPath, straightPathFlags, straightPathPolys,
-        &straightPathCount, MAX_STRAIGHT_PATH,
-        DT_STRAIGHTPATH_AREA_CROSSINGS
-    );
+void irr::scene::INavMesh::setMinIslandSize(int polys)
+{
+    _finishCrowdStep();
+    _minIslandSize = polys;
 
-    if (dtStatusFailed(status) || straightPathCount == 0)
-    {
-        printf("ERROR: INavMesh::getPath: Could not create straight path.\n");
-        return path;
-    }
+    // Disabling polygons changes the navmesh like a tile rebuild does
+    if (_navMesh)
+        _onTilesChanged();
+}
 
-    // Convert straight path to Irrlicht vector format
-    path.reserve(straightPathCount);
-    for (int i = 0; i < straightPathCount; ++i)
+int irr::scene::INavMesh::GetPathDistances(
+    const irr::core::vector3df& startPos,
+    const irr::core::vector3df* targets, int count,
+    float* distances,
+    float maxCost)
+{
+    if (!_query)
     {
-        path.push_back(irr::core::vector3df(
-            straightPath[i * 3],
-            straightPath[i * 3 + 1],
-            straightPath[i * 3 + 2]
-        ));
+        printf("ERROR: INavMesh::GetPathDistances: NavQuery or NavMesh is null.\n");
+        for (int i = 0; i < count; ++i)
+            distances[i] = -1.0f;
+        return -1;
     }
 
-    return path;
+    const int reached = _query->GetPathDistances(startPos, targets, count, distances, maxCost);
+    if (reached < 0)
+        printf("ERROR: INavMesh::GetPathDistances: Could not find start polygon.\n");
+    return reached;
 }
 
-float irr::scene::INavMesh::GetPathDistance(const irr::core::vector3df& startPos, const irr::core::vector3df& endPos)
+unsigned int irr::scene::INavMesh::requestPath(
+    const irr::core::vector3df& startPos,
+    const irr::core::vector3df& endPos,
+    std::function<void(unsigned int requestId, const PathResult& result)> callback)
 {
-    if (!_navQuery || !_navMesh)
+    if (!_navMesh)
     {
-        printf("ERROR: INavMesh::getPathDistance: NavQuery or NavMesh is null.\n");
-        return -1.0f;
+        printf("ERROR: INavMesh::requestPath: NavMesh is null.\n");
+        return 0;
     }
 
-    // Convert positions to Detour format
-    float start[3] = { startPos.X, startPos.Y, startPos.Z };
-    float end[3] = { endPos.X, endPos.Y, endPos.Z };
-
-    // Search extents for finding nearest polygons
-    float extents[3] = { 2.0f, 4.0f, 2.0f };
+    return _pathScheduler->request(startPos, endPos, std::move(callback));
+}
 
-    // Query filter - which polygon types we can walk on
-    dtQueryFilter filter;
-    filter.setIncludeFlags((unsigned short)PolyFlags::WALK | (unsigned short)PolyFlags::DOOR);
-    filter.setExcludeFlags(0);
+bool irr::scene::INavMesh::pollPath(unsigned int requestId, PathResult& result)
+{
+    return _pathScheduler->poll(requestId, result);
+}
+
+void irr::scene::INavMesh::cancelPath(unsigned int requestId)
+{
+    _pathScheduler->cancel(requestId);
+}
 
-    // Find nearest polygons for start and end positions
-    dtPolyRef startRef = 0;
-    dtPolyRef endRef = 0;
-    float startNearest[3];
-    float endNearest[3];
+void irr::scene::INavMesh::setPathBudget(int maxIterations, float maxMicroseconds)
+{
+    _pathScheduler->setBudget(maxIterations, maxMicroseconds);
+}
 
-    dtStatus status = _navQuery->findNearestPoly(start, extents, &filter, &startRef, startNearest);
-    if (dtStatusFailed(status) || startRef == 0)
+std::unique_ptr<CNavQueryContext> irr::scene::INavMesh::createQueryContext(int maxNodes) const
+{
+    if (!_navMesh)
     {
-        printf("ERROR: INavMesh::getPathDistance: Could not find start polygon.\n");
-        return -1.0f;
+        printf("ERROR: INavMesh::createQueryContext: NavMesh is null.\n");
+        return nullptr;
     }
 
-    status = _navQuery->findNearestPoly(end, extents, &filter, &endRef, endNearest);
-    if (dtStatusFailed(status) || endRef == 0)
+    std::unique_ptr<CNavQueryContext> context(new CNavQueryContext(_navMesh.get(), maxNodes));
+    if (!context->isValid())
+        return nullptr;
+    context->setPathCache(&_pathCache);
+    context->setIslands(&_islands);
+    return context;
+}
+
+void irr::scene::INavMesh::_onTilesChanged()
+{
+    // A changed tile can open or close routes anywhere, so every corridor goes
+    _pathCache.clear();
+    _pathScheduler->restart();
+    _updateIslands();
+
+    // Fields are rebuilt by the next OnAnimate(); goal polygons are snapped again
+    _flowFields.clear();
+    for (auto& [id, flow] : _flowAgents)
+        flow.GoalRef = 0;
+}
+
+void irr::scene::INavMesh::_updateIslands()
+{
+    if (!_navMesh || !_query)
     {
-        printf("ERROR: INavMesh::getPathDistance: Could not find end polygon.\n");
-        return -1.0f;
+        _islands.clear();
+        return;
     }
 
-    // Find the path (as a series of polygon references)
-    const int MAX_POLYS = 256;
-    dtPolyRef polys[MAX_POLYS];
-    int polyCount = 0;
+    // A tile change may have joined a small island to a larger one, and a
+    // disabled polygon would never pass the filter to be relabeled
+    _islands.restoreDisabled(_navMesh.get());
+    _islands.build(_navMesh.get(), _query->getFilter());
+    if (_minIslandSize > 1)
+        _islands.disableSmallIslands(_navMesh.get(), _minIslandSize, (unsigned short)PolyFlags::DISABLED);
+}
+
+int irr::scene::INavMesh::GetPaths(const PathRequest* requests, PathResult* results, int count)
+{
+    if (count <= 0)
+        return 0;
 
-    status = _navQuery->findPath(startRef, endRef, startNearest, endNearest, &filter, polys, &polyCount, MAX_POLYS);
-    if (dtStatusFailed(status) || polyCount == 0)
+    if (!_navMesh)
     {
-        printf("ERROR: INavMesh::getPathDistance: Could not find path.\n");
-        return -1.0f;
+        for (int i = 0; i < count; ++i)
+        {
+            results[i].Status = PathStatus::NO_NAVMESH;
+            results[i].Waypoints.clear();
+            results[i].Flags.clear();
+            results[i].Polys.clear();
+            results[i].Distance = -1.0f;
+        }
+        return 0;
     }
 
-    // Convert polygon path to actual waypoints using findStraightPath
-    const int MAX_STRAIGHT_PATH = 256;
-    float straightPath[MAX_STRAIGHT_PATH * 3];
-    unsigned char straightPathFlags[MAX_STRAIGHT_PATH];
-    dtPolyRef straightPathPolys[MAX_STRAIGHT_PATH];
-    int straightPathCount = 0;
+    // Requests are handed out in small chunks to keep the threads balanced
+    const int CHUNK_SIZE = 16;
+    const int chunkCount = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
 
-    status = _navQuery->findStraightPath(
-        startNearest, endNearest,
-        polys, polyCount,
-        straightPath, straightPathFlags, straightPathPolys,
-        &straightPathCount, MAX_STRAIGHT_PATH,
-        DT_STRAIGHTPATH_AREA_CROSSINGS
-    );
+    const int maxThreads = CWorkerPool::resolveThreadCount(_queryThreadCount);
+    const int threadCount = std::min(maxThreads, chunkCount);
 
-    if (dtStatusFailed(status) || straightPathCount == 0)
+    // The threads and their contexts are kept for the next batch; the
+    // calling thread is worker 0
+    if (maxThreads == 1)
+        _queryWorkers.reset();
+    else if (!_queryWorkers || _queryWorkers->getThreadCount() != maxThreads - 1)
+        _queryWorkers.reset(new CWorkerPool(maxThreads - 1));
+
+    while ((int)_queryPool.size() < threadCount)
     {
-        printf("ERROR: INavMesh::getPathDistance: Could not create straight path.\n");
-        return -1.0f;
+        std::unique_ptr<CNavQueryContext> query = createQueryContext();
+        if (!query)
+            break;
+        _queryPool.push_back(std::move(query));
     }
+    const int workerCount = std::min(threadCount, (int)_queryPool.size());
+    if (workerCount < 1)
+        return 0;
 
-    // Calculate total distance by summing distances between consecutive waypoints
-    float totalDistance = 0.0f;
-    for (int i = 0; i < straightPathCount - 1; ++i)
+    std::atomic<int> nextChunk(0);
+    std::atomic<int> found(0);
+
+    auto worker = [&](int index)
     {
-        float dx = straightPath[(i + 1) * 3 + 0] - straightPath[i * 3 + 0];
-        float dy = straightPath[(i + 1) * 3 + 1] - straightPath[i * 3 + 1];
-        float dz = straightPath[(i + 1) * 3 + 2] - straightPath[i * 3 + 2];
+        CNavQueryContext& query = *_queryPool[index];
+        int foundLocal = 0;
+        for (;;)
+        {
+            const int chunk = nextChunk++;
+            if (chunk >= chunkCount)
+                break;
+
+            const int end = std::min(count, (chunk + 1) * CHUNK_SIZE);
+            for (int i = chunk * CHUNK_SIZE; i < end; ++i)
+            {
+                const PathStatus status = query.findPath(requests[i].Start, requests[i].End, results[i]);
+                if (status == PathStatus::SUCCESS || status == PathStatus::PARTIAL)
+                    ++foundLocal;
+            }
+        }
+        found += foundLocal;
+    };
 
-        float segmentDistance = sqrtf(dx * dx + dy * dy + dz * dz);
-        totalDistance += segmentDistance;
-    }
+    if (workerCount == 1 || !_queryWorkers)
+        worker(0);
+    else
+        _queryWorkers->run(workerCount, worker);
 
-    return totalDistance;
+    return found;
 }
 
 void irr::scene::INavMesh::RemoveAgent(int agentId)
@@ -477,25 +1130,36 @@ void irr::scene::INavMesh::RemoveAgent(int agentId)
         return;
     }
 
-    if (agentId < 0 || agentId >= MAX_AGENTS)
+    if (agentId < 0 || agentId >= _crowd->getAgentCount())
     {
         printf("ERROR: INavMesh::removeAgent: Invalid agent ID: %d\n", agentId);
         return;
     }
 
-    // Check if agent exists in our map
-    auto it = _agentNodeMap.find(agentId);
-    if (it == _agentNodeMap.end())
+    // Check if agent exists in our table
+    if (!_agents.contains(agentId))
     {
-        printf("WARNING: INavMesh::removeAgent: Agent ID %d not found in map.\n", agentId);
+        printf("WARNING: INavMesh::removeAgent: Agent ID %d not found in table.\n", agentId);
+        return;
+    }
+
+    // Remove from our tracking table
+    _agents.remove(agentId);
+    if (_threadedCrowd)
+        _removedStateIds.push_back(agentId);
+
+    if (_crowdStepRunning)
+    {
+        AgentCommand command;
+        command.Kind = AgentCommand::REMOVE;
+        command.AgentId = agentId;
+        _crowdCommands.push_back(command);
         return;
     }
 
     // Remove from Detour crowd
     _crowd->removeAgent(agentId);
-
-    // Remove from our tracking map
-    _agentNodeMap.erase(it);
+    _flowAgents.erase(agentId);
 }
 
 irr::core::vector3df irr::scene::INavMesh::GetAgentVelocity(int agentId)
@@ -506,21 +1170,21 @@ irr::core::vector3df irr::scene::INavMesh::GetAgentVelocity(int agentId)
         return irr::core::vector3df(0, 0, 0);
     }
 
-    if (agentId < 0 || agentId >= MAX_AGENTS)
+    if (agentId < 0 || agentId >= _crowd->getAgentCount())
     {
         printf("ERROR: INavMesh::getAgentVelocity: Invalid agent ID: %d\n", agentId);
         return irr::core::vector3df(0, 0, 0);
     }
 
-    const dtCrowdAgent* agent = _crowd->getAgent(agentId);
-    if (!agent || !agent->active)
+    AgentState state;
+    if (!_getAgentState(agentId, state))
     {
         printf("WARNING: INavMesh::getAgentVelocity: Agent %d not found or inactive.\n", agentId);
         return irr::core::vector3df(0, 0, 0);
     }
 
     // Return the actual velocity (nvel) being applied to the agent
-    return irr::core::vector3df(agent->nvel[0], agent->nvel[1], agent->nvel[2]);
+    return irr::core::vector3df(state.Vel[0], state.Vel[1], state.Vel[2]);
 }
 
 irr::core::vector3df irr::scene::INavMesh::GetAgentCurrentTarget(int agentId)
@@ -531,28 +1195,25 @@ irr::core::vector3df irr::scene::INavMesh::GetAgentCurrentTarget(int agentId)
         return irr::core::vector3df(0, 0, 0);
     }
 
-    if (agentId < 0 || agentId >= MAX_AGENTS)
+    if (agentId < 0 || agentId >= _crowd->getAgentCount())
     {
         printf("ERROR: INavMesh::getAgentCurrentTarget: Invalid agent ID: %d\n", agentId);
         return irr::core::vector3df(0, 0, 0);
     }
 
-    const dtCrowdAgent* agent = _crowd->getAgent(agentId);
-    if (!agent || !agent->active)
+    AgentState state;
+    if (!_getAgentState(agentId, state))
     {
         printf("WARNING: INavMesh::getAgentCurrentTarget: Agent %d not found or inactive.\n", agentId);
         return irr::core::vector3df(0, 0, 0);
     }
 
-    // Check if agent has a target
-    if (agent->targetState == DT_CROWDAGENT_TARGET_NONE ||
-        agent->targetState == DT_CROWDAGENT_TARGET_FAILED)
-    {
+    // Check if agent has a target (flow field agents head for their goal)
+    if (!state.HasTarget)
         return irr::core::vector3df(0, 0, 0);
-    }
 
     // Return the target position
-    return irr::core::vector3df(agent->targetPos[0], agent->targetPos[1], agent->targetPos[2]);
+    return irr::core::vector3df(state.Target[0], state.Target[1], state.Target[2]);
 }
 
 bool irr::scene::INavMesh::HasAgentReachedDestination(int agentId)
@@ -563,29 +1224,725 @@ bool irr::scene::INavMesh::HasAgentReachedDestination(int agentId)
         return false;
     }
 
-    if (agentId < 0 || agentId >= MAX_AGENTS)
+    if (agentId < 0 || agentId >= _crowd->getAgentCount())
     {
         printf("ERROR: INavMesh::hasAgentReachedDestination: Invalid agent ID: %d\n", agentId);
         return false;
     }
 
-    const dtCrowdAgent* agent = _crowd->getAgent(agentId);
-    if (!agent || !agent->active)
+    AgentState state;
+    if (!_getAgentState(agentId, state))
     {
         printf("WARNING: INavMesh::hasAgentReachedDestination: Agent %d not found or inactive.\n", agentId);
         return false;
     }
 
-    // Agent has reached destination if:
-    // 1. Target state is DT_CROWDAGENT_TARGET_VALID and ncorners is 0 (no more path corners)
-    // 2. Or target state is DT_CROWDAGENT_TARGET_REACHED
-    if (agent->targetState == DT_CROWDAGENT_TARGET_VALID && agent->ncorners == 0)
+    // See _captureAgentState(); flow field agents report their own arrival
+    return state.Reached;
+}
+
+
+// --- Serialization ---
+
+bool irr::scene::INavMesh::save(const char* path) const
+{
+    if (!_navMesh || !path)
+    {
+        printf("ERROR: INavMesh::save: No navmesh has been built.\n");
+        return false;
+    }
+
+    const dtNavMesh* navMesh = _navMesh.get();
+
+    // Written next to the target and renamed over it, see replaceFile()
+    const std::string tempPath = std::string(path) + ".tmp";
+    FILE* fp = fopen(tempPath.c_str(), "wb");
+    if (!fp)
+    {
+        printf("ERROR: INavMesh::save: Could not open '%s' for writing.\n", tempPath.c_str());
+        return false;
+    }
+
+    NavMeshFileHeader header{};
+    header.magic = NAVMESH_FILE_MAGIC;
+    header.version = NAVMESH_FILE_VERSION;
+    header.tileCount = 0;
+    header.buildParams = _params;
+    memcpy(&header.meshParams, navMesh->getParams(), sizeof(dtNavMeshParams));
+
+    const TileGrid grid = _getTileGrid();
+    header.tileSize = grid.TileSize;
+    header.tilesW = grid.TilesW;
+    header.tilesH = grid.TilesH;
+    dtVcopy(header.buildBMin, grid.BMin);
+    dtVcopy(header.buildBMax, grid.BMax);
+
+    for (int i = 0; i < navMesh->getMaxTiles(); ++i)
+    {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (tile && tile->header && tile->dataSize > 0)
+            header.tileCount++;
+    }
+
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+
+    for (int i = 0; ok && i < navMesh->getMaxTiles(); ++i)
+    {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (!tile || !tile->header || tile->dataSize <= 0)
+            continue;
+
+        NavMeshFileTileHeader tileHeader{};
+        tileHeader.tileRef = navMesh->getTileRef(tile);
+        tileHeader.dataSize = tile->dataSize;
+
+        ok = fwrite(&tileHeader, sizeof(tileHeader), 1, fp) == 1 &&
+             fwrite(tile->data, tile->dataSize, 1, fp) == 1;
+    }
+
+    ok = fclose(fp) == 0 && ok;
+
+    if (!ok)
+    {
+        printf("ERROR: INavMesh::save: Could not write '%s'.\n", tempPath.c_str());
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    if (!replaceFile(tempPath.c_str(), path))
+    {
+        printf("ERROR: INavMesh::save: Could not replace '%s'.\n", path);
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    printf("INavMesh::save: Wrote %d tiles to '%s'.\n", header.tileCount, path);
+    return true;
+}
+
+bool irr::scene::INavMesh::load(const char* path)
+{
+    if (!path)
+        return false;
+
+    const auto loadStart = std::chrono::steady_clock::now();
+
+    FILE* fp = fopen(path, "rb");
+    if (!fp)
+    {
+        printf("ERROR: INavMesh::load: Could not open '%s'.\n", path);
+        return false;
+    }
+
+    NavMeshFileHeader header;
+    std::unique_ptr<dtNavMesh, DetourNavMeshDeleter> navMesh;
+    if (fread(&header, sizeof(header), 1, fp) != 1 || !checkFileHeader(header, path) ||
+        !initLoadMesh(navMesh, header.meshParams, "load"))
+    {
+        fclose(fp);
+        return false;
+    }
+
+    // Everything is read into navMesh first; the current navmesh is only
+    // replaced once every tile is in
+    irr::core::aabbox3df box;
+    int added = 0;
+    for (int i = 0; i < header.tileCount; ++i)
+    {
+        NavMeshFileTileHeader tileHeader;
+        if (fread(&tileHeader, sizeof(tileHeader), 1, fp) != 1 || tileHeader.dataSize <= 0)
+        {
+            printf("ERROR: INavMesh::load: Tile %d of '%s' is corrupt.\n", i, path);
+            fclose(fp);
+            return false;
+        }
+
+        unsigned char* data = (unsigned char*)dtAlloc(tileHeader.dataSize, DT_ALLOC_PERM);
+        if (!data || fread(data, tileHeader.dataSize, 1, fp) != 1)
+        {
+            printf("ERROR: INavMesh::load: Could not read tile %d of '%s'.\n", i, path);
+            dtFree(data);
+            fclose(fp);
+            return false;
+        }
+
+        if (dtStatusFailed(navMesh->addTile(data, tileHeader.dataSize, DT_TILE_FREE_DATA, tileHeader.tileRef, nullptr)))
+        {
+            printf("ERROR: INavMesh::load: Could not add tile %d of '%s'.\n", i, path);
+            dtFree(data);
+            fclose(fp);
+            return false;
+        }
+
+        _addTileToBox(data, added == 0, box);
+        added++;
+    }
+
+    fclose(fp);
+
+    if (!_commitLoad(std::move(navMesh), nullptr, header.buildParams, getFileTileGrid<TileGrid>(header), box))
+    {
+        return false;
+    }
+
+    const float loadTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    printf("INavMesh::load: Loaded %d tiles from '%s' in %.2f ms.\n", added, path, loadTimeMs);
+    return true;
+}
+
+bool irr::scene::INavMesh::loadMapped(const char* path)
+{
+    if (!path)
+        return false;
+
+    const auto loadStart = std::chrono::steady_clock::now();
+
+    std::unique_ptr<CMappedFile> file(new CMappedFile());
+    if (!file->open(path))
+    {
+        printf("ERROR: INavMesh::loadMapped: Could not map '%s'.\n", path);
+        return false;
+    }
+
+    const unsigned char* end = file->data() + file->size();
+    unsigned char* cursor = file->data();
+
+    if (file->size() < sizeof(NavMeshFileHeader))
     {
+        printf("ERROR: INavMesh::loadMapped: '%s' is too short.\n", path);
+        return false;
+    }
+
+    NavMeshFileHeader header;
+    memcpy(&header, cursor, sizeof(header));
+    cursor += sizeof(header);
+
+    std::unique_ptr<dtNavMesh, DetourNavMeshDeleter> navMesh;
+    if (!checkFileHeader(header, path) || !initLoadMesh(navMesh, header.meshParams, "loadMapped"))
+    {
+        return false;
+    }
+
+    // As in load(), the current navmesh stays until every tile is in
+    irr::core::aabbox3df box;
+    int added = 0;
+    for (int i = 0; i < header.tileCount; ++i)
+    {
+        NavMeshFileTileHeader tileHeader;
+        if ((size_t)(end - cursor) < sizeof(tileHeader))
+        {
+            printf("ERROR: INavMesh::loadMapped: Tile %d of '%s' is corrupt.\n", i, path);
+            return false;
+        }
+        memcpy(&tileHeader, cursor, sizeof(tileHeader));
+        cursor += sizeof(tileHeader);
+
+        // Detour reads the tile in place, so it must fit and be 4-byte aligned
+        if (tileHeader.dataSize <= 0 || (size_t)(end - cursor) < (size_t)tileHeader.dataSize ||
+            ((size_t)(cursor - file->data()) & 3) != 0)
+        {
+            printf("ERROR: INavMesh::loadMapped: Tile %d of '%s' is corrupt.\n", i, path);
+            return false;
+        }
+
+        unsigned char* data = cursor;
+        cursor += tileHeader.dataSize;
+
+        // No DT_TILE_FREE_DATA: the tile memory belongs to the mapping
+        if (dtStatusFailed(navMesh->addTile(data, tileHeader.dataSize, 0, tileHeader.tileRef, nullptr)))
+        {
+            printf("ERROR: INavMesh::loadMapped: Could not add tile %d of '%s'.\n", i, path);
+            return false;
+        }
+
+        _addTileToBox(data, added == 0, box);
+        added++;
+    }
+
+    // The mapping is kept alive for as long as the navmesh uses it
+    if (!_commitLoad(std::move(navMesh), std::move(file), header.buildParams, getFileTileGrid<TileGrid>(header), box))
+    {
+        return false;
+    }
+
+    const float loadTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    printf("INavMesh::loadMapped: Mapped %d tiles from '%s' in %.2f ms.\n", added, path, loadTimeMs);
+    return true;
+}
+
+bool irr::scene::INavMesh::_commitLoad(
+    std::unique_ptr<dtNavMesh, DetourNavMeshDeleter> navMesh,
+    std::unique_ptr<CMappedFile> mappedFile,
+    const NavMeshParams& buildParams,
+    const TileGrid& grid,
+    const irr::core::aabbox3df& box)
+{
+    // Drop the current navmesh and any build data that belongs to it
+    _resetDetour();
+    _clearBuildData();
+
+    _params = buildParams;
+    _buildReport = NavMeshBuildReport();
+    _defaultAgentRadius = _params.AgentRadius;
+    _defaultAgentHeight = _params.AgentHeight;
+    _setTileGrid(grid);
+
+    _mappedFile = std::move(mappedFile);
+    _navMesh = std::move(navMesh);
+    _box = box;
+
+    if (!_initQueryAndCrowd())
+    {
+        return false;
+    }
+
+    _fillBuildReport(nullptr);
+    return true;
+}
+
+void irr::scene::INavMesh::_addTileToBox(const unsigned char* tileData, bool firstTile, irr::core::aabbox3df& box)
+{
+    const dtMeshHeader* tileHeader = (const dtMeshHeader*)tileData;
+    irr::core::vector3df tileMin(tileHeader->bmin[0], tileHeader->bmin[1], tileHeader->bmin[2]);
+    irr::core::vector3df tileMax(tileHeader->bmax[0], tileHeader->bmax[1], tileHeader->bmax[2]);
+
+    if (firstTile)
+        box.reset(tileMin);
+    else
+        box.addInternalPoint(tileMin);
+    box.addInternalPoint(tileMax);
+}
+
+void irr::scene::INavMesh::_fillBuildReport(const CNavMeshBuildContext* ctx)
+{
+    if (ctx)
+    {
+        auto ms = [ctx](rcTimerLabel label)
+        {
+            const int us = ctx->getAccumulatedTime(label);
+            return us > 0 ? us / 1000.0f : 0.0f;
+        };
+
+        _buildReport.TotalMs = ms(RC_TIMER_TOTAL);
+        _buildReport.RasterizeMs = ms(RC_TIMER_RASTERIZE_TRIANGLES);
+        _buildReport.FilterMs = ms(RC_TIMER_FILTER_LOW_OBSTACLES) + ms(RC_TIMER_FILTER_BORDER) + ms(RC_TIMER_FILTER_WALKABLE);
+        _buildReport.CompactMs = ms(RC_TIMER_BUILD_COMPACTHEIGHTFIELD);
+        _buildReport.ErodeMs = ms(RC_TIMER_ERODE_AREA);
+        _buildReport.RegionsMs = ms(RC_TIMER_BUILD_DISTANCEFIELD) + ms(RC_TIMER_BUILD_REGIONS);
+        _buildReport.LayersMs = ms(RC_TIMER_BUILD_LAYERS);
+        _buildReport.ContoursMs = ms(RC_TIMER_BUILD_CONTOURS);
+        _buildReport.PolyMeshMs = ms(RC_TIMER_BUILD_POLYMESH);
+        _buildReport.DetailMeshMs = ms(RC_TIMER_BUILD_POLYMESHDETAIL);
+        _buildReport.PeakMemoryBytes = ctx->getPeakMemory();
+    }
+
+    _buildReport.TileCount = 0;
+    _buildReport.PolyCount = 0;
+    _buildReport.VertCount = 0;
+
+    if (!_navMesh)
+        return;
+
+    const dtNavMesh* navMesh = _navMesh.get();
+    for (int i = 0; i < navMesh->getMaxTiles(); ++i)
+    {
+        const dtMeshTile* tile = navMesh->getTile(i);
+        if (!tile || !tile->header)
+            continue;
+
+        _buildReport.TileCount++;
+        _buildReport.PolyCount += tile->header->polyCount;
+        _buildReport.VertCount += tile->header->vertCount;
+    }
+}
+
+void irr::scene::INavMesh::_resetDetour()
+{
+    _finishCrowdStep();
+
+    // The crowd and queries reference the navmesh, so they go first
+    _crowd.reset();
+    _query.reset();
+    _queryPool.clear();
+    _queryWorkers.reset();
+    _crowdQuery.reset();
+    _pathScheduler->setQuery(nullptr);
+    _pathCache.clear();
+    _islands.clear();
+    _navMesh.reset();
+    _mappedFile.reset();
+    _agents.clear();
+    _flowFields.clear();
+    _flowAgents.clear();
+    _agentStates[0].clear();
+    _agentStates[1].clear();
+    _stepAgentIds.clear();
+    _removedStateIds.clear();
+    _hasStepResult = false;
+}
+
+bool irr::scene::INavMesh::_initQueryAndCrowd()
+{
+    if (!_navMesh)
+    {
+        printf("ERROR: INavMesh::_initQueryAndCrowd: NavMesh is null.\n");
+        return false;
+    }
+
+    _query.reset(new CNavQueryContext(_navMesh.get()));
+    _query->setPathCache(&_pathCache);
+    _query->setIslands(&_islands);
+    if (!_query->isValid())
+    {
+        printf("ERROR: INavMesh::_initQueryAndCrowd: Could not init Detour navmesh query.\n");
+        return false;
+    }
+
+    _crowd.reset(new CShardedCrowd());
+    if (!_crowd->init(_crowdParams, _params.AgentRadius, _navMesh.get()))
+    {
+        printf("ERROR: INavMesh::_initQueryAndCrowd: Could not init crowd.\n");
+        _crowd.reset();
+        return false;
+    }
+
+    // Agents stay off islands removed by setMinIslandSize()
+    _crowd->setExcludeFlags((unsigned short)PolyFlags::DISABLED);
+
+    _updateIslands();
+    return true;
+}
+
+// --- Background Builds ---
+
+std::shared_future<bool> irr::scene::INavMesh::_startPendingBuild(INavMesh* builder, std::function<bool()> job)
+{
+    if (_pendingBuild.valid())
+    {
+        printf("ERROR: INavMesh::buildAsync: A background build is already running.\n");
+        if (builder)
+            builder->drop();
+        return std::shared_future<bool>();
+    }
+
+    _pendingBuilder.reset(builder);
+    _pendingBuild = std::async(std::launch::async, std::move(job)).share();
+    return _pendingBuild;
+}
+
+bool irr::scene::INavMesh::applyPendingBuild()
+{
+    if (!_pendingBuild.valid() ||
+        _pendingBuild.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        return false;
+    }
+
+    // The crowd and its agents are read below
+    _finishCrowdStep();
+
+    const bool built = _pendingBuild.get();
+    _pendingBuild = std::shared_future<bool>();
+    std::unique_ptr<irr::scene::ISceneNode, SceneNodeDropDeleter> builderNode = std::move(_pendingBuilder);
+
+    if (!built)
+    {
+        printf("ERROR: INavMesh::applyPendingBuild: Background build failed. Keeping the current navmesh.\n");
+        return false;
+    }
+
+    INavMesh& builder = *static_cast<INavMesh*>(builderNode.get());
+
+    // Remember the agents so they can be re-added to the new crowd
+    struct SavedAgent
+    {
+        int id;
+        irr::scene::ISceneNode* node;
+        dtCrowdAgentParams params;
+        float pos[3];
+        unsigned char targetState;
+        float target[3];
+    };
+    std::vector<SavedAgent> agents;
+
+    if (_crowd)
+    {
+        for (int i = 0; i < _agents.size(); ++i)
+        {
+            const int id = _agents.getAgentId(i);
+            const dtCrowdAgent* agent = _crowd->getAgent(id);
+            if (!agent || !agent->active)
+                continue;
+
+            SavedAgent saved;
+            saved.id = id;
+            saved.node = _agents.getNodeAt(i);
+            saved.params = agent->params;
+            dtVcopy(saved.pos, agent->npos);
+            saved.targetState = agent->targetState;
+            dtVcopy(saved.target, agent->targetPos);
+            agents.push_back(saved);
+        }
+    }
+
+    // The table is unordered, but restoring ids below needs them ascending
+    std::sort(agents.begin(), agents.end(), [](const SavedAgent& a, const SavedAgent& b) { return a.id < b.id; });
+
+    // Flow field goals are snapped again on the new navmesh
+    std::map<int, FlowAgent> flowAgents = std::move(_flowAgents);
+
+    // Swap the Detour objects in one go
+    _resetDetour();
+    _clearBuildData();
+
+    _navMesh = std::move(builder._navMesh);
+    _query = std::move(builder._query);
+    _query->setPathCache(&_pathCache);
+    // The builder labeled the navmesh it hands over
+    _islands = std::move(builder._islands);
+    _query->setIslands(&_islands);
+    _crowd = std::move(builder._crowd);
+    _params = builder._params;
+    _buildReport = std::move(builder._buildReport);
+    _defaultAgentRadius = builder._defaultAgentRadius;
+    _defaultAgentHeight = builder._defaultAgentHeight;
+    _box = builder._box;
+
+    _adoptBuild(builder);
+
+    if (!_crowd)
         return true;
+
+    // The crowd hands out the lowest free index, so adding the agents in id order
+    // (with placeholders for the gaps) gives every agent its old id back.
+    std::vector<int> placeholders;
+    int nextId = 0;
+    for (const SavedAgent& saved : agents)
+    {
+        while (nextId < saved.id)
+        {
+            const int placeholder = _crowd->addAgent(saved.pos, &saved.params);
+            if (placeholder < 0)
+                break;
+            placeholders.push_back(placeholder);
+            nextId = placeholder + 1;
+        }
+
+        const int id = _crowd->addAgent(saved.pos, &saved.params);
+        if (id != saved.id)
+        {
+            printf("WARNING: INavMesh::applyPendingBuild: Could not restore agent %d.\n", saved.id);
+            if (id >= 0)
+                _crowd->removeAgent(id);
+            continue;
+        }
+        nextId = id + 1;
+        _agents.add(id, saved.node, saved.params.height / 2.0f);
+
+        auto flow = flowAgents.find(id);
+        if (flow != flowAgents.end())
+        {
+            setAgentFlowTarget(id, flow->second.GoalPos);
+        }
+        else if (saved.targetState == DT_CROWDAGENT_TARGET_VELOCITY)
+        {
+            _crowd->requestMoveVelocity(id, saved.target);
+        }
+        else if (saved.targetState != DT_CROWDAGENT_TARGET_NONE)
+        {
+            setAgentTarget(id, irr::core::vector3df(saved.target[0], saved.target[1], saved.target[2]));
+        }
     }
 
-    // Note: DT_CROWDAGENT_TARGET_REACHED might not exist in all Detour versions
-    // In that case, the above check (ncorners == 0) is sufficient
+    for (int placeholder : placeholders)
+    {
+        _crowd->removeAgent(placeholder);
+    }
+
+    return true;
+}
+
+// --- Area Tagging ---
+
+void irr::scene::INavMesh::setMeshBufferArea(irr::u32 bufferIndex, PolyAreas area)
+{
+    _bufferAreas[bufferIndex] = area;
+}
+
+void irr::scene::INavMesh::setMaterialArea(const irr::core::stringc& textureName, PolyAreas area)
+{
+    irr::core::stringc name = textureName;
+    name.make_lower();
+    _materialAreas.push_back(std::make_pair(name, area));
+}
+
+void irr::scene::INavMesh::clearAreaOverrides()
+{
+    _bufferAreas.clear();
+    _materialAreas.clear();
+}
+
+unsigned char irr::scene::INavMesh::_getMeshBufferAreaOverride(irr::u32 bufferIndex, irr::scene::IMeshBuffer* buffer) const
+{
+    // PolyAreas::GROUND is 0, which Recast treats as RC_NULL_AREA (not walkable).
+    // Ground is therefore tagged as RC_WALKABLE_AREA and converted back by _applyPolyAreaFlags.
+    auto toRecastArea = [](PolyAreas area) -> unsigned char
+    {
+        return area == PolyAreas::GROUND ? RC_WALKABLE_AREA : (unsigned char)area;
+    };
+
+    auto it = _bufferAreas.find(bufferIndex);
+    if (it != _bufferAreas.end())
+        return toRecastArea(it->second);
+
+    if (_materialAreas.empty() || !buffer)
+        return RC_NULL_AREA;
+
+    irr::video::ITexture* texture = buffer->getMaterial().getTexture(0);
+    if (!texture)
+        return RC_NULL_AREA;
+
+    irr::core::stringc texturePath = texture->getName().getPath();
+    texturePath.make_lower();
+
+    for (const auto& [name, area] : _materialAreas)
+    {
+        if (texturePath.find(name.c_str()) >= 0)
+            return toRecastArea(area);
+    }
+
+    return RC_NULL_AREA;
+}
+
+bool irr::scene::INavMesh::_getMeshBufferData(
+    irr::scene::IMeshSceneNode* node,
+    std::vector<float>& verts,
+    std::vector<int>& tris,
+    std::vector<unsigned char>& triAreaOverrides) const
+{
+    if (!node) return false;
+    irr::scene::IMesh* mesh = node->getMesh();
+    if (!mesh) return false;
+
+    irr::core::matrix4 transform = node->getAbsoluteTransformation();
+    verts.clear();
+    tris.clear();
+    triAreaOverrides.clear();
+
+    irr::u32 vertexOffset = 0;
+
+    for (irr::u32 i = 0; i < mesh->getMeshBufferCount(); ++i)
+    {
+        irr::scene::IMeshBuffer* buffer = mesh->getMeshBuffer(i);
+        irr::u32 currentVertCount = buffer->getVertexCount();
+        irr::u32 currentIdxCount = buffer->getIndexCount();
+
+        if (currentVertCount == 0 || currentIdxCount == 0)
+        {
+            continue;
+        }
+
+        // Add vertices
+        verts.reserve(verts.size() + currentVertCount * 3);
+        for (irr::u32 j = 0; j < currentVertCount; ++j)
+        {
+            irr::core::vector3df pos = buffer->getPosition(j);
+            transform.transformVect(pos);
+            verts.push_back(pos.X);
+            verts.push_back(pos.Y);
+            verts.push_back(pos.Z);
+        }
 
-    return false;
+        // Add triangles (indices)
+        tris.reserve(tris.size() + currentIdxCount);
+        const irr::u16* indices16 = buffer->getIndices();
+        const irr::u32* indices32 = (const irr::u32*)indices16;
+
+        if (buffer->getIndexType() == irr::video::EIT_16BIT)
+        {
+            for (irr::u32 j = 0; j < currentIdxCount; ++j)
+            {
+                tris.push_back(indices16[j] + vertexOffset);
+            }
+        }
+        else // EIT_32BIT
+        {
+            for (irr::u32 j = 0; j < currentIdxCount; ++j)
+            {
+                tris.push_back(indices32[j] + vertexOffset);
+            }
+        }
+
+        // Area override for every triangle of this buffer
+        triAreaOverrides.resize(tris.size() / 3, _getMeshBufferAreaOverride(i, buffer));
+
+        vertexOffset += currentVertCount;
+    }
+
+    if (verts.empty() || tris.empty())
+    {
+        printf("WARNING: INavMesh::_getMeshBufferData: No vertices or triangles found.\n");
+        return false;
+    }
+
+    printf("_getMeshBufferData: Total vertices=%u\n", vertexOffset);
+    printf("_getMeshBufferData: Total triangles=%zu\n", tris.size() / 3);
+    return true;
+}
+
+void irr::scene::INavMesh::_markTriangleAreas(
+    rcContext* ctx, const float walkableSlopeAngle,
+    const std::vector<float>& verts,
+    const std::vector<int>& tris,
+    const std::vector<unsigned char>& triAreaOverrides,
+    std::vector<unsigned char>& triAreasOut)
+{
+    const int nverts = (int)verts.size() / 3;
+    const int ntris = (int)tris.size() / 3;
+
+    triAreasOut.assign(ntris, RC_NULL_AREA);
+    rcMarkWalkableTriangles(ctx, walkableSlopeAngle, verts.data(), nverts, tris.data(), ntris, triAreasOut.data());
+
+    if (triAreaOverrides.size() != (size_t)ntris)
+        return;
+
+    for (int i = 0; i < ntris; ++i)
+    {
+        // Only walkable triangles are re-tagged; slope still decides walkability.
+        if (triAreasOut[i] != RC_NULL_AREA && triAreaOverrides[i] != RC_NULL_AREA)
+            triAreasOut[i] = triAreaOverrides[i];
+    }
+}
+
+void irr::scene::INavMesh::_applyPolyAreaFlags(rcPolyMesh& pmesh)
+{
+    _applyPolyAreaFlags(pmesh.areas, pmesh.flags, pmesh.npolys);
+}
+
+void irr::scene::INavMesh::_applyPolyAreaFlags(unsigned char* areas, unsigned short* flags, const int npolys)
+{
+    for (int i = 0; i < npolys; ++i)
+    {
+        if (areas[i] == RC_WALKABLE_AREA)
+            areas[i] = (unsigned char)PolyAreas::GROUND;
+
+        if (areas[i] == (unsigned char)PolyAreas::GROUND ||
+            areas[i] == (unsigned char)PolyAreas::GRASS ||
+            areas[i] == (unsigned char)PolyAreas::ROAD)
+        {
+            flags[i] = (unsigned short)PolyFlags::WALK;
+        }
+        else if (areas[i] == (unsigned char)PolyAreas::WATER)
+        {
+            flags[i] = (unsigned short)PolyFlags::SWIM;
+        }
+        else if (areas[i] == (unsigned char)PolyAreas::DOOR)
+        {
+            flags[i] = (unsigned short)PolyFlags::WALK | (unsigned short)PolyFlags::DOOR;
+        }
+        else if (areas[i] == (unsigned char)PolyAreas::JUMP)
+        {
+            flags[i] = (unsigned short)PolyFlags::WALK | (unsigned short)PolyFlags::JUMP;
+        }
+    }
 }